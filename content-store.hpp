@@ -0,0 +1,307 @@
+#ifndef CONTENT_STORE_HPP
+#define CONTENT_STORE_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include "tree-map.hpp"
+#include "tree-queue.hpp"
+#include "tree-heap.hpp"
+
+// -------------------------
+// Configuration Parameters
+// -------------------------
+constexpr size_t CS_CHUNK_SIZE = 2048;     // Payload bytes per chunk
+constexpr size_t CS_MAX_CHUNKS = 5;        // 10 KiB covers the 8800-byte NDN Data limit
+constexpr size_t CS_CHUNK_HEADER = 4;      // Total content length, little-endian uint32
+constexpr size_t CS_MAX_CONTENT = CS_CHUNK_SIZE * CS_MAX_CHUNKS;
+
+// Which entry an insert into a full store replaces.
+enum class CsReplacement { Fifo, Lru };
+
+// -------------------------
+// Chunk Format
+// -------------------------
+// Content is stored as exactly CS_MAX_CHUNKS chunks, each a
+// CS_CHUNK_HEADER + CS_CHUNK_SIZE byte plaintext: the header carries the
+// total content length and the body carries the chunk's slice of the
+// content, zero-padded. Every chunk therefore encrypts to the same
+// ciphertext length whatever the content size, and trailing chunks past the
+// content are pure padding.
+
+// Key of chunk `index` of a content name (an NDN segment component).
+inline std::string content_chunk_key(const std::string& name, size_t index) {
+    return name + "/seg=" + std::to_string(index);
+}
+
+// Key of a name's recency heap handle (LRU replacement only).
+inline std::string content_ref_key(const std::string& name) {
+    return name + "/lru";
+}
+
+inline std::string encode_heap_ref(const HeapRef& ref) {
+    std::string out(2 * sizeof(uint64_t), '\0');
+    uint64_t leaf = ref.leaf;
+    std::memcpy(&out[0], &ref.id, sizeof(uint64_t));
+    std::memcpy(&out[sizeof(uint64_t)], &leaf, sizeof(uint64_t));
+    return out;
+}
+
+inline bool decode_heap_ref(const std::string& in, HeapRef& ref) {
+    if (in.size() != 2 * sizeof(uint64_t)) return false;
+    uint64_t leaf;
+    std::memcpy(&ref.id, &in[0], sizeof(uint64_t));
+    std::memcpy(&leaf, &in[sizeof(uint64_t)], sizeof(uint64_t));
+    ref.leaf = static_cast<size_t>(leaf);
+    return true;
+}
+
+inline std::string encode_content_chunk(const std::string& data, size_t index) {
+    std::string chunk(CS_CHUNK_HEADER + CS_CHUNK_SIZE, '\0');
+    uint32_t length = static_cast<uint32_t>(data.size());
+    for (size_t i = 0; i < CS_CHUNK_HEADER; i++) {
+        chunk[i] = static_cast<char>((length >> (8 * i)) & 0xff);
+    }
+    size_t offset = index * CS_CHUNK_SIZE;
+    if (offset < data.size()) {
+        data.copy(&chunk[CS_CHUNK_HEADER], std::min(CS_CHUNK_SIZE, data.size() - offset), offset);
+    }
+    return chunk;
+}
+
+inline uint32_t content_chunk_length(const std::string& chunk) {
+    uint32_t length = 0;
+    for (size_t i = 0; i < CS_CHUNK_HEADER; i++) {
+        length |= static_cast<uint32_t>(static_cast<unsigned char>(chunk[i])) << (8 * i);
+    }
+    return length;
+}
+
+// Reassembles content from its chunks. Returns false if any chunk is
+// missing, malformed or disagrees with the others on the content length.
+inline bool decode_content_chunks(const std::vector<std::string>& chunks,
+                                  const std::vector<bool>& found, std::string& data) {
+    if (chunks.size() != CS_MAX_CHUNKS || !found[0] || chunks[0].size() != CS_CHUNK_HEADER + CS_CHUNK_SIZE)
+        return false;
+    uint32_t length = content_chunk_length(chunks[0]);
+    if (length > CS_MAX_CONTENT) return false;
+
+    data.clear();
+    data.reserve(length);
+    for (size_t i = 0; i * CS_CHUNK_SIZE < length; i++) {
+        if (!found[i] || chunks[i].size() != CS_CHUNK_HEADER + CS_CHUNK_SIZE ||
+            content_chunk_length(chunks[i]) != length)
+            return false;
+        data.append(chunks[i], CS_CHUNK_HEADER, std::min<size_t>(CS_CHUNK_SIZE, length - i * CS_CHUNK_SIZE));
+    }
+    return true;
+}
+
+// -------------------------
+// ObliviousContentStore (name-indexed NDN Content Store)
+// -------------------------
+// Content is kept in an ObliviousMap as CS_MAX_CHUNKS fixed-size chunks
+// keyed by content name and segment, so a lookup by name is one padded
+// batch access and serves a hit in place. Replacement is FIFO over
+// insertions, tracked by an ObliviousQueue of names, or LRU, tracked by an
+// ObliviousHeap of names keyed by access tick.
+//
+// Every insert performs the same fixed sequence: one map access to store
+// chunk 0, one batch access storing the remaining chunks, one queue push,
+// and, once the store holds `capacity` names, one queue pop followed by
+// CS_MAX_CHUNKS map removals. Re-inserting a cached name does a dummy push
+// and, when full, a dummy pop followed by removals of absent keys, so the
+// queue holds and the count covers live names only. The access pattern
+// therefore reveals neither whether the name was new nor which entry, if
+// any, was replaced.
+//
+// Under LRU each name also keeps its heap handle in the index. An insert
+// or a hit adds a heap entry with a new tick, swaps it for the old handle
+// in one map update and removes the old heap entry; a miss performs a
+// dummy heap insert, a map update that writes nothing and a dummy heap
+// remove. Every insert then removes either the heap minimum and its
+// chunks (when there are more names than `capacity`) or a dummy handle
+// and absent keys, so LRU keeps the same fixed sequences as FIFO.
+class ObliviousContentStore {
+private:
+    ObliviousMap<std::string, std::string> index;   // name -> payload
+    ObliviousQueue<std::string> order;              // insertion order of names
+    std::unique_ptr<ObliviousHeap<std::string>> recency;   // names by last access (LRU only)
+    CsReplacement policy;
+    size_t capacity;
+    size_t records;                                  // live names in `order`
+    uint64_t tick;                                   // LRU access clock
+    std::mutex mtx;                                  // orders the compound insert (and LRU lookup)
+
+    // Removes every chunk of `name` and, under LRU, its heap handle.
+    void remove_entry(const std::string& name) {
+        for (size_t i = 0; i < CS_MAX_CHUNKS; i++) {
+            index.oblivious_remove(content_chunk_key(name, i));
+        }
+        if (recency) index.oblivious_remove(content_ref_key(name));
+    }
+
+    // Moves `name` to the newest end of the recency heap when `live`, or
+    // performs the same accesses without changing anything.
+    void touch_lru(const std::string& name, bool live) {
+        HeapRef fresh{0, 0};
+        if (live) {
+            fresh = recency->oblivious_insert(tick++, name);
+        } else {
+            recency->oblivious_dummy_insert();
+        }
+        HeapRef old = recency->dummy_ref();
+        index.oblivious_update(content_ref_key(name), [&](std::string& value, bool exists) {
+            if (exists) decode_heap_ref(value, old);
+            if (live) value = encode_heap_ref(fresh);
+            return live;
+        });
+        if (!live) old = recency->dummy_ref();
+        recency->oblivious_remove(old);
+    }
+
+    std::string victim_lru() {
+        std::string victim;
+        if (recency->size() > capacity) {
+            uint64_t priority;
+            recency->oblivious_extract_min(priority, victim);
+        } else {
+            recency->oblivious_remove(recency->dummy_ref());
+        }
+        return victim;
+    }
+
+    // Reads all CS_MAX_CHUNKS chunks of `name` in one batch and reassembles them.
+    bool read_content(const std::string& name, std::string& data) {
+        std::vector<std::string> keys;
+        keys.reserve(CS_MAX_CHUNKS);
+        for (size_t i = 0; i < CS_MAX_CHUNKS; i++) {
+            keys.push_back(content_chunk_key(name, i));
+        }
+
+        std::vector<std::string> chunks;
+        std::vector<bool> found;
+        index.oblivious_lookup_batch(keys, chunks, found);
+        return decode_content_chunks(chunks, found, data);
+    }
+
+public:
+    // A capacity of 0 fills the index tree to half its slots.
+    ObliviousContentStore(int height = QUEUE_TREE_HEIGHT_DEFAULT,
+                          size_t stash_limit = QUEUE_STASH_LIMIT_DEFAULT,
+                          int bucket_capacity = QUEUE_BUCKET_CAPACITY_DEFAULT,
+                          size_t max_entries = 0,
+                          EvictionMode mode = EvictionMode::Heuristic,
+                          CsReplacement replacement = CsReplacement::Fifo)
+      : index(height, stash_limit, bucket_capacity, mode),
+        order(height, stash_limit, bucket_capacity, mode),
+        policy(replacement), records(0), tick(0)
+    {
+        size_t slots = ((static_cast<size_t>(1) << (height + 1)) - 1) * bucket_capacity;
+        size_t perEntry = CS_MAX_CHUNKS + (policy == CsReplacement::Lru ? 1 : 0);
+        capacity = max_entries ? max_entries : slots / (2 * perEntry);
+        if (capacity == 0)
+            throw std::invalid_argument("ObliviousContentStore needs a non-zero capacity");
+        if (capacity * perEntry > slots)
+            throw std::invalid_argument("ObliviousContentStore capacity exceeds the index tree");
+        if (policy == CsReplacement::Lru)
+            recency.reset(new ObliviousHeap<std::string>(height, stash_limit));
+    }
+
+    // Caches content under its name, replacing the oldest (FIFO) or least
+    // recently used (LRU) entry when full.
+    // Content longer than CS_MAX_CONTENT is rejected.
+    void oblivious_insert(const std::string& name, const std::string& data) {
+        if (data.size() > CS_MAX_CONTENT)
+            throw std::invalid_argument("Content exceeds CS_MAX_CONTENT");
+
+        std::lock_guard<std::mutex> lock(mtx);
+
+        std::string head = encode_content_chunk(data, 0);
+        bool cached = index.oblivious_update(content_chunk_key(name, 0), [&head](std::string& chunk, bool) {
+            chunk = head;
+            return true;
+        });
+
+        std::vector<std::pair<std::string, std::string>> rest;
+        rest.reserve(CS_MAX_CHUNKS - 1);
+        for (size_t i = 1; i < CS_MAX_CHUNKS; i++) {
+            rest.emplace_back(content_chunk_key(name, i), encode_content_chunk(data, i));
+        }
+        index.oblivious_insert_batch(rest);
+
+        if (policy == CsReplacement::Lru) {
+            touch_lru(name, true);
+            remove_entry(victim_lru());
+            return;
+        }
+
+        bool full = (records == capacity);
+        if (cached) {
+            order.oblivious_dummy_push();
+        } else {
+            order.oblivious_push(name);
+            records++;
+        }
+
+        if (full) {
+            std::string victim;
+            if (cached) {
+                order.oblivious_dummy_pop();
+            } else {
+                order.oblivious_pop(victim);
+                records--;
+            }
+            remove_entry(victim);
+        }
+    }
+
+    // Looks content up by name: reads all CS_MAX_CHUNKS chunks in one batch
+    // and reassembles them. Under LRU a hit also refreshes the name.
+    bool oblivious_lookup(const std::string& name, std::string& data) {
+        if (policy == CsReplacement::Fifo) return read_content(name, data);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        bool hit = read_content(name, data);
+        touch_lru(name, hit);
+        return hit;
+    }
+
+    void trigger_full_eviction() {
+        index.trigger_full_eviction();
+        order.trigger_full_eviction();
+    }
+
+    // Statistics of the index and the replacement structures merged.
+    OramStats getStats() const {
+        OramStats total = index.getStats();
+        total.merge(order.getStats());
+        if (recency) total.merge(recency->getStats());
+        return total;
+    }
+
+    void resetStats() {
+        index.resetStats();
+        order.resetStats();
+        if (recency) recency->resetStats();
+    }
+
+    // Combined stash occupancy of the index and the replacement structures.
+    size_t getStashSize() const {
+        return index.getStashSize() + order.getStashSize() + (recency ? recency->getStashSize() : 0);
+    }
+    bool isUnderPressure() const {
+        return index.isUnderPressure() || order.isUnderPressure() || (recency && recency->isUnderPressure());
+    }
+    size_t getCapacity() const { return capacity; }
+};
+
+#endif
@@ -8,153 +8,351 @@
 #include <openssl/evp.h>
 #include <openssl/err.h>
 #include <cstring>
+#include <cstdint>
+#include <atomic>
+#include <fstream>
+#include <cstdio>
 
 // constants for AES-GCM mode.
 constexpr int AES_KEY_SIZE = 32;         // 256-bit key
 constexpr int AES_GCM_IV_SIZE = 12;        // Recommended size for GCM (12 bytes)
 constexpr int AES_GCM_TAG_SIZE = 16;       // Authentication tag size for GCM
+constexpr int SIPHASH_KEY_SIZE = 16;       // 128-bit key for keyed hashing
 
 // KeyManager:
-// Generates a static random key for demonstration
+// Holds the process AES and hashing keys. They are random per process
+// unless loadKeyFile() is called first, which makes ciphertexts (snapshots,
+// mapped trees) readable across restarts.
 
 class KeyManager {
 public:
     static const std::string& getKey() {
-        static std::string key = initializeKey();
-        return key;
+        State& s = state();
+        s.inUse.store(true, std::memory_order_relaxed);
+        return s.key;
+    }
+
+    // Separate key for keyed hashing (shard selection, hashed key ids).
+    static const std::string& getHashKey() {
+        State& s = state();
+        s.inUse.store(true, std::memory_order_relaxed);
+        return s.hashKey;
+    }
+
+    // IV prefix for this process (see CryptoEngine). Zero for random keys;
+    // with a key file it counts the loads, so a restart never repeats an IV
+    // under the same key.
+    static uint16_t keyEpoch() { return state().epoch; }
+
+    // Loads both keys from `path`, creating the file with fresh keys if it
+    // does not exist, and bumps its epoch. Must run before the first
+    // getKey()/getHashKey(), since engines and hashed ids bind the key they
+    // see first.
+    static void loadKeyFile(const std::string& path) {
+        State& s = state();
+        if (s.inUse.load(std::memory_order_relaxed))
+            throw std::runtime_error("KeyManager::loadKeyFile called after the keys were used");
+
+        unsigned char buf[KEY_FILE_SIZE];
+        std::ifstream in(path, std::ios::binary);
+        if (in) {
+            if (!in.read(reinterpret_cast<char*>(buf), KEY_FILE_SIZE))
+                throw std::runtime_error("Key file is truncated: " + path);
+            s.key.assign(reinterpret_cast<char*>(buf), AES_KEY_SIZE);
+            s.hashKey.assign(reinterpret_cast<char*>(buf) + AES_KEY_SIZE, SIPHASH_KEY_SIZE);
+            uint16_t epoch = static_cast<uint16_t>(buf[KEY_FILE_SIZE - 2] | (buf[KEY_FILE_SIZE - 1] << 8));
+            if (epoch == UINT16_MAX)
+                throw std::runtime_error("Key file epochs exhausted, rotate the keys: " + path);
+            s.epoch = static_cast<uint16_t>(epoch + 1);
+        } else {
+            s.key = initializeKey(AES_KEY_SIZE);
+            s.hashKey = initializeKey(SIPHASH_KEY_SIZE);
+            s.epoch = 1;
+        }
+
+        std::memcpy(buf, s.key.data(), AES_KEY_SIZE);
+        std::memcpy(buf + AES_KEY_SIZE, s.hashKey.data(), SIPHASH_KEY_SIZE);
+        buf[KEY_FILE_SIZE - 2] = static_cast<unsigned char>(s.epoch & 0xff);
+        buf[KEY_FILE_SIZE - 1] = static_cast<unsigned char>(s.epoch >> 8);
+        // Write-then-rename, so a crash never leaves a half-written key file
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out.write(reinterpret_cast<char*>(buf), KEY_FILE_SIZE) || !out.flush())
+                throw std::runtime_error("Cannot write key file: " + tmp);
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0)
+            throw std::runtime_error("Cannot replace key file: " + path);
     }
 private:
-    static std::string initializeKey() {
+    static constexpr size_t KEY_FILE_SIZE = AES_KEY_SIZE + SIPHASH_KEY_SIZE + 2;
+
+    struct State {
+        std::string key;
+        std::string hashKey;
+        uint16_t epoch;
+        std::atomic<bool> inUse;
+    };
+
+    static State& state() {
+        static State s{initializeKey(AES_KEY_SIZE), initializeKey(SIPHASH_KEY_SIZE), 0, {false}};
+        return s;
+    }
+
+    static std::string initializeKey(int size) {
         unsigned char buf[AES_KEY_SIZE];
-        if (RAND_bytes(buf, AES_KEY_SIZE) != 1)
+        if (RAND_bytes(buf, size) != 1)
             throw std::runtime_error("RAND_bytes failed in KeyManager");
         // Using std::string to store binary key data.
-        return std::string(reinterpret_cast<char*>(buf), AES_KEY_SIZE);
+        return std::string(reinterpret_cast<char*>(buf), size);
     }
 };
 
-// secure_encrypt_string:
-// Encrypts a plaintext string using AES-256-GCM which provides both confidentiality and integrity.
-// Output format: [IV (12 bytes)] || [ciphertext] || [tag (16 bytes)]
-inline std::string secure_encrypt_string(const std::string& plaintext) {
-    const std::string& key = KeyManager::getKey();
-    unsigned char iv[AES_GCM_IV_SIZE];
-    if (RAND_bytes(iv, AES_GCM_IV_SIZE) != 1)
-        throw std::runtime_error("RAND_bytes failed in secure_encrypt_string (IV generation)");
-
-    // Create and initialize the context.
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx)
-        throw std::runtime_error("EVP_CIPHER_CTX_new failed in secure_encrypt_string");
-
-    // Initialize encryption context with AES-256-GCM.
-    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), NULL, NULL, NULL) != 1)
-        throw std::runtime_error("EVP_EncryptInit_ex failed in secure_encrypt_string");
-
-    // Initialize key and IV.
-    if (EVP_EncryptInit_ex(ctx, NULL, NULL,
-                           reinterpret_cast<const unsigned char*>(key.data()), iv) != 1)
-        throw std::runtime_error("EVP_EncryptInit_ex (key/IV) failed in secure_encrypt_string");
-
-    // Encrypt the plaintext.
-    std::vector<unsigned char> ciphertext(plaintext.size() + AES_GCM_TAG_SIZE);
-    int len = 0;
-    if (EVP_EncryptUpdate(ctx, ciphertext.data(), &len,
-                          reinterpret_cast<const unsigned char*>(plaintext.data()), plaintext.size()) != 1)
-    {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_EncryptUpdate failed in secure_encrypt_string");
-    }
-    int ciphertext_len = len;
-
-    // Finalize encryption.
-    if (EVP_EncryptFinal_ex(ctx, ciphertext.data() + len, &len) != 1)
-    {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_EncryptFinal_ex failed in secure_encrypt_string");
-    }
-    ciphertext_len += len;
-
-    // Retrieve the GCM authentication tag.
-    unsigned char tag[AES_GCM_TAG_SIZE];
-    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, AES_GCM_TAG_SIZE, tag) != 1)
-    {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_CIPHER_CTX_ctrl (get tag) failed in secure_encrypt_string");
-    }
-    EVP_CIPHER_CTX_free(ctx);
-
-    // Build output: IV || ciphertext || tag.
-    std::string output(reinterpret_cast<char*>(iv), AES_GCM_IV_SIZE);
-    output.append(reinterpret_cast<char*>(ciphertext.data()), ciphertext_len);
-    output.append(reinterpret_cast<char*>(tag), AES_GCM_TAG_SIZE);
+// siphash24_core:
+// SipHash-2-4 with a 16-byte key. Writes the 64-bit digest to out[0], or
+// with `wide` set the SipHash-2-4-128 digest to out[0] (low) and out[1].
+inline void siphash24_core(const void* data, size_t len, const unsigned char key[SIPHASH_KEY_SIZE],
+                           bool wide, uint64_t out[2]) {
+    auto rotl = [](uint64_t x, int b) { return (x << b) | (x >> (64 - b)); };
+    uint64_t k0, k1;
+    std::memcpy(&k0, key, 8);
+    std::memcpy(&k1, key + 8, 8);
+    uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ k1;
+    if (wide) v1 ^= 0xee;
+    auto round = [&]() {
+        v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+        v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+    };
 
-    return output;
+    const unsigned char* in = static_cast<const unsigned char*>(data);
+    size_t tail = len & 7;
+    const unsigned char* end = in + (len - tail);
+    for (; in != end; in += 8) {
+        uint64_t m;
+        std::memcpy(&m, in, 8);
+        v3 ^= m;
+        round(); round();
+        v0 ^= m;
+    }
+
+    uint64_t b = static_cast<uint64_t>(len) << 56;
+    for (size_t i = 0; i < tail; i++) {
+        b |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    v3 ^= b;
+    round(); round();
+    v0 ^= b;
+
+    v2 ^= wide ? 0xee : 0xff;
+    round(); round(); round(); round();
+    out[0] = v0 ^ v1 ^ v2 ^ v3;
+    if (wide) {
+        v1 ^= 0xdd;
+        round(); round(); round(); round();
+        out[1] = v0 ^ v1 ^ v2 ^ v3;
+    }
 }
 
-// secure_decrypt_string:
-// Decrypts the ciphertext using AES-256-GCM and verifies its authentication tag.
-// Expects the input format: [IV (12 bytes)] || [ciphertext] || [tag (16 bytes)].
-inline std::string secure_decrypt_string(const std::string& input) {
-    const std::string& key = KeyManager::getKey();
-    if (input.size() < AES_GCM_IV_SIZE + AES_GCM_TAG_SIZE)
-        throw std::runtime_error("Input too short in secure_decrypt_string");
+// siphash24:
+// SipHash-2-4 keyed PRF with a 16-byte key and 64-bit output. Fast enough to
+// run on every ORAM access; reveals nothing about the input without the key.
+inline uint64_t siphash24(const void* data, size_t len, const unsigned char key[SIPHASH_KEY_SIZE]) {
+    uint64_t out[2];
+    siphash24_core(data, len, key, false, out);
+    return out[0];
+}
 
-    size_t iv_offset = 0;
-    size_t ciphertext_offset = AES_GCM_IV_SIZE;
-    size_t tag_offset = input.size() - AES_GCM_TAG_SIZE;
-    size_t ciphertext_len = tag_offset - AES_GCM_IV_SIZE;
+// siphash24_128:
+// SipHash-2-4-128: same key, 128-bit output as (low, high).
+inline void siphash24_128(const void* data, size_t len, const unsigned char key[SIPHASH_KEY_SIZE],
+                          uint64_t& low, uint64_t& high) {
+    uint64_t out[2];
+    siphash24_core(data, len, key, true, out);
+    low = out[0];
+    high = out[1];
+}
 
-    const unsigned char* iv = reinterpret_cast<const unsigned char*>(input.data());
-    const unsigned char* ciphertext = reinterpret_cast<const unsigned char*>(input.data() + ciphertext_offset);
-    const unsigned char* tag = reinterpret_cast<const unsigned char*>(input.data() + tag_offset);
+// keyed_hash:
+// SipHash of a key under the process hash key.
+inline uint64_t keyed_hash(const std::string& key) {
+    return siphash24(key.data(), key.size(),
+                     reinterpret_cast<const unsigned char*>(KeyManager::getHashKey().data()));
+}
 
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx)
-        throw std::runtime_error("EVP_CIPHER_CTX_new failed in secure_decrypt_string");
+// CryptoEngine:
+// AES-256-GCM with contexts that are created and keyed once per thread.
+// Per-message work is limited to loading a new IV, so small FIB/PIT values
+// no longer pay for context allocation, cipher lookup and key expansion.
+//
+// IVs are [engine id (4 bytes)] || [message counter (8 bytes)]. Engine ids
+// come from a process-wide counter, so no two threads ever share an IV under
+// the process key. Under a key file the id is [key epoch (2 bytes)] ||
+// [counter (2 bytes)], so no two runs sharing the file do either.
+//
+// Output format: [IV (12 bytes)] || [ciphertext] || [tag (16 bytes)]
+class CryptoEngine {
+public:
+    static constexpr size_t OVERHEAD = AES_GCM_IV_SIZE + AES_GCM_TAG_SIZE;
 
-    // Initialize decryption context with AES-256-GCM.
-    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), NULL, NULL, NULL) != 1)
-    {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_DecryptInit_ex failed in secure_decrypt_string");
+    // Returns the calling thread's engine.
+    static CryptoEngine& local() {
+        thread_local CryptoEngine engine;
+        return engine;
     }
 
-    // Initialize key and IV.
-    if (EVP_DecryptInit_ex(ctx, NULL, NULL,
-                           reinterpret_cast<const unsigned char*>(key.data()), iv) != 1)
-    {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_DecryptInit_ex (key/IV) failed in secure_decrypt_string");
+    CryptoEngine(const CryptoEngine&) = delete;
+    CryptoEngine& operator=(const CryptoEngine&) = delete;
+
+    ~CryptoEngine() {
+        EVP_CIPHER_CTX_free(encCtx);
+        EVP_CIPHER_CTX_free(decCtx);
     }
 
-    // Decrypt the ciphertext.
-    std::vector<unsigned char> plaintext(ciphertext_len + AES_GCM_TAG_SIZE);
-    int len = 0;
-    if (EVP_DecryptUpdate(ctx, plaintext.data(), &len, ciphertext, ciphertext_len) != 1)
-    {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_DecryptUpdate failed in secure_decrypt_string");
+    // Encrypts `len` bytes into `out`, which must hold len + OVERHEAD bytes.
+    // Returns the number of bytes written.
+    size_t encrypt(const unsigned char* in, size_t len, unsigned char* out) {
+        unsigned char* iv = out;
+        next_iv(iv);
+
+        if (EVP_EncryptInit_ex(encCtx, NULL, NULL, NULL, iv) != 1)
+            throw std::runtime_error("EVP_EncryptInit_ex (IV) failed in CryptoEngine::encrypt");
+
+        int outLen = 0;
+        int total = 0;
+        if (EVP_EncryptUpdate(encCtx, out + AES_GCM_IV_SIZE, &outLen, in, static_cast<int>(len)) != 1)
+            throw std::runtime_error("EVP_EncryptUpdate failed in CryptoEngine::encrypt");
+        total = outLen;
+
+        if (EVP_EncryptFinal_ex(encCtx, out + AES_GCM_IV_SIZE + total, &outLen) != 1)
+            throw std::runtime_error("EVP_EncryptFinal_ex failed in CryptoEngine::encrypt");
+        total += outLen;
+
+        if (EVP_CIPHER_CTX_ctrl(encCtx, EVP_CTRL_GCM_GET_TAG, AES_GCM_TAG_SIZE,
+                                out + AES_GCM_IV_SIZE + total) != 1)
+            throw std::runtime_error("EVP_CIPHER_CTX_ctrl (get tag) failed in CryptoEngine::encrypt");
+
+        return AES_GCM_IV_SIZE + total + AES_GCM_TAG_SIZE;
     }
-    int plaintext_len = len;
 
-    // Set the expected GCM authentication tag.
-    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, AES_GCM_TAG_SIZE, const_cast<unsigned char*>(tag)) != 1)
-    {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("EVP_CIPHER_CTX_ctrl (set tag) failed in secure_decrypt_string");
+    // Decrypts and authenticates `len` bytes into `out`, which must hold
+    // len - OVERHEAD bytes. Returns the plaintext length.
+    size_t decrypt(const unsigned char* in, size_t len, unsigned char* out) {
+        if (len < OVERHEAD)
+            throw std::runtime_error("Input too short in CryptoEngine::decrypt");
+
+        const unsigned char* iv = in;
+        const unsigned char* ciphertext = in + AES_GCM_IV_SIZE;
+        size_t ciphertextLen = len - OVERHEAD;
+        const unsigned char* tag = in + len - AES_GCM_TAG_SIZE;
+
+        if (EVP_DecryptInit_ex(decCtx, NULL, NULL, NULL, iv) != 1)
+            throw std::runtime_error("EVP_DecryptInit_ex (IV) failed in CryptoEngine::decrypt");
+
+        int outLen = 0;
+        int total = 0;
+        if (EVP_DecryptUpdate(decCtx, out, &outLen, ciphertext, static_cast<int>(ciphertextLen)) != 1)
+            throw std::runtime_error("EVP_DecryptUpdate failed in CryptoEngine::decrypt");
+        total = outLen;
+
+        if (EVP_CIPHER_CTX_ctrl(decCtx, EVP_CTRL_GCM_SET_TAG, AES_GCM_TAG_SIZE,
+                                const_cast<unsigned char*>(tag)) != 1)
+            throw std::runtime_error("EVP_CIPHER_CTX_ctrl (set tag) failed in CryptoEngine::decrypt");
+
+        // If authentication fails, this will return <= 0.
+        if (EVP_DecryptFinal_ex(decCtx, out + total, &outLen) <= 0)
+            throw std::runtime_error("Decryption failed: Authentication tag verification failed in CryptoEngine::decrypt");
+        total += outLen;
+
+        return static_cast<size_t>(total);
     }
 
-    // Finalize decryption; if authentication fails, this will return <= 0.
-    if (EVP_DecryptFinal_ex(ctx, plaintext.data() + len, &len) <= 0)
-    {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("Decryption failed: Authentication tag verification failed in secure_decrypt_string");
+    // Encrypts into a caller-owned string, reusing its capacity.
+    void encrypt_into(const std::string& plaintext, std::string& out) {
+        out.resize(plaintext.size() + OVERHEAD);
+        size_t n = encrypt(reinterpret_cast<const unsigned char*>(plaintext.data()), plaintext.size(),
+                           reinterpret_cast<unsigned char*>(&out[0]));
+        out.resize(n);
     }
-    plaintext_len += len;
-    EVP_CIPHER_CTX_free(ctx);
 
-    return std::string(reinterpret_cast<char*>(plaintext.data()), plaintext_len);
+    // Decrypts into a caller-owned string, reusing its capacity.
+    void decrypt_into(const std::string& input, std::string& out) {
+        if (input.size() < OVERHEAD)
+            throw std::runtime_error("Input too short in CryptoEngine::decrypt_into");
+        out.resize(input.size() - OVERHEAD);
+        // GCM has no padding, but keep a writable byte for empty plaintexts.
+        unsigned char scratch;
+        unsigned char* dst = out.empty() ? &scratch : reinterpret_cast<unsigned char*>(&out[0]);
+        size_t n = decrypt(reinterpret_cast<const unsigned char*>(input.data()), input.size(), dst);
+        out.resize(n);
+    }
+
+private:
+    EVP_CIPHER_CTX* encCtx;
+    EVP_CIPHER_CTX* decCtx;
+    uint32_t engineId;
+    uint64_t counter;
+
+    CryptoEngine() : encCtx(nullptr), decCtx(nullptr), engineId(next_engine_id()), counter(0) {
+        const unsigned char* key = reinterpret_cast<const unsigned char*>(KeyManager::getKey().data());
+
+        encCtx = EVP_CIPHER_CTX_new();
+        decCtx = EVP_CIPHER_CTX_new();
+        if (!encCtx || !decCtx) {
+            EVP_CIPHER_CTX_free(encCtx);
+            EVP_CIPHER_CTX_free(decCtx);
+            throw std::runtime_error("EVP_CIPHER_CTX_new failed in CryptoEngine");
+        }
+
+        // Bind cipher and key once; each message only loads a fresh IV.
+        if (EVP_EncryptInit_ex(encCtx, EVP_aes_256_gcm(), NULL, key, NULL) != 1 ||
+            EVP_DecryptInit_ex(decCtx, EVP_aes_256_gcm(), NULL, key, NULL) != 1)
+        {
+            EVP_CIPHER_CTX_free(encCtx);
+            EVP_CIPHER_CTX_free(decCtx);
+            throw std::runtime_error("EVP_*Init_ex (key) failed in CryptoEngine");
+        }
+    }
+
+    static uint32_t next_engine_id() {
+        static std::atomic<uint32_t> nextId(0);
+        uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+        uint16_t epoch = KeyManager::keyEpoch();
+        if (epoch == 0) return id;
+        if (id > UINT16_MAX)
+            throw std::runtime_error("CryptoEngine ids exhausted for this key epoch");
+        return (static_cast<uint32_t>(epoch) << 16) | id;
+    }
+
+    void next_iv(unsigned char* iv) {
+        if (counter == UINT64_MAX)
+            throw std::runtime_error("CryptoEngine IV counter exhausted");
+        uint64_t c = counter++;
+        std::memcpy(iv, &engineId, sizeof(engineId));
+        std::memcpy(iv + sizeof(engineId), &c, sizeof(c));
+    }
+};
+
+// secure_encrypt_string:
+// Encrypts a plaintext string using AES-256-GCM which provides both confidentiality and integrity.
+// Output format: [IV (12 bytes)] || [ciphertext] || [tag (16 bytes)]
+inline std::string secure_encrypt_string(const std::string& plaintext) {
+    std::string output;
+    CryptoEngine::local().encrypt_into(plaintext, output);
+    return output;
+}
+
+// secure_decrypt_string:
+// Decrypts the ciphertext using AES-256-GCM and verifies its authentication tag.
+// Expects the input format: [IV (12 bytes)] || [ciphertext] || [tag (16 bytes)].
+inline std::string secure_decrypt_string(const std::string& input) {
+    std::string output;
+    CryptoEngine::local().decrypt_into(input, output);
+    return output;
 }
 
 #endif 
@@ -0,0 +1,201 @@
+#ifndef DEFERRED_RETRIEVAL_HPP
+#define DEFERRED_RETRIEVAL_HPP
+
+#include <vector>
+#include <deque>
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <mutex>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+
+#include "secure-random.hpp"
+#include "oram-metrics.hpp"
+
+// -------------------------
+// Configuration Parameters
+// -------------------------
+constexpr size_t DEFERRED_ROUND_SIZE_DEFAULT = 8;     // Interests per released round, dummies included
+constexpr size_t DEFERRED_MIN_DELAY_DEFAULT = 1;      // Ticks an interest is held at least
+constexpr size_t DEFERRED_MAX_DELAY_DEFAULT = 8;      // Ticks an interest is held at most
+
+// -------------------------
+// TimerWheel
+// -------------------------
+// Single-level timer wheel with one slot per tick. schedule(item, d) files
+// the item d ticks ahead (d < ticks); advance() hands over the items of the
+// current slot and moves on by one tick. Both are O(1) per item, whatever
+// the number of pending timers. Not thread-safe.
+template<typename T>
+class TimerWheel {
+private:
+    std::vector<std::vector<T>> slots;
+    size_t cursor;
+    size_t pending;
+
+public:
+    explicit TimerWheel(size_t ticks) : slots(ticks), cursor(0), pending(0) {
+        if (ticks == 0) throw std::invalid_argument("Timer wheel needs at least one slot");
+    }
+
+    // Due on the advance() `delay` calls after the next (0 = the next one).
+    void schedule(T item, size_t delay) {
+        if (delay >= slots.size()) throw std::invalid_argument("Timer delay beyond the wheel horizon");
+        slots[(cursor + delay) % slots.size()].push_back(std::move(item));
+        pending++;
+    }
+
+    // Calls due(item) for every item in the current slot, then advances.
+    template<typename Fn>
+    void advance(Fn&& due) {
+        std::vector<T>& slot = slots[cursor];
+        pending -= slot.size();
+        for (T& item : slot) due(std::move(item));
+        slot.clear();
+        cursor = (cursor + 1) % slots.size();
+    }
+
+    size_t size() const { return pending; }
+    size_t horizon() const { return slots.size(); }
+};
+
+// -------------------------
+// DeferredRetrieval
+// -------------------------
+// Holds each submitted item for a uniformly random delay in
+// [minDelay, maxDelay] ticks (drawn with secure_random), then releases
+// items in rounds of exactly roundSize: one round per tick, real items
+// first and padded with dummies from the caller's factory. When more items
+// fall due than a round holds, the rest wait for the next tick, so the
+// release rate is shaped to one fixed-size round per tick regardless of
+// arrivals. The delay hides when an item arrived; the caller hands each
+// round to a batched ORAM operation, so the wait is paid once per round
+// instead of once per packet.
+//
+// Knobs: roundSize trades dummy overhead against queueing at peak rate;
+// the delay window trades latency for timing privacy; the tick interval
+// (the caller's) sets the release rate. With padIdle a tick with nothing
+// due still releases a full round of dummies, keeping the rate constant.
+// submit() and tick() may be called from different threads.
+struct DeferredRetrievalConfig {
+    size_t roundSize = DEFERRED_ROUND_SIZE_DEFAULT;
+    size_t minDelay = DEFERRED_MIN_DELAY_DEFAULT;
+    size_t maxDelay = DEFERRED_MAX_DELAY_DEFAULT;
+    bool padIdle = true;
+};
+
+struct DeferredRetrievalStats {
+    uint64_t submitted = 0;
+    uint64_t released = 0;    // real items handed out
+    uint64_t dummies = 0;     // padding items handed out
+    uint64_t rounds = 0;
+    HdrHistogram holdTicks;   // submit-to-release, in ticks
+    HdrHistogram holdNs;      // submit-to-release, wall clock
+};
+
+template<typename T>
+class DeferredRetrieval {
+private:
+    struct Held {
+        T item;
+        uint64_t submitTick;
+        std::chrono::steady_clock::time_point submitTime;
+    };
+
+    DeferredRetrievalConfig config;
+    TimerWheel<Held> wheel;
+    std::deque<Held> ready;        // due, waiting for room in a round
+    uint64_t now;                  // ticks so far
+    DeferredRetrievalStats stats;
+    mutable std::mutex mtx;
+
+    // Moves up to roundSize ready items into `round` and pads it.
+    template<typename DummyFn>
+    size_t fill_round(std::vector<T>& round, DummyFn& makeDummy) {
+        round.clear();
+        auto releaseTime = std::chrono::steady_clock::now();
+        while (!ready.empty() && round.size() < config.roundSize) {
+            Held& held = ready.front();
+            stats.holdTicks.record(now - held.submitTick);
+            stats.holdNs.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                releaseTime - held.submitTime).count()));
+            round.push_back(std::move(held.item));
+            ready.pop_front();
+        }
+        size_t real = round.size();
+        while (round.size() < config.roundSize) round.push_back(makeDummy());
+        stats.released += real;
+        stats.dummies += round.size() - real;
+        stats.rounds++;
+        return real;
+    }
+
+public:
+    explicit DeferredRetrieval(const DeferredRetrievalConfig& cfg = DeferredRetrievalConfig())
+      : config(cfg), wheel(std::max<size_t>(cfg.maxDelay, 1)), now(0) {
+        if (cfg.roundSize == 0) throw std::invalid_argument("Deferred retrieval round size must be positive");
+        if (cfg.minDelay == 0) throw std::invalid_argument("Deferred retrieval minDelay must be at least one tick");
+        if (cfg.minDelay > cfg.maxDelay) throw std::invalid_argument("Deferred retrieval minDelay > maxDelay");
+    }
+
+    void submit(T item) {
+        std::lock_guard<std::mutex> lock(mtx);
+        // Due on the delay-th tick from now
+        size_t delay = config.minDelay + secure_random_index(config.maxDelay - config.minDelay + 1);
+        wheel.schedule(Held{std::move(item), now, std::chrono::steady_clock::now()}, delay - 1);
+        stats.submitted++;
+    }
+
+    // Advances one tick and releases at most one round into `round`.
+    // Returns the number of real items at the front of the round; the
+    // round is left empty (and 0 returned) only on an idle tick without
+    // padIdle.
+    template<typename DummyFn>
+    size_t tick(std::vector<T>& round, DummyFn makeDummy) {
+        std::lock_guard<std::mutex> lock(mtx);
+        wheel.advance([this](Held&& held) { ready.push_back(std::move(held)); });
+        now++;
+        if (ready.empty() && !config.padIdle) {
+            round.clear();
+            return 0;
+        }
+        return fill_round(round, makeDummy);
+    }
+
+    // Releases everything still held, ignoring the remaining delays, as
+    // padded rounds passed to release(round, real). For shutdown.
+    template<typename DummyFn, typename ReleaseFn>
+    void flush(DummyFn makeDummy, ReleaseFn release) {
+        std::vector<T> round;
+        while (true) {
+            size_t real;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                while (wheel.size() > 0) {
+                    wheel.advance([this](Held&& held) { ready.push_back(std::move(held)); });
+                    now++;
+                }
+                if (ready.empty()) return;
+                real = fill_round(round, makeDummy);
+            }
+            release(round, real);
+        }
+    }
+
+    // Items submitted but not yet released.
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return wheel.size() + ready.size();
+    }
+
+    DeferredRetrievalStats getStats() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats;
+    }
+
+    const DeferredRetrievalConfig& getConfig() const { return config; }
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef EVICTION_SCHEDULER_HPP
+#define EVICTION_SCHEDULER_HPP
+
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include <cstddef>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+
+// -------------------------
+// Configuration Parameters
+// -------------------------
+constexpr size_t EVICTION_SCHEDULER_THREADS_DEFAULT = 2;  // Workers shared by all ORAM structures
+constexpr double EVICTION_HIGH_WATERMARK = 0.5;           // Stash fraction that requests background eviction
+
+// -------------------------
+// EvictionClient
+// -------------------------
+// Implemented by structures that hand background eviction to the scheduler.
+// eviction_slice() does a bounded amount of work under the structure's own
+// lock and returns true if the structure is still above its watermark.
+class EvictionClient {
+public:
+    virtual ~EvictionClient() = default;
+    virtual bool eviction_slice() = 0;
+};
+
+// -------------------------
+// EvictionScheduler
+// -------------------------
+// A small worker pool with a FIFO run queue. Structures submit themselves
+// when their stash crosses the watermark; a worker runs one slice and puts
+// the client back at the tail if more work remains, so several structures
+// share the pool round-robin and nothing polls while stashes are low.
+class EvictionScheduler {
+private:
+    std::mutex mtx;
+    std::condition_variable workAvailable;
+    std::condition_variable sliceDone;
+    std::deque<EvictionClient*> runQueue;
+    std::unordered_set<EvictionClient*> queued;   // clients currently in runQueue
+    std::vector<EvictionClient*> running;         // client per worker, or nullptr
+    std::vector<std::thread> workers;
+    bool stopping;
+
+    void worker_loop(size_t id) {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            workAvailable.wait(lock, [this] { return stopping || !runQueue.empty(); });
+            if (stopping) return;
+
+            EvictionClient* client = runQueue.front();
+            runQueue.pop_front();
+            queued.erase(client);
+            running[id] = client;
+
+            lock.unlock();
+            bool more = client->eviction_slice();
+            lock.lock();
+
+            running[id] = nullptr;
+            if (more && queued.insert(client).second) {
+                runQueue.push_back(client);
+            }
+            sliceDone.notify_all();
+        }
+    }
+
+    void unlink(EvictionClient* client) {
+        if (queued.erase(client)) {
+            runQueue.erase(std::find(runQueue.begin(), runQueue.end(), client));
+        }
+    }
+
+public:
+    explicit EvictionScheduler(size_t numThreads = EVICTION_SCHEDULER_THREADS_DEFAULT)
+      : running(std::max<size_t>(1, numThreads), nullptr), stopping(false)
+    {
+        for (size_t i = 0; i < running.size(); i++) {
+            workers.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    ~EvictionScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    EvictionScheduler(const EvictionScheduler&) = delete;
+    EvictionScheduler& operator=(const EvictionScheduler&) = delete;
+
+    // Process-wide scheduler used by ObliviousMap and ObliviousQueue.
+    static EvictionScheduler& shared() {
+        static EvictionScheduler scheduler;
+        return scheduler;
+    }
+
+    // Queues a client for background eviction; a no-op if already queued.
+    // Safe to call while holding the client's own lock.
+    void submit(EvictionClient* client) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (stopping || !queued.insert(client).second) return;
+            runQueue.push_back(client);
+        }
+        workAvailable.notify_one();
+    }
+
+    // Removes a client and waits for any slice it is running to finish.
+    // Must be called before the client is destroyed, without its lock held.
+    void retire(EvictionClient* client) {
+        std::unique_lock<std::mutex> lock(mtx);
+        unlink(client);
+        sliceDone.wait(lock, [this, client] {
+            return std::find(running.begin(), running.end(), client) == running.end();
+        });
+        // A finishing slice may have re-queued the client; with nothing
+        // running it, unlinking now means no worker can pick it up again.
+        unlink(client);
+    }
+
+    // Number of clients waiting for a slice. Callers can treat a growing
+    // backlog as back-pressure and slow down admission.
+    size_t backlog() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return runQueue.size();
+    }
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef HASHED_NAME_HPP
+#define HASHED_NAME_HPP
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <type_traits>
+
+#include "crypto.hpp"
+
+// -------------------------
+// NameKey (fixed-width hashed NDN name)
+// -------------------------
+// SipHash-2-4-128 of a name under the process hash key. An ORAM keyed by
+// NameKey stores 16-byte trivially copyable keys instead of std::string
+// names: blocks no longer carry the name in the clear, moving a block
+// copies two words, and stash compares are integer compares. The name
+// itself travels inside the encrypted value (see HashedNameStore in
+// oram-engine.hpp), where it is checked on every read.
+struct NameKey {
+    uint64_t low;
+    uint64_t high;
+
+    bool operator==(const NameKey& other) const { return low == other.low && high == other.high; }
+    bool operator!=(const NameKey& other) const { return !(*this == other); }
+    bool operator<(const NameKey& other) const {
+        return high != other.high ? high < other.high : low < other.low;
+    }
+};
+
+static_assert(std::is_trivially_copyable<NameKey>::value, "NameKey must stay a POD");
+
+inline NameKey hash_name(const std::string& name) {
+    NameKey key;
+    siphash24_128(name.data(), name.size(),
+                  reinterpret_cast<const unsigned char*>(KeyManager::getHashKey().data()),
+                  key.low, key.high);
+    return key;
+}
+
+// The key is already a keyed PRF output, so shard and position-map
+// selectors use its bits directly.
+inline uint64_t keyed_hash(const NameKey& key) { return key.low; }
+
+inline std::ostream& operator<<(std::ostream& out, const NameKey& key) {
+    std::ios::fmtflags flags = out.flags();
+    char fill = out.fill('0');
+    out << std::hex << std::setw(16) << key.high << std::setw(16) << key.low;
+    out.fill(fill);
+    out.flags(flags);
+    return out;
+}
+
+namespace std {
+template<>
+struct hash<NameKey> {
+    size_t operator()(const NameKey& key) const { return static_cast<size_t>(key.low ^ key.high); }
+};
+}
+
+#endif
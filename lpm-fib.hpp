@@ -0,0 +1,162 @@
+#ifndef LPM_FIB_HPP
+#define LPM_FIB_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <stdexcept>
+
+#include "sharded-map.hpp"
+
+// -------------------------
+// Configuration Parameters
+// -------------------------
+constexpr size_t FIB_MAX_COMPONENTS = 8;   // Deepest route prefix; also ORAM accesses per lookup
+
+// -------------------------
+// Name Prefixes
+// -------------------------
+// The prefixes of an NDN name, shortest first, one per component:
+// "/a/b/c" -> "/a", "/a/b", "/a/b/c". At most FIB_MAX_COMPONENTS are
+// returned; a name that does not start with '/' has none.
+inline std::vector<std::string> name_prefixes(const std::string& name) {
+    std::vector<std::string> prefixes;
+    if (name.size() < 2 || name[0] != '/') return prefixes;
+    for (size_t pos = 1; pos <= name.size() && prefixes.size() < FIB_MAX_COMPONENTS; pos++) {
+        if (pos == name.size() || name[pos] == '/') {
+            if (name[pos - 1] != '/') prefixes.push_back(name.substr(0, pos));
+        }
+    }
+    return prefixes;
+}
+
+// Number of components in a route prefix ("/a/b" -> 2).
+inline size_t name_component_count(const std::string& name) {
+    size_t count = 0;
+    for (size_t pos = 1; pos <= name.size(); pos++) {
+        if ((pos == name.size() || name[pos] == '/') && name[pos - 1] != '/') count++;
+    }
+    return count;
+}
+
+// Padding key `index`: probe slots past the name's depth use 0 to
+// FIB_MAX_COMPONENTS - 1, per-shard batch padding the indices after. Routes
+// start with '/', so these are never present and each costs an ordinary
+// absent-key access.
+inline std::string fib_padding_key(size_t index) {
+    return std::string("\x01pad/") + std::to_string(index);
+}
+
+// -------------------------
+// ObliviousFib (longest-prefix match)
+// -------------------------
+// Longest-prefix-match FIB over a sharded ORAM keyed by route prefix. A
+// lookup probes every prefix length of the name in one batched lookup of
+// exactly FIB_MAX_COMPONENTS keys, padding with absent keys, and keeps the
+// longest hit. The number and kind of ORAM accesses are the same for a
+// one-component name, a deep name and a miss, so the match depth is not
+// revealed, and the batch lets the probes share path reads. Fixed probe
+// keys land on fixed shards, so with several shards every shard's sub-batch
+// is also padded to the whole batch size; otherwise the per-shard batch
+// sizes would give the depth away. Routes deeper than FIB_MAX_COMPONENTS
+// are rejected.
+class ObliviousFib {
+private:
+    ShardedObliviousMap<std::string, std::string> routes;
+
+    static void check_route(const std::string& prefix) {
+        if (prefix.size() < 2 || prefix[0] != '/')
+            throw std::invalid_argument("FIB route must be a name starting with '/': " + prefix);
+        if (name_component_count(prefix) > FIB_MAX_COMPONENTS)
+            throw std::invalid_argument("FIB route has more than FIB_MAX_COMPONENTS components: " + prefix);
+    }
+
+    // Appends the FIB_MAX_COMPONENTS probe keys of one name to `keys`.
+    static void append_probes(const std::string& name, std::vector<std::string>& keys) {
+        std::vector<std::string> prefixes = name_prefixes(name);
+        for (size_t i = 0; i < FIB_MAX_COMPONENTS; i++) {
+            keys.push_back(i < prefixes.size() ? std::move(prefixes[i]) : fib_padding_key(i));
+        }
+    }
+
+public:
+    ObliviousFib(int num_shards, int height, size_t stash_limit, int bucket_capacity,
+                 int cover_accesses = SHARD_COVER_ACCESSES_DEFAULT,
+                 EvictionMode mode = EvictionMode::Heuristic,
+                 OramEngine engine = OramEngine::Path,
+                 const MappedStorageConfig* storage = nullptr,
+                 bool hashed_keys = false,
+                 const AutotuneConfig* autotune = nullptr,
+                 PositionMapKind posmap = PositionMapKind::Hash)
+      : routes(num_shards, height, stash_limit, bucket_capacity, cover_accesses, mode, engine,
+               storage, hashed_keys, autotune, posmap) {}
+
+    void add_route(const std::string& prefix, const std::string& face) {
+        check_route(prefix);
+        routes.oblivious_insert(prefix, face);
+    }
+
+    bool remove_route(const std::string& prefix) {
+        check_route(prefix);
+        return routes.oblivious_remove(prefix);
+    }
+
+    // Initial routes, sorted by prefix (see ShardedObliviousMap::bulk_load).
+    void bulk_load(const std::vector<std::pair<std::string, std::string>>& entries) {
+        for (const auto& entry : entries) check_route(entry.first);
+        routes.bulk_load(entries);
+    }
+
+    // Face of the longest route that is a prefix of `name`.
+    bool lookup(const std::string& name, std::string& face) {
+        std::vector<std::string> faces;
+        std::vector<bool> routed;
+        bool found = lookup_batch({name}, faces, routed) > 0;
+        if (found) face = std::move(faces[0]);
+        return found;
+    }
+
+    // Longest-prefix match for several names in one batch of
+    // names.size() * FIB_MAX_COMPONENTS probes. faces[i] and routed[i]
+    // describe names[i]. Returns the number of names routed.
+    size_t lookup_batch(const std::vector<std::string>& names, std::vector<std::string>& faces,
+                        std::vector<bool>& routed) {
+        std::vector<std::string> keys;
+        keys.reserve(names.size() * FIB_MAX_COMPONENTS);
+        for (const auto& name : names) append_probes(name, keys);
+
+        std::vector<std::string> values;
+        std::vector<bool> found;
+        routes.oblivious_lookup_batch_padded(keys, values, found,
+            [](size_t j) { return fib_padding_key(FIB_MAX_COMPONENTS + j); });
+
+        faces.assign(names.size(), std::string());
+        routed.assign(names.size(), false);
+        size_t hits = 0;
+        for (size_t n = 0; n < names.size(); n++) {
+            // Every slot is visited; a longer hit overrides a shorter one
+            for (size_t i = 0; i < FIB_MAX_COMPONENTS; i++) {
+                size_t k = n * FIB_MAX_COMPONENTS + i;
+                if (found[k]) {
+                    faces[n].swap(values[k]);
+                    routed[n] = true;
+                }
+            }
+            if (routed[n]) hits++;
+        }
+        return hits;
+    }
+
+    size_t getStashSize() const { return routes.getStashSize(); }
+    size_t size() const { return routes.size(); }
+    int getTreeHeight() const { return routes.getTreeHeight(); }
+    OramStats getStats() const { return routes.getStats(); }
+    void resetStats() { routes.resetStats(); }
+    void trigger_full_eviction() { routes.trigger_full_eviction(); }
+    bool isUnderPressure() const { return routes.isUnderPressure(); }
+    void save_snapshot(std::ostream& out) { routes.save_snapshot(out); }
+    void load_snapshot(std::istream& in) { routes.load_snapshot(in); }
+};
+
+#endif
@@ -0,0 +1,412 @@
+#ifndef MAPPED_STORAGE_HPP
+#define MAPPED_STORAGE_HPP
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "crypto.hpp"
+#include "oram-storage.hpp"
+#include "tree-map.hpp"
+
+// -------------------------
+// Configuration Parameters
+// -------------------------
+constexpr int MAPPED_CACHE_LEVELS_DEFAULT = 6;        // Top levels kept in RAM
+constexpr size_t MAPPED_MAX_KEY_BYTES = 128;         // Longest key a slot can hold
+constexpr size_t MAPPED_MAX_VALUE_BYTES = 256;       // Longest value ciphertext a slot can hold
+constexpr size_t MAPPED_STASH_SLOTS_DEFAULT = 512;   // Stash blocks the file can keep across a restart
+constexpr uint64_t MAPPED_TREE_MAGIC = 0x32454552544d524fULL;  // "ORMTREE2"
+constexpr size_t MAPPED_HEADER_BYTES = 4096;
+
+// Where and how a mapped tree is stored.
+struct MappedStorageConfig {
+    std::string path;                          // backing file (created if missing)
+    int cacheLevels = MAPPED_CACHE_LEVELS_DEFAULT;
+    size_t maxKeyBytes = MAPPED_MAX_KEY_BYTES;
+    size_t maxValueBytes = MAPPED_MAX_VALUE_BYTES;
+    size_t stashSlots = MAPPED_STASH_SLOTS_DEFAULT;
+    bool reopen = false;                       // pick up a cleanly closed tree instead of clearing it
+};
+
+// -------------------------
+// MappedTree: file-backed ORAM bucket store
+// -------------------------
+// Drop-in replacement for FlatTree<MapSlot<string,string>> whose buckets
+// live in a memory-mapped file, so a tree can be far larger than RAM.
+//
+// File layout: a header page, one 64-bit slot mask per bucket,
+// numBuckets x Z fixed-size slot records in heap order, then `stashSlots`
+// records for the owning map's stash. Each record is one AES-GCM message
+// over [flags][leaf][key length][value length][key][value] padded to the
+// configured maximums, so every record has the same length and reveals
+// nothing about its block. Only the slot masks, the stash count and the
+// eviction epoch are stored in the clear; the masks carry the same
+// information as the write pattern.
+//
+// The top `cacheLevels` levels, which every path crosses, are held
+// unencrypted in an in-memory FlatTree and only written to the file by
+// close_clean(), which the owning map calls on destruction together with
+// its stash and eviction epoch. With `reopen` set, a file of the same
+// geometry that was closed that way is mapped again: the cached levels are
+// read back, and the map takes its stash and epoch from restore_stash()
+// and rebuilds its position map from the slots' leaves. Records are sealed
+// under the process key, so a restarting router loads its key file
+// (KeyManager::loadKeyFile) first. A file still open, or left behind by a
+// crash, is marked unclean and refused rather than read half-written.
+class MappedTree {
+private:
+    using Slot = MapSlot<std::string, std::string>;
+
+    struct Header {
+        uint64_t magic;
+        uint32_t height;
+        uint32_t capacity;
+        uint64_t maxKeyBytes;
+        uint64_t maxValueBytes;
+        uint64_t stashSlots;
+        uint64_t epoch;         // owner's eviction counter at close
+        uint64_t stashCount;    // stash records in use
+        uint64_t clean;         // 1 once close_clean() finished, 0 while open
+    };
+
+    int height;
+    int capacity;                   // Z: slots per bucket
+    int cacheLevels;
+    size_t numBuckets;
+    size_t cachedBuckets;           // buckets [1, cachedBuckets] live in `cache`
+    size_t maxKeyBytes;
+    size_t maxValueBytes;
+    size_t stashSlots;
+    size_t plainBytes;              // record plaintext length
+    size_t recordBytes;             // record length on disk
+    size_t fileBytes;
+    int fd;
+    unsigned char* base;            // start of the mapping
+    uint64_t* masks;                // per bucket slot mask (index 0 unused)
+    unsigned char* records;
+    unsigned char* stashRecords;
+    FlatTree<Slot> cache;
+    std::vector<unsigned char> plain;  // record scratch
+    size_t fileValid;               // valid slots outside the cache
+    bool wasReopened;
+
+    static constexpr size_t RECORD_PREFIX = 1 + 4 + 2 + 2;
+
+    unsigned char* record(size_t bucket, int slot) {
+        return records + ((bucket - 1) * static_cast<size_t>(capacity) + slot) * recordBytes;
+    }
+
+    bool cached(size_t bucket) const { return bucket <= cachedBuckets; }
+
+    Header* header() { return reinterpret_cast<Header*>(base); }
+
+    Header expected_header() const {
+        return Header{MAPPED_TREE_MAGIC, static_cast<uint32_t>(height), static_cast<uint32_t>(capacity),
+                      maxKeyBytes, maxValueBytes, stashSlots, 0, 0, 0};
+    }
+
+    void write_record(size_t bucket, int slot, size_t leaf, uint8_t slotFlags, const Slot& payload) {
+        write_record_at(record(bucket, slot), leaf, slotFlags, payload);
+    }
+
+    void write_record_at(unsigned char* out, size_t leaf, uint8_t slotFlags, const Slot& payload) {
+        if (payload.key.size() > maxKeyBytes || payload.value.size() > maxValueBytes)
+            throw std::invalid_argument("Block too large for a MappedTree slot");
+        std::memset(plain.data(), 0, plainBytes);
+        uint32_t leaf32 = static_cast<uint32_t>(leaf);
+        uint16_t keyLen = static_cast<uint16_t>(payload.key.size());
+        uint16_t valueLen = static_cast<uint16_t>(payload.value.size());
+        plain[0] = slotFlags;
+        std::memcpy(&plain[1], &leaf32, 4);
+        std::memcpy(&plain[5], &keyLen, 2);
+        std::memcpy(&plain[7], &valueLen, 2);
+        std::memcpy(&plain[RECORD_PREFIX], payload.key.data(), keyLen);
+        std::memcpy(&plain[RECORD_PREFIX + maxKeyBytes], payload.value.data(), valueLen);
+        CryptoEngine::local().encrypt(plain.data(), plainBytes, out);
+    }
+
+    // Decrypts a record; returns its leaf and flags and fills `payload`.
+    void read_record(size_t bucket, int slot, size_t& leaf, uint8_t& slotFlags, Slot& payload) {
+        read_record_at(record(bucket, slot), leaf, slotFlags, payload);
+    }
+
+    void read_record_at(const unsigned char* in, size_t& leaf, uint8_t& slotFlags, Slot& payload) {
+        CryptoEngine::local().decrypt(in, recordBytes, plain.data());
+        uint32_t leaf32;
+        uint16_t keyLen, valueLen;
+        std::memcpy(&leaf32, &plain[1], 4);
+        std::memcpy(&keyLen, &plain[5], 2);
+        std::memcpy(&valueLen, &plain[7], 2);
+        if (keyLen > maxKeyBytes || valueLen > maxValueBytes)
+            throw std::runtime_error("Corrupt MappedTree record");
+        slotFlags = plain[0];
+        leaf = leaf32;
+        payload.key.assign(reinterpret_cast<const char*>(&plain[RECORD_PREFIX]), keyLen);
+        payload.value.assign(reinterpret_cast<const char*>(&plain[RECORD_PREFIX + maxKeyBytes]), valueLen);
+        // Stash tags are not kept on disk; a block read from the file gets its tag back here
+        payload.tag = block_tag(payload.key);
+    }
+
+    // Opens the file, clearing it unless `reopen` finds a cleanly closed
+    // tree of the same geometry. An existing file that does not qualify is
+    // refused when reopening, so a wrong path never silently loses a tree.
+    void open_file(const std::string& path, bool reopen) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0600);
+        if (fd < 0) throw std::runtime_error("Cannot open MappedTree file " + path);
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat MappedTree file " + path);
+        }
+        bool existing = reopen && st.st_size != 0;
+        if (existing && static_cast<size_t>(st.st_size) != fileBytes) {
+            ::close(fd);
+            throw std::runtime_error("Cannot reopen MappedTree file " + path + ": size does not match");
+        }
+        if (!existing && (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(fileBytes)) != 0)) {
+            ::close(fd);
+            throw std::runtime_error("Cannot size MappedTree file " + path);
+        }
+
+        void* mapping = mmap(nullptr, fileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map MappedTree file " + path);
+        }
+        base = static_cast<unsigned char*>(mapping);
+        masks = reinterpret_cast<uint64_t*>(base + MAPPED_HEADER_BYTES);
+        records = base + MAPPED_HEADER_BYTES + (numBuckets + 1) * sizeof(uint64_t);
+        stashRecords = records + numBuckets * static_cast<size_t>(capacity) * recordBytes;
+
+        Header expected = expected_header();
+        if (existing) {
+            const Header& found = *header();
+            bool matches = found.magic == expected.magic && found.height == expected.height &&
+                           found.capacity == expected.capacity && found.maxKeyBytes == expected.maxKeyBytes &&
+                           found.maxValueBytes == expected.maxValueBytes && found.stashSlots == expected.stashSlots;
+            const char* problem = !matches ? "geometry does not match"
+                                : found.clean != 1 || found.stashCount > stashSlots ? "not closed cleanly"
+                                : nullptr;
+            if (problem) {
+                munmap(base, fileBytes);
+                ::close(fd);
+                base = nullptr;
+                throw std::runtime_error("Cannot reopen MappedTree file " + path + ": " + problem);
+            }
+            load_existing();
+            wasReopened = true;
+        } else {
+            std::memcpy(base, &expected, sizeof(expected));
+        }
+
+        // Unclean until close_clean(): a crash leaves a file reopen refuses
+        header()->clean = 0;
+        msync(base, MAPPED_HEADER_BYTES, MS_SYNC);
+    }
+
+    // Counts the file-resident blocks and pulls the cached levels into RAM.
+    void load_existing() {
+        for (size_t bucket = 1; bucket <= numBuckets; bucket++) {
+            if (!cached(bucket)) {
+                fileValid += __builtin_popcountll(masks[bucket]);
+                continue;
+            }
+            Slot payload;
+            size_t leaf;
+            uint8_t slotFlags;
+            for (int s = 0; s < capacity; s++) {
+                if (!(masks[bucket] >> s & 1)) continue;
+                read_record(bucket, s, leaf, slotFlags, payload);
+                cache.store(bucket, leaf, slotFlags & ~SLOT_VALID, std::move(payload));
+            }
+            masks[bucket] = 0;
+        }
+    }
+
+public:
+    MappedTree(int treeHeight, int bucketCapacity, const MappedStorageConfig& config)
+      : height(treeHeight), capacity(bucketCapacity),
+        cacheLevels(std::max(0, std::min(config.cacheLevels, treeHeight + 1))),
+        maxKeyBytes(config.maxKeyBytes), maxValueBytes(config.maxValueBytes), stashSlots(config.stashSlots),
+        fd(-1), base(nullptr), masks(nullptr), records(nullptr), stashRecords(nullptr),
+        cache(std::max(0, cacheLevels - 1), bucketCapacity), fileValid(0), wasReopened(false)
+    {
+        if (treeHeight < 0 || treeHeight > 31)
+            throw std::invalid_argument("MappedTree height must be in [0, 31]");
+        if (bucketCapacity <= 0 || bucketCapacity > 64)
+            throw std::invalid_argument("MappedTree bucket capacity must be in [1, 64]");
+        if (maxKeyBytes > UINT16_MAX || maxValueBytes > UINT16_MAX)
+            throw std::invalid_argument("MappedTree slot limits out of range");
+
+        numBuckets = (static_cast<size_t>(1) << (height + 1)) - 1;
+        cachedBuckets = (static_cast<size_t>(1) << cacheLevels) - 1;
+        plainBytes = RECORD_PREFIX + maxKeyBytes + maxValueBytes;
+        recordBytes = plainBytes + CryptoEngine::OVERHEAD;
+        fileBytes = MAPPED_HEADER_BYTES + (numBuckets + 1) * sizeof(uint64_t) +
+                    (numBuckets * static_cast<size_t>(capacity) + stashSlots) * recordBytes;
+        plain.resize(plainBytes);
+        open_file(config.path, config.reopen);
+    }
+
+    MappedTree(MappedTree&& other) noexcept
+      : height(other.height), capacity(other.capacity), cacheLevels(other.cacheLevels),
+        numBuckets(other.numBuckets), cachedBuckets(other.cachedBuckets),
+        maxKeyBytes(other.maxKeyBytes), maxValueBytes(other.maxValueBytes), stashSlots(other.stashSlots),
+        plainBytes(other.plainBytes), recordBytes(other.recordBytes), fileBytes(other.fileBytes),
+        fd(other.fd), base(other.base), masks(other.masks), records(other.records),
+        stashRecords(other.stashRecords), cache(std::move(other.cache)), plain(std::move(other.plain)),
+        fileValid(other.fileValid), wasReopened(other.wasReopened)
+    {
+        other.fd = -1;
+        other.base = nullptr;
+    }
+
+    MappedTree(const MappedTree&) = delete;
+    MappedTree& operator=(const MappedTree&) = delete;
+    MappedTree& operator=(MappedTree&&) = delete;
+
+    // Unmaps the file. Without close_clean() it stays marked unclean, so
+    // the cached levels are not written: nothing could read them back.
+    ~MappedTree() {
+        if (!base) return;
+        munmap(base, fileBytes);
+        ::close(fd);
+    }
+
+    // True when the constructor picked up an existing tree (see `reopen`).
+    bool reopened() const { return wasReopened; }
+
+    // Stash blocks close_clean() can keep.
+    size_t stash_capacity() const { return stashSlots; }
+
+    // On a reopened tree, hands the stash saved by close_clean() to
+    // sink(leaf, flags, Slot&&) and returns the saved eviction epoch.
+    template<typename Sink>
+    uint64_t restore_stash(Sink&& sink) {
+        Header& h = *header();
+        for (size_t i = 0; i < h.stashCount; i++) {
+            Slot payload;
+            size_t leaf;
+            uint8_t slotFlags;
+            read_record_at(stashRecords + i * recordBytes, leaf, slotFlags, payload);
+            sink(leaf, static_cast<uint8_t>(slotFlags | SLOT_VALID), std::move(payload));
+        }
+        h.stashCount = 0;
+        return h.epoch;
+    }
+
+    // Writes the cached levels and the owner's stash (`count` blocks, the
+    // i-th produced by blockAt(i, leaf, flags) as a Slot) to the file,
+    // records the eviction epoch and marks the tree clean for reopening.
+    // The tree stays usable; the next store or drain does not unmark it,
+    // so this is meant for shutdown.
+    template<typename BlockAt>
+    void close_clean(uint64_t epoch, size_t count, BlockAt&& blockAt) {
+        if (count > stashSlots)
+            throw std::runtime_error("Stash larger than the MappedTree stash region");
+        for (size_t i = 0; i < count; i++) {
+            size_t leaf;
+            uint8_t slotFlags;
+            Slot payload = blockAt(i, leaf, slotFlags);
+            write_record_at(stashRecords + i * recordBytes, leaf, slotFlags & ~SLOT_VALID, payload);
+        }
+        for (size_t bucket = 1; bucket <= cachedBuckets; bucket++) {
+            uint64_t mask = 0;
+            int s = 0;
+            cache.visit(bucket, [&](size_t leaf, uint8_t slotFlags, const Slot& payload) {
+                write_record(bucket, s, leaf, slotFlags & ~SLOT_VALID, payload);
+                mask |= 1ull << s;
+                s++;
+            });
+            masks[bucket] = mask;
+        }
+        Header& h = *header();
+        h.epoch = epoch;
+        h.stashCount = count;
+        msync(base, fileBytes, MS_SYNC);
+        // The clean mark goes down last, after everything it vouches for
+        h.clean = 1;
+        msync(base, MAPPED_HEADER_BYTES, MS_SYNC);
+    }
+
+    size_t bucket_count() const { return numBuckets; }
+    int bucket_capacity() const { return capacity; }
+    int tree_height() const { return height; }
+    int cache_levels() const { return cacheLevels; }
+    size_t size() const { return cache.size() + fileValid; }
+
+    // Whether a block with this key and value ciphertext length fits a slot.
+    bool accepts(const std::string& key, size_t valueBytes) const {
+        return key.size() <= maxKeyBytes && valueBytes <= maxValueBytes;
+    }
+
+    int occupancy(size_t bucket) const {
+        return cached(bucket) ? cache.occupancy(bucket) : __builtin_popcountll(masks[bucket]);
+    }
+
+    // Same contract as FlatTree::drain.
+    template<typename Sink>
+    void drain(size_t bucket, Sink&& sink) {
+        if (cached(bucket)) {
+            cache.drain(bucket, std::forward<Sink>(sink));
+            return;
+        }
+        uint64_t mask = masks[bucket];
+        if (!mask) return;
+        masks[bucket] = 0;
+        fileValid -= __builtin_popcountll(mask);
+        for (int s = 0; s < capacity; s++) {
+            if (!(mask >> s & 1)) continue;
+            Slot payload;
+            size_t leaf;
+            uint8_t slotFlags;
+            read_record(bucket, s, leaf, slotFlags, payload);
+            sink(leaf, static_cast<uint8_t>(slotFlags | SLOT_VALID), std::move(payload));
+        }
+    }
+
+    // Same contract as FlatTree::visit.
+    template<typename Visit>
+    void visit(size_t bucket, Visit&& visit) {
+        if (cached(bucket)) {
+            cache.visit(bucket, std::forward<Visit>(visit));
+            return;
+        }
+        uint64_t mask = masks[bucket];
+        Slot payload;
+        for (int s = 0; s < capacity; s++) {
+            if (!(mask >> s & 1)) continue;
+            size_t leaf;
+            uint8_t slotFlags;
+            read_record(bucket, s, leaf, slotFlags, payload);
+            visit(leaf, static_cast<uint8_t>(slotFlags | SLOT_VALID), static_cast<const Slot&>(payload));
+        }
+    }
+
+    // Same contract as FlatTree::store.
+    bool store(size_t bucket, size_t leaf, uint8_t slotFlags, Slot&& payload) {
+        if (cached(bucket)) return cache.store(bucket, leaf, slotFlags, std::move(payload));
+        uint64_t mask = masks[bucket];
+        for (int s = 0; s < capacity; s++) {
+            if (mask >> s & 1) continue;
+            write_record(bucket, s, leaf, slotFlags, payload);
+            masks[bucket] = mask | (1ull << s);
+            fileValid++;
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif
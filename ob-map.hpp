@@ -20,6 +20,9 @@
  * Enhancements:
  * - Parameterized dummy operation counts to balance performance and security.
  * - Pre- and post-dummy phases around each real operation.
+ * - Dense slot table: keys hash to fixed-size groups of slots, and every
+ *   access (real or dummy) scans one whole group with branch-free compares,
+ *   so both cost O(1) and touch memory the same way.
  * - Hooks for potential integration with additional cryptographic primitives (e.g., ORAM)
  * ---------------------------------------------------------------------
  */
@@ -27,34 +30,27 @@
 #include <iostream>
 #include <stdexcept>
 #include <cstdint>
-#include <unordered_map>
-#include <openssl/rand.h>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <functional>
+#include <utility>
 #include <atomic>
+#include <string>
+#include <type_traits>
+#include "crypto.hpp"
+#include "secure-random.hpp"
+#include "oram-log.hpp"
 
 // Default number of dummy operations for map accesses.
 constexpr int DEFAULT_DUMMY_OPS = 5;
 constexpr int EXTRA_DUMMY_OPS = 10;
 
-/**
- * secure_random:
- * Generates a cryptographically secure 32-bit random number using OpenSSL RAND_bytes.
- */
-inline uint32_t secure_random() {
-    uint32_t num;
-    if (RAND_bytes(reinterpret_cast<unsigned char*>(&num), sizeof(num)) != 1) {
-        throw std::runtime_error("RAND_bytes failed");
-    }
-    return num;
-}
-
-/**
- * secure_random_index:
- * Generates a random index within the given range using secure_random.
- * Returns 0 if the range is 0.
- */
-inline size_t secure_random_index(size_t range) {
-    return (range == 0) ? 0 : secure_random() % range;
-}
+// Slot table geometry: OB_MAP_GROUP_SLOTS slots are scanned per access, and
+// the table doubles once it is half full (or a group overflows).
+constexpr size_t OB_MAP_GROUP_SLOTS = 8;
+constexpr size_t OB_MAP_INITIAL_GROUPS = 16;
+constexpr int OB_MAP_MAX_GROWTHS = 8;     // Extra doublings one insert may try before it fails
 
 /**
  * perform_extra_dummy:
@@ -70,21 +66,216 @@ inline void perform_extra_dummy() {
     std::atomic_signal_fence(std::memory_order_seq_cst);
 }
 
+/**
+ * touch_slot:
+ * Reads the first byte of an element in place, so a dummy access loads
+ * the same cache line as a real one without copying the element.
+ */
+template<typename T>
+inline void touch_slot(const T& item) {
+    volatile unsigned char probe = *reinterpret_cast<const volatile unsigned char*>(&item);
+    (void)probe;
+}
+
+/**
+ * slot_tag_hash:
+ * SipHash of a key's bytes under `hashKey`. Strings hash their characters;
+ * other keys must be trivially copyable and hash their object bytes.
+ */
+inline uint64_t slot_tag_hash(const std::string& key, const unsigned char* hashKey) {
+    return siphash24(key.data(), key.size(), hashKey);
+}
+
+template<typename K>
+inline uint64_t slot_tag_hash(const K& key, const unsigned char* hashKey) {
+    static_assert(std::is_trivially_copyable<K>::value,
+                  "ObliviousSlotTable keys must be strings or trivially copyable");
+    return siphash24(&key, sizeof(K), hashKey);
+}
+
+/**
+ * ObliviousSlotTable:
+ * Dense hash table behind ObliviousMap. Slot tags, keys and values live in
+ * three parallel arrays; a key's 64-bit tag (never 0, which marks a free
+ * slot) selects one group of OB_MAP_GROUP_SLOTS slots. Finding a key or a
+ * free slot is a fixed-length scan of the group's tags that picks the
+ * index with masks instead of branches, and probe() runs that same scan
+ * on a random group for dummy accesses. There are no probe chains, so a
+ * removal just frees its slot.
+ */
+template<typename K, typename V>
+class ObliviousSlotTable {
+private:
+    std::vector<uint64_t> tags;
+    std::vector<K> keys;
+    std::vector<V> values;
+    size_t groups;
+    size_t count;
+    unsigned char hashKey[SIPHASH_KEY_SIZE];   // per-table key, so group choice is not predictable
+
+    // Keyed on the key bytes rather than std::hash, whose collisions would
+    // land in the same group under every table key.
+    uint64_t tag_of(const K& key) const { return slot_tag_hash(key, hashKey) | 1; }
+
+    size_t group_of(uint64_t tag) const { return static_cast<size_t>(tag >> 32) & (groups - 1); }
+
+    // Index in the group of the last slot whose tag equals `tag`, or
+    // OB_MAP_GROUP_SLOTS if there is none.
+    size_t scan(size_t group, uint64_t tag) const {
+        const uint64_t* t = &tags[group * OB_MAP_GROUP_SLOTS];
+        size_t match = OB_MAP_GROUP_SLOTS;
+        for (size_t i = 0; i < OB_MAP_GROUP_SLOTS; i++) {
+            size_t eq = static_cast<size_t>(0) - static_cast<size_t>(t[i] == tag);
+            match = (match & ~eq) | (i & eq);
+        }
+        return match;
+    }
+
+    // Slot holding `key`, or npos. A tag match with a different key (a
+    // 64-bit collision) falls back to comparing every key in the group.
+    size_t find(const K& key, uint64_t tag) const {
+        size_t base = group_of(tag) * OB_MAP_GROUP_SLOTS;
+        size_t match = scan(group_of(tag), tag);
+        if (match == OB_MAP_GROUP_SLOTS) return npos;
+        if (keys[base + match] == key) return base + match;
+        for (size_t i = 0; i < OB_MAP_GROUP_SLOTS; i++) {
+            if (tags[base + i] == tag && keys[base + i] == key) return base + i;
+        }
+        return npos;
+    }
+
+    // True if every stored tag plus `extra` fits in a table of `newGroups`.
+    bool fits(size_t newGroups, uint64_t extra) const {
+        std::vector<size_t> load(newGroups, 0);
+        load[static_cast<size_t>(extra >> 32) & (newGroups - 1)]++;
+        for (uint64_t tag : tags) {
+            if (tag != 0) load[static_cast<size_t>(tag >> 32) & (newGroups - 1)]++;
+        }
+        for (size_t n : load) {
+            if (n > OB_MAP_GROUP_SLOTS) return false;
+        }
+        return true;
+    }
+
+    // Moves every entry into a table of `newGroups`, which must fit them.
+    void rebuild(size_t newGroups) {
+        std::vector<uint64_t> oldTags(newGroups * OB_MAP_GROUP_SLOTS, 0);
+        std::vector<K> oldKeys(newGroups * OB_MAP_GROUP_SLOTS);
+        std::vector<V> oldValues(newGroups * OB_MAP_GROUP_SLOTS);
+        oldTags.swap(tags);
+        oldKeys.swap(keys);
+        oldValues.swap(values);
+        groups = newGroups;
+        count = 0;
+        for (size_t i = 0; i < oldTags.size(); i++) {
+            if (oldTags[i] != 0) {
+                place(oldTags[i], std::move(oldKeys[i]), std::move(oldValues[i]));
+            }
+        }
+    }
+
+    // Rebuilds into the smallest table of at least `minGroups` groups where
+    // the entries and `tag` all fit. Only more than OB_MAP_GROUP_SLOTS keys
+    // agreeing on OB_MAP_MAX_GROWTHS more tag bits can keep failing; that
+    // throws, leaving the table as it was, rather than doubling without bound.
+    void grow(size_t minGroups, uint64_t tag) {
+        size_t newGroups = minGroups;
+        for (int growths = 0; growths <= OB_MAP_MAX_GROWTHS; growths++, newGroups *= 2) {
+            if (fits(newGroups, tag)) {
+                rebuild(newGroups);
+                return;
+            }
+        }
+        throw std::runtime_error("ObliviousSlotTable group stays full after growing");
+    }
+
+    // Puts a key known to be absent into a free slot of its group, which
+    // must have one.
+    void place(uint64_t tag, K&& key, V&& value) {
+        size_t group = group_of(tag);
+        size_t slot = group * OB_MAP_GROUP_SLOTS + scan(group, 0);
+        tags[slot] = tag;
+        keys[slot] = std::move(key);
+        values[slot] = std::move(value);
+        count++;
+    }
+
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    ObliviousSlotTable()
+        : tags(OB_MAP_INITIAL_GROUPS * OB_MAP_GROUP_SLOTS, 0),
+          keys(OB_MAP_INITIAL_GROUPS * OB_MAP_GROUP_SLOTS),
+          values(OB_MAP_INITIAL_GROUPS * OB_MAP_GROUP_SLOTS),
+          groups(OB_MAP_INITIAL_GROUPS), count(0) {
+        uint64_t words[2] = {SecureRandom::local().next_u64(), SecureRandom::local().next_u64()};
+        std::memcpy(hashKey, words, sizeof(hashKey));
+    }
+
+    // Table with a caller-chosen hash key, so tests can pick colliding keys.
+    explicit ObliviousSlotTable(const unsigned char key[SIPHASH_KEY_SIZE])
+        : ObliviousSlotTable() {
+        std::memcpy(hashKey, key, sizeof(hashKey));
+    }
+
+    size_t size() const { return count; }
+    size_t slots() const { return tags.size(); }
+
+    void insert(const K& key, const V& value) {
+        uint64_t tag = tag_of(key);
+        size_t slot = find(key, tag);
+        if (slot != npos) {
+            values[slot] = value;
+            return;
+        }
+        if (2 * (count + 1) > slots() || scan(group_of(tag), 0) == OB_MAP_GROUP_SLOTS)
+            grow(groups * 2, tag);
+        place(tag, K(key), V(value));
+    }
+
+    bool lookup(const K& key, V& value) const {
+        uint64_t tag = tag_of(key);
+        size_t slot = find(key, tag);
+        // The value slot is loaded whether or not the key was found
+        touch_slot(values[slot != npos ? slot : group_of(tag) * OB_MAP_GROUP_SLOTS]);
+        if (slot == npos) return false;
+        value = values[slot];
+        return true;
+    }
+
+    bool remove(const K& key) {
+        size_t slot = find(key, tag_of(key));
+        if (slot == npos) return false;
+        tags[slot] = 0;
+        keys[slot] = K();
+        values[slot] = V();
+        count--;
+        return true;
+    }
+
+    /**
+     * probe:
+     * Dummy access: the same group scan and value load as a lookup, on a
+     * uniformly random group.
+     */
+    void probe() const {
+        uint64_t r = SecureRandom::local().next_u64();
+        size_t group = static_cast<size_t>(r >> 32) & (groups - 1);
+        size_t match = scan(group, r | 1);
+        touch_slot(values[group * OB_MAP_GROUP_SLOTS + (match & (OB_MAP_GROUP_SLOTS - 1))]);
+    }
+};
+
 /**
  * perform_map_dummy:
- * Performs dummy memory accesses on the unordered_map.
- * Simulates real access patterns by reading random elements from the map 'ops' times.
+ * Performs 'ops' dummy group scans on random groups of the slot table.
+ * Each costs the same as a real probe, whatever the table size.
  * A memory fence is inserted afterward to prevent compiler reordering.
  */
 template<typename K, typename V>
-void perform_map_dummy(const std::unordered_map<K,V>& data, int ops) {
+void perform_map_dummy(const ObliviousSlotTable<K,V>& data, int ops) {
     for (int i = 0; i < ops; ++i) {
-         if (!data.empty()) {
-             auto it = data.begin();
-             std::advance(it, secure_random_index(data.size()));
-             auto dummy = it->second;
-             (void)dummy; // Prevent unused variable warnings.
-         }
+         data.probe();
     }
     std::atomic_signal_fence(std::memory_order_seq_cst);
 }
@@ -97,7 +288,7 @@ void perform_map_dummy(const std::unordered_map<K,V>& data, int ops) {
 template<typename K, typename V>
 class ObliviousMap {
 private:
-    std::unordered_map<K,V> data;
+    ObliviousSlotTable<K,V> data;
     int dummyOps; // Number of dummy operations to perform.
 public:
     /**
@@ -116,10 +307,10 @@ public:
     void oblivious_insert(const K & key, const V & value) {
          perform_map_dummy(data, dummyOps);
          perform_extra_dummy();
-         data[key] = value;
+         data.insert(key, value);
          perform_map_dummy(data, dummyOps);
          perform_extra_dummy();
-         std::cout << "[ObliviousMap] Inserted key: " << key << "\n";
+         ORAM_TRACE("[ObliviousMap] Inserted key: " << key);
     }
 
     /**
@@ -132,15 +323,11 @@ public:
     bool oblivious_lookup(const K & key, V & value) {
          perform_map_dummy(data, dummyOps);
          perform_extra_dummy();
-         auto it = data.find(key);
-         bool found = (it != data.end());
-         if (found) {
-              value = it->second;
-         }
+         bool found = data.lookup(key, value);
          perform_map_dummy(data, dummyOps);
          perform_extra_dummy();
-         std::cout << "[ObliviousMap] Lookup for key: " << key
-                   << " found: " << (found ? "true" : "false") << "\n";
+         ORAM_TRACE("[ObliviousMap] Lookup for key: " << key
+                    << " found: " << (found ? "true" : "false"));
          return found;
     }
 
@@ -152,11 +339,13 @@ public:
     void oblivious_remove(const K & key) {
          perform_map_dummy(data, dummyOps);
          perform_extra_dummy();
-         data.erase(key);
+         data.remove(key);
          perform_map_dummy(data, dummyOps);
          perform_extra_dummy();
-         std::cout << "[ObliviousMap] Removed key: " << key << "\n";
+         ORAM_TRACE("[ObliviousMap] Removed key: " << key);
     }
+
+    size_t size() const { return data.size(); }
 };
 
 #endif 
@@ -20,9 +20,10 @@
 #include <iostream>
 #include <vector>
 #include <stdexcept>
-#include <openssl/rand.h>
 #include <atomic>
-#include "ob-map.hpp"  // For secure_random and perform_extra_dummy
+#include "secure-random.hpp"
+#include "ob-map.hpp"  // For perform_extra_dummy and touch_slot
+#include "oram-log.hpp"
 
 // Default number of dummy operations for buffer accesses.
 constexpr int DEFAULT_BUFFER_DUMMY_OPS = 5;
@@ -30,7 +31,7 @@ constexpr int DEFAULT_BUFFER_DUMMY_OPS = 5;
 /**
  * perform_buffer_dummy:
  * Performs dummy memory accesses on the buffer to simulate real access patterns.
- * Reads random elements from the buffer 'ops' times and inserts a memory fence.
+ * Loads random live elements in place (no copy) 'ops' times and inserts a memory fence.
  * @param buffer: The circular buffer.
  * @param head: Current head index of the buffer.
  * @param count: Number of valid elements in the buffer.
@@ -43,8 +44,7 @@ void perform_buffer_dummy(const std::vector<T>& buffer, size_t head, size_t coun
          if (count > 0) {
               size_t randomOffset = secure_random_index(count);
               size_t randomIndex = (head + randomOffset) % capacity;
-              T temp = buffer[randomIndex];
-              (void)temp;
+              touch_slot(buffer[randomIndex]);
          }
     }
     std::atomic_signal_fence(std::memory_order_seq_cst);
@@ -84,7 +84,7 @@ public:
      */
     bool oblivious_push(const T & item) {
         if (count == capacity) {
-            std::cout << "[ObliviousQueue] Push attempted on full queue.\n";
+            ORAM_DEBUG("[ObliviousQueue] Push attempted on full queue.");
             perform_extra_dummy();
             return false;
         }
@@ -100,7 +100,7 @@ public:
         // Post-insertion dummy phase.
         perform_buffer_dummy(buffer, head, count, capacity, dummyOps);
         perform_extra_dummy();
-        std::cout << "[ObliviousQueue] Pushed item. Queue size: " << count << "\n";
+        ORAM_TRACE("[ObliviousQueue] Pushed item. Queue size: " << count);
         return true;
     }
 
@@ -113,7 +113,7 @@ public:
      */
     bool oblivious_pop(T & item) {
         if (count == 0) {
-            std::cout << "[ObliviousQueue] Pop attempted on empty queue.\n";
+            ORAM_DEBUG("[ObliviousQueue] Pop attempted on empty queue.");
             perform_extra_dummy();
             return false;
         }
@@ -129,7 +129,7 @@ public:
         // Post-pop dummy phase.
         perform_buffer_dummy(buffer, head, count, capacity, dummyOps);
         perform_extra_dummy();
-        std::cout << "[ObliviousQueue] Popped item. Queue size: " << count << "\n";
+        ORAM_TRACE("[ObliviousQueue] Popped item. Queue size: " << count);
         return true;
     }
 };
@@ -0,0 +1,173 @@
+#ifndef OBLIVIOUS_PRIMITIVES_HPP
+#define OBLIVIOUS_PRIMITIVES_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#if !defined(ORAM_DISABLE_SIMD) && (defined(__x86_64__) || defined(__i386__))
+#define ORAM_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// -------------------------
+// Constant-Time Selection
+// -------------------------
+// Masks are built from comparisons and passed through an empty asm barrier,
+// so the optimizer cannot turn the selects back into branches on the
+// condition. Build with -DORAM_DISABLE_SIMD to force the portable scan.
+
+// All ones if c, else zero.
+inline uint64_t ct_mask(bool c) {
+    uint64_t m = static_cast<uint64_t>(0) - static_cast<uint64_t>(c);
+#if defined(__GNUC__)
+    __asm__("" : "+r"(m));
+#endif
+    return m;
+}
+
+// a if c, else b.
+inline uint64_t ct_select_u64(bool c, uint64_t a, uint64_t b) {
+    uint64_t m = ct_mask(c);
+    return (a & m) | (b & ~m);
+}
+
+inline uint64_t ct_min_u64(uint64_t a, uint64_t b) { return ct_select_u64(a < b, a, b); }
+inline uint64_t ct_max_u64(uint64_t a, uint64_t b) { return ct_select_u64(a < b, b, a); }
+
+// -------------------------
+// Oblivious Linear Scan
+// -------------------------
+// ct_find_u64(v, n, needle) returns the index of the last element equal to
+// needle, or n if there is none. Every element is read and compared, and
+// the result is picked with selects, so the time taken does not depend on
+// where (or whether) the needle is found. Kernels: AVX-512F, AVX2 and a
+// portable fallback, chosen once from the CPU at first use.
+inline size_t ct_find_u64_portable(const uint64_t* v, size_t n, uint64_t needle) {
+    uint64_t match = n;
+    for (size_t i = 0; i < n; i++) {
+        match = ct_select_u64(v[i] == needle, i, match);
+    }
+    return static_cast<size_t>(match);
+}
+
+#ifdef ORAM_X86_SIMD
+__attribute__((target("avx2")))
+inline size_t ct_find_u64_avx2(const uint64_t* v, size_t n, uint64_t needle) {
+    const __m256i want = _mm256_set1_epi64x(static_cast<long long>(needle));
+    const __m256i step = _mm256_set1_epi64x(4);
+    __m256i idx = _mm256_setr_epi64x(0, 1, 2, 3);
+    __m256i best = _mm256_set1_epi64x(-1);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i)), want);
+        best = _mm256_blendv_epi8(best, idx, eq);
+        idx = _mm256_add_epi64(idx, step);
+    }
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), best);
+    // Unmatched lanes hold all ones; adding one maps them to 0 and index i to i+1
+    uint64_t top = 0;
+    for (int k = 0; k < 4; k++) top = ct_max_u64(top, lanes[k] + 1);
+    uint64_t match = ct_select_u64(top != 0, top - 1, n);
+    for (; i < n; i++) {
+        match = ct_select_u64(v[i] == needle, i, match);
+    }
+    return static_cast<size_t>(match);
+}
+
+__attribute__((target("avx512f")))
+inline size_t ct_find_u64_avx512(const uint64_t* v, size_t n, uint64_t needle) {
+    const __m512i want = _mm512_set1_epi64(static_cast<long long>(needle));
+    const __m512i step = _mm512_set1_epi64(8);
+    __m512i idx = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    __m512i best = _mm512_set1_epi64(-1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __mmask8 eq = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(v + i), want);
+        best = _mm512_mask_mov_epi64(best, eq, idx);
+        idx = _mm512_add_epi64(idx, step);
+    }
+    alignas(64) uint64_t lanes[8];
+    _mm512_store_si512(lanes, best);
+    uint64_t top = 0;
+    for (int k = 0; k < 8; k++) top = ct_max_u64(top, lanes[k] + 1);
+    uint64_t match = ct_select_u64(top != 0, top - 1, n);
+    for (; i < n; i++) {
+        match = ct_select_u64(v[i] == needle, i, match);
+    }
+    return static_cast<size_t>(match);
+}
+#endif
+
+using CtFindKernel = size_t (*)(const uint64_t*, size_t, uint64_t);
+
+inline CtFindKernel ct_find_pick_kernel(const char** name) {
+#ifdef ORAM_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        *name = "avx512";
+        return ct_find_u64_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        *name = "avx2";
+        return ct_find_u64_avx2;
+    }
+#endif
+    *name = "portable";
+    return ct_find_u64_portable;
+}
+
+struct CtFindDispatch {
+    const char* name;
+    CtFindKernel kernel;
+
+    CtFindDispatch() : name(nullptr), kernel(ct_find_pick_kernel(&name)) {}
+
+    static const CtFindDispatch& get() {
+        static const CtFindDispatch dispatch;
+        return dispatch;
+    }
+};
+
+inline size_t ct_find_u64(const uint64_t* v, size_t n, uint64_t needle) {
+    return CtFindDispatch::get().kernel(v, n, needle);
+}
+
+// Name of the kernel ct_find_u64 runs on this CPU.
+inline const char* ct_find_kernel_name() { return CtFindDispatch::get().name; }
+
+// -------------------------
+// Bitonic Sort
+// -------------------------
+// Sorts v ascending with a bitonic network. The sequence of compare-exchange
+// positions depends only on v.size(), and each compare-exchange is a pair of
+// selects, so neither the memory pattern nor the branches depend on the
+// values. v is padded to a power of two with UINT64_MAX (which sorts last)
+// and trimmed back; a scratch vector kept by the caller keeps its capacity.
+// Callers sort packed keys, e.g. (priority << 32 | index), and then act on
+// the indices.
+inline void bitonic_sort_u64(std::vector<uint64_t>& v) {
+    size_t n = v.size();
+    if (n < 2) return;
+    size_t padded = 1;
+    while (padded < n) padded <<= 1;
+    v.resize(padded, UINT64_MAX);
+    uint64_t* d = v.data();
+    for (size_t k = 2; k <= padded; k <<= 1) {
+        for (size_t j = k >> 1; j > 0; j >>= 1) {
+            for (size_t i = 0; i < padded; i++) {
+                size_t l = i ^ j;
+                if (l <= i) continue;
+                uint64_t lo = ct_min_u64(d[i], d[l]);
+                uint64_t hi = ct_max_u64(d[i], d[l]);
+                bool ascending = (i & k) == 0;
+                d[i] = ascending ? lo : hi;
+                d[l] = ascending ? hi : lo;
+            }
+        }
+    }
+    v.resize(n);
+}
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef ORAM_ASYNC_HPP
+#define ORAM_ASYNC_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+
+// -------------------------
+// Configuration Parameters
+// -------------------------
+constexpr size_t ASYNC_STRAND_DEPTH_DEFAULT = 256;   // Queued operations per strand before post() blocks
+
+// -------------------------
+// OramStrandPool
+// -------------------------
+// A fixed set of strands, each a FIFO of tasks run in order by its own
+// worker thread. post(strand, fn) queues fn and returns a future for its
+// result (or exception); tasks on one strand never overlap or reorder,
+// tasks on different strands run concurrently. One caller thread can thus
+// keep many ORAM operations in flight, each strand blocking on its own
+// path reads (page faults on a mapped tree, lock waits), without a thread
+// per request. post() blocks while the strand already holds `depth` tasks.
+// The destructor runs every queued task before joining.
+struct StrandStats {
+    uint64_t executed = 0;
+    size_t queueHighWater = 0;
+};
+
+class OramStrandPool {
+private:
+    struct Strand {
+        std::mutex mtx;
+        std::condition_variable ready;      // worker: a task arrived or stopping
+        std::condition_variable room;       // posters: the queue dropped below depth
+        std::deque<std::function<void()>> tasks;
+        bool stopping = false;
+        StrandStats stats;
+        std::thread worker;
+    };
+
+    std::vector<std::unique_ptr<Strand>> strands;
+    size_t depth;
+
+    static void run(Strand& strand) {
+        std::unique_lock<std::mutex> lock(strand.mtx);
+        while (true) {
+            strand.ready.wait(lock, [&strand] { return strand.stopping || !strand.tasks.empty(); });
+            if (strand.tasks.empty()) return;   // stopping and drained
+            std::function<void()> task = std::move(strand.tasks.front());
+            strand.tasks.pop_front();
+            strand.room.notify_one();
+            lock.unlock();
+            task();                             // packaged_task: exceptions land in the future
+            lock.lock();
+            strand.stats.executed++;
+        }
+    }
+
+public:
+    explicit OramStrandPool(size_t numStrands, size_t strandDepth = ASYNC_STRAND_DEPTH_DEFAULT)
+      : depth(strandDepth) {
+        if (numStrands == 0) throw std::invalid_argument("OramStrandPool needs at least one strand");
+        if (strandDepth == 0) throw std::invalid_argument("OramStrandPool strand depth must be positive");
+        strands.reserve(numStrands);
+        for (size_t i = 0; i < numStrands; i++) {
+            strands.emplace_back(new Strand());
+            Strand& strand = *strands.back();
+            strand.worker = std::thread([&strand] { run(strand); });
+        }
+    }
+
+    OramStrandPool(const OramStrandPool&) = delete;
+    OramStrandPool& operator=(const OramStrandPool&) = delete;
+
+    ~OramStrandPool() {
+        for (auto& strand : strands) {
+            std::lock_guard<std::mutex> lock(strand->mtx);
+            strand->stopping = true;
+            strand->ready.notify_one();
+            strand->room.notify_all();      // posters blocked on a full strand throw
+        }
+        for (auto& strand : strands) strand->worker.join();
+    }
+
+    // Queues fn on strand `index % size()`.
+    template<typename Fn>
+    auto post(size_t index, Fn&& fn) -> std::future<std::invoke_result_t<std::decay_t<Fn>&>> {
+        using R = std::invoke_result_t<std::decay_t<Fn>&>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<Fn>(fn));
+        std::future<R> result = task->get_future();
+        Strand& strand = *strands[index % strands.size()];
+        bool wasEmpty;
+        {
+            std::unique_lock<std::mutex> lock(strand.mtx);
+            strand.room.wait(lock, [&] { return strand.stopping || strand.tasks.size() < depth; });
+            if (strand.stopping) throw std::runtime_error("OramStrandPool is shutting down");
+            wasEmpty = strand.tasks.empty();
+            strand.tasks.emplace_back([task] { (*task)(); });
+            strand.stats.queueHighWater = std::max(strand.stats.queueHighWater, strand.tasks.size());
+        }
+        if (wasEmpty) strand.ready.notify_one();   // otherwise the worker is busy and will not wait
+        return result;
+    }
+
+    size_t size() const { return strands.size(); }
+
+    // Tasks queued but not yet started, over all strands.
+    size_t pending() const {
+        size_t total = 0;
+        for (const auto& strand : strands) {
+            std::lock_guard<std::mutex> lock(strand->mtx);
+            total += strand->tasks.size();
+        }
+        return total;
+    }
+
+    StrandStats getStats(size_t index) const {
+        Strand& strand = *strands[index];
+        std::lock_guard<std::mutex> lock(strand.mtx);
+        return strand.stats;
+    }
+};
+
+// -------------------------
+// Async map and queue front ends
+// -------------------------
+// Result of an asynchronous lookup, remove or pop.
+template<typename V>
+struct AsyncResult {
+    bool found = false;
+    V value{};
+};
+
+// Future-returning front end for any map with the oblivious_insert /
+// oblivious_lookup / oblivious_remove interface (ObliviousMap,
+// ShardedObliviousMap, ObliviousFib-style wrappers). `route(key)` picks the
+// strand, so every operation on one key runs on one strand in submission
+// order: an insert followed by a lookup of the same key always sees the
+// insert. Route a ShardedObliviousMap by shard_index() so each shard's own
+// accesses come from one strand; with coverAccesses > 0 every operation
+// also touches other shards, so strands still contend for their locks.
+// The map must outlive the pool's queued work.
+template<typename K, typename V, typename Map>
+class AsyncObliviousMap {
+public:
+    using Router = std::function<size_t(const K&)>;
+
+private:
+    Map& map;
+    OramStrandPool& pool;
+    Router route;
+
+public:
+    AsyncObliviousMap(Map& target, OramStrandPool& strands, Router router = std::hash<K>())
+      : map(target), pool(strands), route(std::move(router)) {}
+
+    std::future<void> async_insert(const K& key, const V& value) {
+        return pool.post(route(key), [this, key, value] { map.oblivious_insert(key, value); });
+    }
+
+    std::future<AsyncResult<V>> async_lookup(const K& key) {
+        return pool.post(route(key), [this, key] {
+            AsyncResult<V> result;
+            result.found = map.oblivious_lookup(key, result.value);
+            return result;
+        });
+    }
+
+    std::future<AsyncResult<V>> async_remove(const K& key) {
+        return pool.post(route(key), [this, key] {
+            AsyncResult<V> result;
+            result.found = map.oblivious_remove(key, &result.value);
+            return result;
+        });
+    }
+};
+
+// Future-returning front end for an ObliviousQueue: every push and pop runs
+// on one strand, so they keep their submission order.
+template<typename T, typename Queue>
+class AsyncObliviousQueue {
+private:
+    Queue& queue;
+    OramStrandPool& pool;
+    size_t strand;
+
+public:
+    AsyncObliviousQueue(Queue& target, OramStrandPool& strands, size_t strandIndex = 0)
+      : queue(target), pool(strands), strand(strandIndex) {}
+
+    std::future<void> async_push(const T& item) {
+        return pool.post(strand, [this, item] { queue.oblivious_push(item); });
+    }
+
+    std::future<AsyncResult<T>> async_pop() {
+        return pool.post(strand, [this] {
+            AsyncResult<T> result;
+            result.found = queue.oblivious_pop(result.value);
+            return result;
+        });
+    }
+};
+
+#endif
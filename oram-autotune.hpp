@@ -0,0 +1,445 @@
+#ifndef ORAM_AUTOTUNE_HPP
+#define ORAM_AUTOTUNE_HPP
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#include "oram-engine.hpp"
+#include "oram-log.hpp"
+
+// -------------------------
+// Configuration Parameters
+// -------------------------
+// A store grows by one level when any signal fires at a sample point.
+struct AutotuneConfig {
+    uint64_t sampleInterval = 256;      // operations between samples
+    double maxLoadFactor = 0.25;        // live entries / (buckets * Z)
+    double stashPressure = 0.5;         // stash high-water / stash limit
+    double maxEvictionRate = 0.05;      // full evictions per operation since the last sample
+    int maxHeight = 24;                 // never grow past this
+    size_t replayBatch = 64;            // log entries left for the final, exclusive replay
+    int maxReplayRounds = 8;            // catch-up rounds before the final replay regardless
+};
+
+// Live view of one autotuned store.
+struct AutotuneStats {
+    int treeHeight = 0;
+    uint64_t rebuilds = 0;
+    uint64_t failedRebuilds = 0;
+    double loadFactor = 0;              // at the last sample
+    size_t stashHighWater = 0;          // of the current tree
+    uint64_t lastRebuildNs = 0;         // copy + bulk load + replay, off the foreground path
+    uint64_t lastSwapNs = 0;            // final replay and pointer swap, foreground blocked
+};
+
+// -------------------------
+// AutotunedStore (online tree resizing)
+// -------------------------
+// Wraps a store built by `factory(height)` and samples it every
+// sampleInterval operations: load factor, stash high-water mark, emergency
+// drops, critical evictions and the full-eviction rate. When one of them
+// says the tree is too small, a background thread rebuilds it one level
+// taller with copy-on-rebuild:
+//   1. writes start going to a log as well as to the live store;
+//   2. the live store writes a snapshot of itself, which serialises the
+//      stored ciphertexts without decrypting or moving a block;
+//   3. off the foreground path, the snapshot is loaded into a scratch tree
+//      of the old height, whose entries are copied out and bulk-loaded into
+//      the new tree;
+//   4. the log is replayed into the new tree until only a few entries are
+//      left (or maxReplayRounds rounds have not got there, when writes
+//      arrive as fast as they replay), while the old tree keeps serving;
+//   5. foreground operations are held off only to replay that remainder
+//      and swap the trees.
+// So a foreground operation on the old tree waits at most for the snapshot
+// write and, later, for the final swap; the decrypting copy-out, the bulk
+// load and the bulk of the replay all run on the scratch and new trees. A
+// write only waits for the rebuild if the old tree's stash passes the
+// pressure mark in the meantime. Writes made during a rebuild are
+// serialised with their log append so the log keeps their order.
+// Statistics of retired trees are folded into getStats().
+// Snapshots are passed through unchanged and load only into a tree of the
+// height they were saved at.
+template<typename K, typename V>
+class AutotunedStore : public ObliviousStore<K,V> {
+public:
+    using Store = ObliviousStore<K,V>;
+    using Factory = std::function<std::unique_ptr<Store>(int height)>;
+    using ExpiryPredicate = typename Store::ExpiryPredicate;
+
+private:
+    enum class LogOp { Insert, Remove, Expire };
+
+    struct LogEntry {
+        LogOp op;
+        K key;
+        V value;
+        ExpiryPredicate expired;
+    };
+
+    Factory factory;
+    AutotuneConfig config;
+    std::unique_ptr<Store> current;
+    mutable std::shared_mutex storeMtx;   // shared: operations; exclusive: start and swap of a rebuild
+    std::mutex logMtx;                    // orders writes and log appends during a rebuild
+    std::vector<LogEntry> log;
+    bool logging;                         // written under exclusive storeMtx
+    std::atomic<bool> rebuilding;
+    std::atomic<uint64_t> opCount;
+    std::mutex rebuilderMtx;              // guards the thread handle, not the rebuild
+    std::thread rebuilder;
+    std::mutex doneMtx;                   // pairs with rebuildDone
+    std::condition_variable rebuildDone;  // signalled when `rebuilding` clears
+
+    mutable std::mutex tuneMtx;           // sampling state and stats below
+    AutotuneStats tune;
+    OramStats retiredStats;
+    uint64_t lastSampleOps;
+    uint64_t lastFullEvictions;
+
+    static uint64_t ns_since(std::chrono::steady_clock::time_point t) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t).count());
+    }
+
+    static void apply(Store& store, const LogEntry& entry) {
+        switch (entry.op) {
+        case LogOp::Insert: store.oblivious_insert(entry.key, entry.value); break;
+        case LogOp::Remove: store.oblivious_remove(entry.key); break;
+        case LogOp::Expire: store.expire_entries(entry.expired); break;
+        }
+    }
+
+    // Runs a write against the live store, logging it if a rebuild is
+    // copying. Call with storeMtx held shared.
+    template<typename Write, typename Record>
+    auto write(Write&& doWrite, Record&& record) -> decltype(doWrite()) {
+        if (!logging) return doWrite();
+        std::lock_guard<std::mutex> lock(logMtx);
+        record(log);
+        return doWrite();
+    }
+
+    void note_ops(uint64_t count) {
+        uint64_t before = opCount.fetch_add(count, std::memory_order_relaxed);
+        if (before / config.sampleInterval != (before + count) / config.sampleInterval) sample();
+    }
+
+    // Checks the signals and starts a rebuild if one fires.
+    void sample() {
+        if (rebuilding.load()) return;
+        int height;
+        size_t live, stashLimit;
+        OramStats stats;
+        int capacity;
+        {
+            std::shared_lock<std::shared_mutex> lock(storeMtx);
+            height = current->getTreeHeight();
+            capacity = current->getBucketCapacity();
+            stashLimit = current->getStashLimit();
+            live = current->size();
+            stats = current->getStats();
+        }
+
+        std::string reason;
+        {
+            std::lock_guard<std::mutex> lock(tuneMtx);
+            double buckets = static_cast<double>((static_cast<size_t>(2) << height) - 1);
+            tune.loadFactor = live / (buckets * capacity);
+            tune.stashHighWater = stats.stashHighWater;
+            uint64_t ops = opCount.load(std::memory_order_relaxed);
+            uint64_t fullEvictions = stats.phase(OramPhase::FullEviction).count();
+            double evictionRate = ops > lastSampleOps
+                ? static_cast<double>(fullEvictions - std::min(fullEvictions, lastFullEvictions)) / (ops - lastSampleOps)
+                : 0.0;
+            lastSampleOps = ops;
+            lastFullEvictions = fullEvictions;
+
+            if (height >= config.maxHeight) return;
+            if (tune.loadFactor > config.maxLoadFactor) reason = "load factor";
+            else if (stats.stashHighWater > config.stashPressure * stashLimit) reason = "stash high-water";
+            else if (stats.emergencyDrops > 0) reason = "emergency drops";
+            else if (stats.phase(OramPhase::CriticalEviction).count() > 0) reason = "critical evictions";
+            else if (evictionRate > config.maxEvictionRate) reason = "full-eviction rate";
+            if (reason.empty()) return;
+        }
+
+        // The handle is swapped under its own mutex: a fast rebuild can clear
+        // `rebuilding` before the thread that started it has stored the handle
+        std::lock_guard<std::mutex> lock(rebuilderMtx);
+        bool idle = false;
+        if (!rebuilding.compare_exchange_strong(idle, true)) return;
+        if (rebuilder.joinable()) rebuilder.join();   // the previous rebuild has finished
+        ORAM_INFO("[Autotune] growing tree " << height << " -> " << height + 1 << " (" << reason
+                  << ": " << live << " entries, stash high-water " << stats.stashHighWater << "/" << stashLimit << ")");
+        rebuilder = std::thread(&AutotunedStore::rebuild, this, height + 1);
+    }
+
+    // Writes wait out a rebuild once the old tree's stash passes the pressure
+    // mark, so a burst cannot overflow it before the larger tree is in.
+    void throttle() {
+        if (!rebuilding.load()) return;
+        bool pressed;
+        {
+            std::shared_lock<std::shared_mutex> lock(storeMtx);
+            pressed = current->getStashSize() > config.stashPressure * current->getStashLimit();
+        }
+        if (pressed) wait_for_rebuild();
+    }
+
+    void rebuild(int height) {
+        auto start = std::chrono::steady_clock::now();
+        Store* old = nullptr;
+        try {
+            {
+                std::unique_lock<std::shared_mutex> lock(storeMtx);
+                log.clear();
+                logging = true;
+                old = current.get();
+            }
+
+            // The old tree's lock is held only while it writes the snapshot;
+            // entries are copied out of a scratch tree restored from it
+            std::vector<std::pair<K,V>> entries;
+            {
+                std::stringstream image;
+                old->save_snapshot(image);
+                std::unique_ptr<Store> scratch = factory(old->getTreeHeight());
+                scratch->load_snapshot(image);
+                scratch->expire_entries([&entries](const K& key, const V& value) {
+                    entries.emplace_back(key, value);
+                    return false;
+                });
+            }
+            std::sort(entries.begin(), entries.end(),
+                      [](const std::pair<K,V>& a, const std::pair<K,V>& b) { return a.first < b.first; });
+            std::unique_ptr<Store> next = factory(height);
+            next->bulk_load(entries);
+
+            // Catch up with the writes made meanwhile, a batch at a time
+            std::vector<LogEntry> pending;
+            for (int round = 0; round < config.maxReplayRounds; round++) {
+                {
+                    std::lock_guard<std::mutex> lock(logMtx);
+                    if (log.size() <= config.replayBatch) break;
+                    pending.swap(log);
+                }
+                for (const auto& entry : pending) apply(*next, entry);
+                pending.clear();
+            }
+            uint64_t rebuildNs = ns_since(start);
+
+            auto swapStart = std::chrono::steady_clock::now();
+            uint64_t swapNs;
+            {
+                std::unique_lock<std::shared_mutex> lock(storeMtx);
+                for (const auto& entry : log) apply(*next, entry);
+                log.clear();
+                logging = false;
+                std::lock_guard<std::mutex> tuneLock(tuneMtx);
+                retiredStats.merge(current->getStats());
+                current.swap(next);
+                tune.treeHeight = height;
+                tune.rebuilds++;
+                tune.lastRebuildNs = rebuildNs;
+                swapNs = ns_since(swapStart);
+                tune.lastSwapNs = swapNs;
+                lastFullEvictions = 0;
+            }
+            ORAM_INFO("[Autotune] tree height now " << height << "; rebuilt with " << entries.size()
+                      << " entries in " << rebuildNs / 1e6 << " ms, foreground held " << swapNs / 1e3 << " μs");
+            // `next` now holds the old tree and is released here, outside the locks
+        } catch (const std::exception& ex) {
+            {
+                std::unique_lock<std::shared_mutex> lock(storeMtx);
+                log.clear();
+                logging = false;
+            }
+            std::lock_guard<std::mutex> tuneLock(tuneMtx);
+            tune.failedRebuilds++;
+            config.maxHeight = height - 1;   // do not try this size again
+            ORAM_ERROR("[Autotune] rebuild to height " << height << " failed: " << ex.what());
+        }
+        {
+            std::lock_guard<std::mutex> lock(doneMtx);
+            rebuilding.store(false);
+        }
+        rebuildDone.notify_all();
+    }
+
+public:
+    AutotunedStore(Factory storeFactory, int height, const AutotuneConfig& cfg = AutotuneConfig())
+      : factory(std::move(storeFactory)), config(cfg), current(factory(height)), logging(false),
+        rebuilding(false), opCount(0), lastSampleOps(0), lastFullEvictions(0) {
+        if (config.sampleInterval == 0) config.sampleInterval = 1;
+        tune.treeHeight = height;
+    }
+
+    ~AutotunedStore() override {
+        std::lock_guard<std::mutex> lock(rebuilderMtx);
+        if (rebuilder.joinable()) rebuilder.join();
+    }
+
+    void oblivious_insert(const K& key, const V& value) override {
+        throttle();
+        {
+            std::shared_lock<std::shared_mutex> lock(storeMtx);
+            write([&] { current->oblivious_insert(key, value); },
+                  [&](std::vector<LogEntry>& l) { l.push_back(LogEntry{LogOp::Insert, key, value, nullptr}); });
+        }
+        note_ops(1);
+    }
+
+    bool oblivious_lookup(const K& key, V& value) override {
+        bool found;
+        {
+            std::shared_lock<std::shared_mutex> lock(storeMtx);
+            found = current->oblivious_lookup(key, value);
+        }
+        note_ops(1);
+        return found;
+    }
+
+    bool oblivious_remove(const K& key, V* value = nullptr) override {
+        bool found;
+        {
+            std::shared_lock<std::shared_mutex> lock(storeMtx);
+            found = write([&] { return current->oblivious_remove(key, value); },
+                          [&](std::vector<LogEntry>& l) { l.push_back(LogEntry{LogOp::Remove, key, V(), nullptr}); });
+        }
+        note_ops(1);
+        return found;
+    }
+
+    void oblivious_insert_batch(const std::vector<std::pair<K,V>>& items) override {
+        throttle();
+        {
+            std::shared_lock<std::shared_mutex> lock(storeMtx);
+            write([&] { current->oblivious_insert_batch(items); },
+                  [&](std::vector<LogEntry>& l) {
+                      for (const auto& item : items) l.push_back(LogEntry{LogOp::Insert, item.first, item.second, nullptr});
+                  });
+        }
+        note_ops(items.size());
+    }
+
+    size_t oblivious_lookup_batch(const std::vector<K>& keys, std::vector<V>& values,
+                                  std::vector<bool>& found) override {
+        size_t hits;
+        {
+            std::shared_lock<std::shared_mutex> lock(storeMtx);
+            hits = current->oblivious_lookup_batch(keys, values, found);
+        }
+        note_ops(keys.size());
+        return hits;
+    }
+
+    size_t expire_entries(const ExpiryPredicate& expired) override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        return write([&] { return current->expire_entries(expired); },
+                     [&](std::vector<LogEntry>& l) { l.push_back(LogEntry{LogOp::Expire, K(), V(), expired}); });
+    }
+
+    void oblivious_dummy_access() override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        current->oblivious_dummy_access();
+    }
+
+    void trigger_full_eviction() override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        current->trigger_full_eviction();
+    }
+
+    void bulk_load(const std::vector<std::pair<K,V>>& entries) override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        current->bulk_load(entries);
+    }
+
+    void save_snapshot(std::ostream& out) override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        current->save_snapshot(out);
+    }
+
+    void load_snapshot(std::istream& in) override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        current->load_snapshot(in);
+    }
+
+    size_t getStashSize() const override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        return current->getStashSize();
+    }
+
+    size_t size() const override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        return current->size();
+    }
+
+    OramStats getStats() const override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        OramStats stats = current->getStats();
+        std::lock_guard<std::mutex> tuneLock(tuneMtx);
+        stats.merge(retiredStats);
+        return stats;
+    }
+
+    void resetStats() override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        current->resetStats();
+        std::lock_guard<std::mutex> tuneLock(tuneMtx);
+        retiredStats.clear();
+        lastFullEvictions = 0;
+    }
+
+    bool isUnderPressure() const override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        return current->isUnderPressure();
+    }
+
+    int getTreeHeight() const override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        return current->getTreeHeight();
+    }
+
+    int getBucketCapacity() const override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        return current->getBucketCapacity();
+    }
+
+    size_t getStashLimit() const override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        return current->getStashLimit();
+    }
+
+    OramEngine getEngine() const override {
+        std::shared_lock<std::shared_mutex> lock(storeMtx);
+        return current->getEngine();
+    }
+
+    AutotuneStats getAutotuneStats() const {
+        std::lock_guard<std::mutex> lock(tuneMtx);
+        return tune;
+    }
+
+    // Blocks until a running rebuild has swapped in its tree.
+    void wait_for_rebuild() {
+        std::unique_lock<std::mutex> lock(doneMtx);
+        rebuildDone.wait(lock, [this] { return !rebuilding.load(); });
+    }
+};
+
+#endif
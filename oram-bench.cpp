@@ -0,0 +1,629 @@
+// Microbenchmarks for the ORAM primitives, one number per primitive:
+//   ./oram-bench [--filter=substr] [--quick] [--min-time=s] [--repetitions=n]
+//                [--csv=file] [--save=file] [--baseline=file] [--tolerance=f] [--list]
+// Each case runs across tree heights and bucket capacities and reports
+// ns/op, cycles/op (TSC reference cycles), heap allocations/op and bytes
+// touched/op. --save writes the results as a baseline; --baseline compares
+// against one and exits non-zero on a regression.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "crypto.hpp"
+#include "secure-random.hpp"
+#include "path-eviction.hpp"
+#include "tree-map.hpp"
+#include "tree-queue.hpp"
+
+// -------------------------
+// Configuration Parameters
+// -------------------------
+constexpr double BENCH_MIN_TIME_DEFAULT = 0.05;     // Seconds per measured run
+constexpr int BENCH_REPETITIONS_DEFAULT = 3;        // Measured runs per case; the fastest is reported
+constexpr double BENCH_TOLERANCE_DEFAULT = 0.25;    // Allowed slowdown against the baseline
+constexpr double BENCH_NOISE_FLOOR_NS = 5.0;        // Slowdowns below this are never regressions
+constexpr size_t BENCH_KEY_BYTES = 15;
+constexpr size_t BENCH_VALUE_BYTES = 64;
+
+// -------------------------
+// Allocation Counting
+// -------------------------
+// Every global allocation is counted, including the nothrow and aligned
+// forms; BenchState reads the counter around the timed region. GCC cannot
+// see that the replaced operator new pairs with free(), hence the pragma.
+static std::atomic<uint64_t> benchAllocations(0);
+static std::atomic<uint64_t> benchAllocatedBytes(0);
+
+static void* bench_allocate(size_t size, size_t alignment) noexcept {
+    benchAllocations.fetch_add(1, std::memory_order_relaxed);
+    benchAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+    // aligned_alloc wants a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+void* operator new(size_t size) {
+    if (void* p = bench_allocate(size, 0)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return bench_allocate(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return bench_allocate(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (void* p = bench_allocate(size, static_cast<size_t>(alignment))) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return bench_allocate(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return bench_allocate(size, static_cast<size_t>(alignment));
+}
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
+
+inline uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Keeps `value` alive so the computation behind it is not optimised away.
+template<typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// -------------------------
+// BenchState
+// -------------------------
+// Loop driver in the style of google-benchmark's State:
+//   while (state.keep_running()) { ... }
+// runs exactly `iterations` times with timing on; pause_timing() and
+// resume_timing() exclude per-iteration setup from time and allocations.
+class BenchState {
+private:
+    uint64_t target;
+    uint64_t done;
+    bool timing;
+    std::chrono::steady_clock::time_point startTime;
+    uint64_t startCycles;
+    uint64_t startAllocs;
+    uint64_t startAllocBytes;
+
+public:
+    uint64_t ns = 0;
+    uint64_t cycles = 0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+    uint64_t bytesTouched = 0;     // set by the case, over all iterations
+
+    explicit BenchState(uint64_t iterations)
+      : target(iterations), done(0), timing(false), startCycles(0), startAllocs(0), startAllocBytes(0) {}
+
+    bool keep_running() {
+        if (done == 0) resume_timing();
+        if (done == target) {
+            pause_timing();
+            return false;
+        }
+        done++;
+        return true;
+    }
+
+    void resume_timing() {
+        timing = true;
+        startAllocs = benchAllocations.load(std::memory_order_relaxed);
+        startAllocBytes = benchAllocatedBytes.load(std::memory_order_relaxed);
+        startTime = std::chrono::steady_clock::now();
+        startCycles = read_cycles();
+    }
+
+    void pause_timing() {
+        if (!timing) return;
+        uint64_t endCycles = read_cycles();
+        auto endTime = std::chrono::steady_clock::now();
+        cycles += endCycles - startCycles;
+        ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+        allocations += benchAllocations.load(std::memory_order_relaxed) - startAllocs;
+        allocatedBytes += benchAllocatedBytes.load(std::memory_order_relaxed) - startAllocBytes;
+        timing = false;
+    }
+
+    uint64_t iterations() const { return target; }
+};
+
+// -------------------------
+// Access to ObliviousMap internals
+// -------------------------
+// Friend of ObliviousMap. The primitives expect the map's mutex to be held.
+struct OramBenchAccess {
+    template<typename Map>
+    static std::mutex& mutex(Map& map) { return map.mtx; }
+    template<typename Map>
+    static std::vector<int> path_indices(Map& map, size_t leaf) { return map.get_path_indices(leaf); }
+    template<typename Map>
+    static void read_path(Map& map, size_t leaf) { map.read_path(leaf); }
+    template<typename Map>
+    static void write_path(Map& map, size_t leaf) { map.write_path(leaf); }
+    template<typename Map>
+    static void full_eviction(Map& map) { map.full_eviction(/*emergency=*/true); }
+    template<typename Map>
+    static size_t stash_size(Map& map) { return map.stash.size(); }
+};
+
+// -------------------------
+// Fixtures
+// -------------------------
+inline std::string bench_key(size_t i) {
+    std::string digits = std::to_string(i);
+    return "/bench/" + std::string(BENCH_KEY_BYTES - 7 - digits.size(), '0') + digits;
+}
+
+// Bytes a block occupies in a bucket: key, value ciphertext, leaf and flags.
+inline size_t bench_block_bytes() {
+    static const size_t bytes = BENCH_KEY_BYTES + secure_encrypt_string(std::string(BENCH_VALUE_BYTES, 'v')).size()
+                                + sizeof(size_t) + 1;
+    return bytes;
+}
+
+// A string map filled to a quarter of its slots.
+struct MapFixture {
+    using Map = ObliviousMap<std::string, std::string>;
+    int height;
+    std::unique_ptr<Map> map;
+    std::vector<std::string> keys;
+    std::mt19937_64 rng;
+
+    MapFixture(int h, int z, size_t stashLimit = STASH_LIMIT_DEFAULT) : height(h), rng(42) {
+        size_t slots = ((static_cast<size_t>(2) << h) - 1) * z;
+        std::vector<std::pair<std::string, std::string>> entries;
+        for (size_t i = 0; i < std::max<size_t>(slots / 4, 1); i++) {
+            keys.push_back(bench_key(i));
+            entries.emplace_back(keys.back(), std::string(BENCH_VALUE_BYTES, 'v'));
+        }
+        map.reset(new Map(h, stashLimit, z));
+        map->bulk_load(entries);
+    }
+
+    size_t random_leaf() { return rng() & ((static_cast<size_t>(1) << height) - 1); }
+    const std::string& random_key() { return keys[rng() % keys.size()]; }
+
+    uint64_t blocks_moved() const {
+        OramStats stats = map->getStats();
+        return stats.blocksRead + stats.blocksWritten;
+    }
+};
+
+// -------------------------
+// Cases
+// -------------------------
+struct BenchCase {
+    std::string name;
+    int height;       // 0 for cases without a tree
+    int capacity;
+    // Builds the fixture and returns the measured body
+    std::function<std::function<void(BenchState&)>()> make;
+};
+
+std::string case_name(const std::string& base, int height, int capacity) {
+    if (height == 0) return base;
+    return base + "/h=" + std::to_string(height) + "/z=" + std::to_string(capacity);
+}
+
+void add_tree_cases(std::vector<BenchCase>& cases, int h, int z) {
+    auto add = [&](const std::string& name, std::function<std::function<void(BenchState&)>()> make) {
+        cases.push_back(BenchCase{case_name(name, h, z), h, z, std::move(make)});
+    };
+
+    add("path_indices", [h, z] {
+        auto f = std::make_shared<MapFixture>(h, z);
+        return std::function<void(BenchState&)>([f, h](BenchState& state) {
+            std::lock_guard<std::mutex> lock(OramBenchAccess::mutex(*f->map));
+            while (state.keep_running()) {
+                std::vector<int> path = OramBenchAccess::path_indices(*f->map, f->random_leaf());
+                do_not_optimize(path[0]);
+            }
+            state.bytesTouched = state.iterations() * (h + 1) * sizeof(int);
+        });
+    });
+
+    add("read_path", [h, z] {
+        auto f = std::make_shared<MapFixture>(h, z);
+        return std::function<void(BenchState&)>([f](BenchState& state) {
+            OramStats before = f->map->getStats();
+            {
+                std::lock_guard<std::mutex> lock(OramBenchAccess::mutex(*f->map));
+                while (state.keep_running()) {
+                    size_t leaf = f->random_leaf();
+                    OramBenchAccess::read_path(*f->map, leaf);
+                    state.pause_timing();
+                    OramBenchAccess::write_path(*f->map, leaf);
+                    state.resume_timing();
+                }
+            }
+            state.bytesTouched = (f->map->getStats().blocksRead - before.blocksRead) * bench_block_bytes();
+        });
+    });
+
+    add("write_path", [h, z] {
+        auto f = std::make_shared<MapFixture>(h, z);
+        return std::function<void(BenchState&)>([f](BenchState& state) {
+            OramStats before = f->map->getStats();
+            {
+                std::lock_guard<std::mutex> lock(OramBenchAccess::mutex(*f->map));
+                while (state.keep_running()) {
+                    size_t leaf = f->random_leaf();
+                    state.pause_timing();
+                    OramBenchAccess::read_path(*f->map, leaf);
+                    state.resume_timing();
+                    OramBenchAccess::write_path(*f->map, leaf);
+                }
+            }
+            state.bytesTouched = (f->map->getStats().blocksWritten - before.blocksWritten) * bench_block_bytes();
+        });
+    });
+
+    add("full_eviction", [h, z] {
+        // A stash limit the fixture's entries can fill past full_eviction's
+        // threshold (0.3 of the limit) while staying below read_path's
+        // critical-eviction mark (0.5)
+        size_t slots = ((static_cast<size_t>(2) << h) - 1) * z;
+        size_t limit = std::max<size_t>(std::min<size_t>(STASH_LIMIT_DEFAULT, slots / 4), 8);
+        auto f = std::make_shared<MapFixture>(h, z, limit);
+        return std::function<void(BenchState&)>([f, limit](BenchState& state) {
+            OramStats before = f->map->getStats();
+            {
+                std::lock_guard<std::mutex> lock(OramBenchAccess::mutex(*f->map));
+                while (state.keep_running()) {
+                    state.pause_timing();
+                    for (int i = 0; i < 64 && OramBenchAccess::stash_size(*f->map) < limit * 45 / 100; i++) {
+                        OramBenchAccess::read_path(*f->map, f->random_leaf());
+                    }
+                    state.resume_timing();
+                    OramBenchAccess::full_eviction(*f->map);
+                }
+            }
+            // Blocks read to refill the stash are not part of the eviction
+            state.bytesTouched = (f->map->getStats().blocksWritten - before.blocksWritten) * bench_block_bytes();
+        });
+    });
+
+    add("map_insert", [h, z] {
+        auto f = std::make_shared<MapFixture>(h, z);
+        return std::function<void(BenchState&)>([f](BenchState& state) {
+            std::string value(BENCH_VALUE_BYTES, 'w');
+            uint64_t before = f->blocks_moved();
+            while (state.keep_running()) f->map->oblivious_insert(f->random_key(), value);
+            state.bytesTouched = (f->blocks_moved() - before) * bench_block_bytes();
+        });
+    });
+
+    add("map_lookup", [h, z] {
+        auto f = std::make_shared<MapFixture>(h, z);
+        return std::function<void(BenchState&)>([f](BenchState& state) {
+            std::string value;
+            uint64_t before = f->blocks_moved();
+            while (state.keep_running()) {
+                bool found = f->map->oblivious_lookup(f->random_key(), value);
+                do_not_optimize(found);
+            }
+            state.bytesTouched = (f->blocks_moved() - before) * bench_block_bytes();
+        });
+    });
+
+    // Push and pop are timed separately, each paired with the other
+    // untimed so the queue length stays put
+    auto queueCase = [h, z](bool timePush) {
+        return [h, z, timePush] {
+            size_t slots = ((static_cast<size_t>(2) << h) - 1) * z;
+            auto queue = std::make_shared<ObliviousQueue<std::string>>(h, QUEUE_STASH_LIMIT_DEFAULT, z);
+            std::string item(BENCH_VALUE_BYTES, 'q');
+            for (size_t i = 0; i < std::max<size_t>(slots / 8, 1); i++) queue->oblivious_push(item);
+            return std::function<void(BenchState&)>([queue, item, timePush](BenchState& state) {
+                std::string out;
+                OramStats before = queue->getStats();
+                while (state.keep_running()) {
+                    if (!timePush) state.pause_timing();
+                    queue->oblivious_push(item);
+                    if (!timePush) state.resume_timing();
+                    else state.pause_timing();
+                    queue->oblivious_pop(out);
+                    if (timePush) state.resume_timing();
+                }
+                OramStats after = queue->getStats();
+                // Both operations move about the same blocks; charge half to the timed one
+                size_t blockBytes = secure_encrypt_string(item).size() + sizeof(uint64_t) * 2;
+                state.bytesTouched = (after.blocksRead + after.blocksWritten - before.blocksRead - before.blocksWritten)
+                                     / 2 * blockBytes;
+            });
+        };
+    };
+    add("queue_push", queueCase(true));
+    add("queue_pop", queueCase(false));
+}
+
+std::vector<BenchCase> build_cases(bool quick) {
+    std::vector<BenchCase> cases;
+
+    cases.push_back(BenchCase{"secure_encrypt_string", 0, 0, [] {
+        return std::function<void(BenchState&)>([](BenchState& state) {
+            std::string plaintext(BENCH_VALUE_BYTES, 'p');
+            size_t cipherBytes = 0;
+            while (state.keep_running()) {
+                std::string ciphertext = secure_encrypt_string(plaintext);
+                cipherBytes = ciphertext.size();
+                do_not_optimize(ciphertext[0]);
+            }
+            state.bytesTouched = state.iterations() * (plaintext.size() + cipherBytes);
+        });
+    }});
+
+    cases.push_back(BenchCase{"secure_decrypt_string", 0, 0, [] {
+        return std::function<void(BenchState&)>([](BenchState& state) {
+            std::string ciphertext = secure_encrypt_string(std::string(BENCH_VALUE_BYTES, 'p'));
+            while (state.keep_running()) {
+                std::string plaintext = secure_decrypt_string(ciphertext);
+                do_not_optimize(plaintext[0]);
+            }
+            state.bytesTouched = state.iterations() * (ciphertext.size() + BENCH_VALUE_BYTES);
+        });
+    }});
+
+    cases.push_back(BenchCase{"secure_random", 0, 0, [] {
+        return std::function<void(BenchState&)>([](BenchState& state) {
+            while (state.keep_running()) {
+                uint32_t r = secure_random();
+                do_not_optimize(r);
+            }
+            state.bytesTouched = state.iterations() * sizeof(uint32_t);
+        });
+    }});
+
+    std::vector<int> heights = quick ? std::vector<int>{4, 8} : std::vector<int>{4, 8, 12, 16};
+    std::vector<int> capacities = quick ? std::vector<int>{4} : std::vector<int>{2, 4, 8};
+    for (int h : heights) {
+        for (int z : capacities) add_tree_cases(cases, h, z);
+    }
+    return cases;
+}
+
+// -------------------------
+// Runner
+// -------------------------
+struct BenchResult {
+    std::string name;
+    int height = 0;
+    int capacity = 0;
+    uint64_t iterations = 0;
+    double nsPerOp = 0;
+    double cyclesPerOp = 0;
+    double allocsPerOp = 0;
+    double allocBytesPerOp = 0;
+    double bytesPerOp = 0;
+};
+
+BenchResult to_result(const BenchCase& c, const BenchState& state) {
+    BenchResult r;
+    r.name = c.name;
+    r.height = c.height;
+    r.capacity = c.capacity;
+    r.iterations = state.iterations();
+    double n = static_cast<double>(state.iterations());
+    r.nsPerOp = state.ns / n;
+    r.cyclesPerOp = state.cycles / n;
+    r.allocsPerOp = state.allocations / n;
+    r.allocBytesPerOp = state.allocatedBytes / n;
+    r.bytesPerOp = state.bytesTouched / n;
+    return r;
+}
+
+// Grows the iteration count until one run takes minTime, then keeps the
+// fastest of `repetitions` runs at that count.
+BenchResult run_case(const BenchCase& c, double minTime, int repetitions) {
+    std::function<void(BenchState&)> body = c.make();
+    uint64_t iterations = 1;
+    uint64_t minNs = static_cast<uint64_t>(minTime * 1e9);
+    while (true) {
+        BenchState probe(iterations);
+        body(probe);
+        if (probe.ns >= minNs || iterations >= 1000000000ULL) break;
+        double scale = probe.ns > 0 ? 1.4 * minNs / probe.ns : 100.0;
+        iterations = static_cast<uint64_t>(iterations * std::min(std::max(scale, 2.0), 100.0));
+    }
+
+    BenchResult best;
+    for (int rep = 0; rep < repetitions; rep++) {
+        BenchState state(iterations);
+        body(state);
+        BenchResult r = to_result(c, state);
+        if (rep == 0 || r.nsPerOp < best.nsPerOp) best = r;
+    }
+    return best;
+}
+
+void write_results_csv(const std::string& filename, const std::vector<BenchResult>& results) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << "\n";
+        return;
+    }
+    file << "Benchmark,Height,Capacity,Iterations,NsPerOp,CyclesPerOp,AllocsPerOp,AllocBytesPerOp,BytesTouchedPerOp\n";
+    for (const auto& r : results) {
+        file << r.name << "," << r.height << "," << r.capacity << "," << r.iterations << ","
+             << r.nsPerOp << "," << r.cyclesPerOp << "," << r.allocsPerOp << ","
+             << r.allocBytesPerOp << "," << r.bytesPerOp << "\n";
+    }
+    std::cout << "Results saved to " << filename << "\n";
+}
+
+std::map<std::string, BenchResult> read_results_csv(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) throw std::runtime_error("Cannot open baseline: " + filename);
+    std::map<std::string, BenchResult> results;
+    std::string line;
+    std::getline(file, line);   // header
+    while (std::getline(file, line)) {
+        if (line.empty()) continue;
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, ',')) fields.push_back(field);
+        if (fields.size() < 9) throw std::runtime_error("Malformed baseline line: " + line);
+        BenchResult r;
+        r.name = fields[0];
+        r.height = std::stoi(fields[1]);
+        r.capacity = std::stoi(fields[2]);
+        r.iterations = std::stoull(fields[3]);
+        r.nsPerOp = std::stod(fields[4]);
+        r.cyclesPerOp = std::stod(fields[5]);
+        r.allocsPerOp = std::stod(fields[6]);
+        r.allocBytesPerOp = std::stod(fields[7]);
+        r.bytesPerOp = std::stod(fields[8]);
+        results[r.name] = r;
+    }
+    return results;
+}
+
+// Regression gate: slower than the baseline by more than `tolerance` (and
+// the noise floor), or more than half an allocation per op more. Returns
+// the number of regressions.
+int compare_with_baseline(const std::vector<BenchResult>& results, const std::map<std::string, BenchResult>& baseline,
+                          double tolerance) {
+    int regressions = 0, improvements = 0, missing = 0;
+    std::cout << "\n===== Baseline Comparison (tolerance " << tolerance * 100 << "%) =====\n";
+    for (const auto& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end()) {
+            missing++;
+            continue;
+        }
+        const BenchResult& base = it->second;
+        double ratio = base.nsPerOp > 0 ? r.nsPerOp / base.nsPerOp : 1.0;
+        bool slower = ratio > 1.0 + tolerance && r.nsPerOp - base.nsPerOp > BENCH_NOISE_FLOOR_NS;
+        bool moreAllocs = r.allocsPerOp > base.allocsPerOp + 0.5;
+        if (slower || moreAllocs) {
+            regressions++;
+            std::cout << "REGRESSION " << r.name << ": " << base.nsPerOp << " -> " << r.nsPerOp << " ns/op (x"
+                      << ratio << "), " << base.allocsPerOp << " -> " << r.allocsPerOp << " allocs/op\n";
+        } else if (ratio < 1.0 - tolerance) {
+            improvements++;
+            std::cout << "improved   " << r.name << ": " << base.nsPerOp << " -> " << r.nsPerOp << " ns/op (x"
+                      << ratio << ")\n";
+        }
+    }
+    std::cout << regressions << " regressions, " << improvements << " improvements, "
+              << missing << " cases not in the baseline\n";
+    return regressions;
+}
+
+int main(int argc, char* argv[]) {
+    // Stash warnings are expected while the fixtures are driven hard
+    OramLog::set_level(ORAM_LOG_LEVEL_ERROR);
+    OramLog::configure_from_env();
+    std::string filter, csvPath = "results/bench_results.csv", savePath, baselinePath;
+    bool quick = false, listOnly = false;
+    double minTime = BENCH_MIN_TIME_DEFAULT, tolerance = BENCH_TOLERANCE_DEFAULT;
+    int repetitions = BENCH_REPETITIONS_DEFAULT;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&arg](const char* flag) -> const char* {
+            size_t n = std::char_traits<char>::length(flag);
+            return arg.compare(0, n, flag) == 0 ? arg.c_str() + n : nullptr;
+        };
+        if (const char* v = value("--filter=")) filter = v;
+        else if (const char* v = value("--min-time=")) minTime = std::stod(v);
+        else if (const char* v = value("--repetitions=")) repetitions = std::max(1, std::stoi(v));
+        else if (const char* v = value("--csv=")) csvPath = v;
+        else if (const char* v = value("--save=")) savePath = v;
+        else if (const char* v = value("--baseline=")) baselinePath = v;
+        else if (const char* v = value("--tolerance=")) tolerance = std::stod(v);
+        else if (arg == "--quick") quick = true;
+        else if (arg == "--list") listOnly = true;
+        else {
+            std::cerr << "Usage: oram-bench [--filter=substr] [--quick] [--min-time=s] [--repetitions=n]\n"
+                      << "                  [--csv=file] [--save=file] [--baseline=file] [--tolerance=f] [--list]\n";
+            return 1;
+        }
+    }
+
+    std::vector<BenchCase> cases = build_cases(quick);
+    std::vector<BenchResult> results;
+    if (!listOnly) {
+        std::cout << std::left << std::setw(32) << "Benchmark" << std::right << std::setw(12) << "ns/op"
+                  << std::setw(12) << "cycles/op" << std::setw(11) << "allocs/op" << std::setw(13) << "bytes/op"
+                  << std::setw(12) << "iterations" << "\n";
+    }
+    for (const auto& c : cases) {
+        if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+        if (listOnly) {
+            std::cout << c.name << "\n";
+            continue;
+        }
+        try {
+            BenchResult r = run_case(c, minTime, repetitions);
+            std::cout << std::left << std::setw(32) << r.name << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(12) << r.nsPerOp << std::setw(12) << r.cyclesPerOp
+                      << std::setprecision(2) << std::setw(11) << r.allocsPerOp
+                      << std::setprecision(0) << std::setw(13) << r.bytesPerOp
+                      << std::setw(12) << r.iterations << "\n";
+            results.push_back(r);
+        } catch (const std::exception& ex) {
+            std::cerr << "ERROR in " << c.name << ": " << ex.what() << "\n";
+            return 1;
+        }
+    }
+    if (listOnly) return 0;
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+
+    write_results_csv(csvPath, results);
+    if (!savePath.empty()) write_results_csv(savePath, results);
+    if (!baselinePath.empty()) {
+        try {
+            if (compare_with_baseline(results, read_results_csv(baselinePath), tolerance) > 0) return 1;
+        } catch (const std::exception& ex) {
+            std::cerr << "ERROR: " << ex.what() << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
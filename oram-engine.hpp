@@ -0,0 +1,314 @@
+#ifndef ORAM_ENGINE_HPP
+#define ORAM_ENGINE_HPP
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <string>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+
+#include "path-eviction.hpp"
+#include "tree-map.hpp"
+#include "ring-map.hpp"
+#include "mapped-storage.hpp"
+#include "hashed-name.hpp"
+
+// -------------------------
+// ORAM Engines
+// -------------------------
+// Path: ObliviousMap (PathORAM, reads and rewrites whole paths).
+// Ring: RingObliviousMap (Ring ORAM, one slot per bucket per access).
+enum class OramEngine { Path, Ring };
+
+inline const char* oram_engine_name(OramEngine engine) {
+    return engine == OramEngine::Ring ? "ring" : "path";
+}
+
+// Position map of a Path engine tree (see position-map.hpp):
+// Hash: HashPositionMap, one exact entry per key.
+// Compact: CompactPositionMap, a fixed array of packed leaves.
+// Recursive: RecursivePositionMap, leaves stored in a smaller ORAM.
+enum class PositionMapKind { Hash, Compact, Recursive };
+
+inline const char* position_map_name(PositionMapKind kind) {
+    switch (kind) {
+    case PositionMapKind::Compact: return "compact";
+    case PositionMapKind::Recursive: return "recursive";
+    default: return "hash";
+    }
+}
+
+// -------------------------
+// ObliviousStore (type-erased key-value ORAM)
+// -------------------------
+// The operations ShardedObliviousMap needs from a shard, so the engine can
+// be chosen at run time. One virtual call per operation is noise next to a
+// path access.
+template<typename K, typename V>
+class ObliviousStore {
+public:
+    using ExpiryPredicate = std::function<bool(const K&, const V&)>;
+
+    virtual ~ObliviousStore() = default;
+
+    virtual void oblivious_insert(const K& key, const V& value) = 0;
+    virtual bool oblivious_lookup(const K& key, V& value) = 0;
+    virtual bool oblivious_remove(const K& key, V* value = nullptr) = 0;
+    virtual void oblivious_insert_batch(const std::vector<std::pair<K,V>>& items) = 0;
+    virtual size_t oblivious_lookup_batch(const std::vector<K>& keys, std::vector<V>& values,
+                                          std::vector<bool>& found) = 0;
+    virtual size_t expire_entries(const ExpiryPredicate& expired) = 0;
+    virtual void oblivious_dummy_access() = 0;
+    virtual void trigger_full_eviction() = 0;
+    virtual void bulk_load(const std::vector<std::pair<K,V>>& entries) = 0;
+    virtual void save_snapshot(std::ostream& out) = 0;
+    virtual void load_snapshot(std::istream& in) = 0;
+
+    virtual size_t getStashSize() const = 0;
+    virtual size_t size() const = 0;
+    virtual OramStats getStats() const = 0;
+    virtual void resetStats() = 0;
+    virtual bool isUnderPressure() const = 0;
+    virtual int getTreeHeight() const = 0;
+    virtual int getBucketCapacity() const = 0;
+    virtual size_t getStashLimit() const = 0;
+    virtual OramEngine getEngine() const = 0;
+};
+
+// Forwards every ObliviousStore call to a concrete map.
+template<typename K, typename V, typename Map, OramEngine Engine>
+class ObliviousStoreAdapter : public ObliviousStore<K,V> {
+private:
+    Map map;
+
+public:
+    template<typename... Args>
+    explicit ObliviousStoreAdapter(Args&&... args) : map(std::forward<Args>(args)...) {}
+
+    void oblivious_insert(const K& key, const V& value) override { map.oblivious_insert(key, value); }
+    bool oblivious_lookup(const K& key, V& value) override { return map.oblivious_lookup(key, value); }
+    bool oblivious_remove(const K& key, V* value = nullptr) override { return map.oblivious_remove(key, value); }
+    void oblivious_insert_batch(const std::vector<std::pair<K,V>>& items) override {
+        map.oblivious_insert_batch(items);
+    }
+    size_t oblivious_lookup_batch(const std::vector<K>& keys, std::vector<V>& values,
+                                  std::vector<bool>& found) override {
+        return map.oblivious_lookup_batch(keys, values, found);
+    }
+    size_t expire_entries(const typename ObliviousStore<K,V>::ExpiryPredicate& expired) override {
+        return map.expire_entries(expired);
+    }
+    void oblivious_dummy_access() override { map.oblivious_dummy_access(); }
+    void trigger_full_eviction() override { map.trigger_full_eviction(); }
+    void bulk_load(const std::vector<std::pair<K,V>>& entries) override { map.bulk_load(entries); }
+    void save_snapshot(std::ostream& out) override { map.save_snapshot(out); }
+    void load_snapshot(std::istream& in) override { map.load_snapshot(in); }
+
+    size_t getStashSize() const override { return map.getStashSize(); }
+    size_t size() const override { return map.size(); }
+    OramStats getStats() const override { return map.getStats(); }
+    void resetStats() override { map.resetStats(); }
+    bool isUnderPressure() const override { return map.isUnderPressure(); }
+    int getTreeHeight() const override { return map.getTreeHeight(); }
+    int getBucketCapacity() const override { return map.getBucketCapacity(); }
+    size_t getStashLimit() const override { return map.getStashLimit(); }
+    OramEngine getEngine() const override { return Engine; }
+
+    Map& get() { return map; }
+};
+
+// -------------------------
+// HashedNameStore (NDN names over NameKey-keyed ORAM)
+// -------------------------
+// Presents a string-keyed store over an inner store keyed by hash_name().
+// The inner ORAM only ever sees 16-byte keys; the name is kept at the front
+// of the value, as [name length (4 bytes LE)][name][value], and so is
+// encrypted with it. Every read compares the stored name with the one asked
+// for and throws on a mismatch, so a 128-bit collision can never hand out
+// another name's value silently. Stateless apart from the inner store, so
+// it is as thread-safe as the store it wraps.
+class HashedNameStore : public ObliviousStore<std::string, std::string> {
+private:
+    std::unique_ptr<ObliviousStore<NameKey, std::string>> inner;
+
+    static std::string pack(const std::string& name, const std::string& value) {
+        if (name.size() > UINT32_MAX)
+            throw std::invalid_argument("Name too long for HashedNameStore");
+        std::string payload;
+        payload.reserve(4 + name.size() + value.size());
+        uint32_t length = static_cast<uint32_t>(name.size());
+        for (int i = 0; i < 4; i++) payload.push_back(static_cast<char>((length >> (8 * i)) & 0xff));
+        payload.append(name);
+        payload.append(value);
+        return payload;
+    }
+
+    // Splits a payload into its name and value; false if it is malformed.
+    static bool split(const std::string& payload, std::string& name, std::string* value) {
+        if (payload.size() < 4) return false;
+        uint32_t length = 0;
+        for (int i = 0; i < 4; i++) length |= static_cast<uint32_t>(static_cast<unsigned char>(payload[i])) << (8 * i);
+        if (payload.size() - 4 < length) return false;
+        name.assign(payload, 4, length);
+        if (value) value->assign(payload, 4 + length, std::string::npos);
+        return true;
+    }
+
+    // Value of `name` from a payload read under hash_name(name).
+    static void unpack(const std::string& payload, const std::string& name, std::string& value) {
+        thread_local std::string stored;
+        if (!split(payload, stored, &value) || stored != name)
+            throw std::runtime_error("NameKey collision or corrupt payload in HashedNameStore");
+    }
+
+public:
+    explicit HashedNameStore(std::unique_ptr<ObliviousStore<NameKey, std::string>> store)
+      : inner(std::move(store)) {}
+
+    void oblivious_insert(const std::string& key, const std::string& value) override {
+        inner->oblivious_insert(hash_name(key), pack(key, value));
+    }
+
+    bool oblivious_lookup(const std::string& key, std::string& value) override {
+        thread_local std::string payload;
+        if (!inner->oblivious_lookup(hash_name(key), payload)) return false;
+        unpack(payload, key, value);
+        return true;
+    }
+
+    bool oblivious_remove(const std::string& key, std::string* value = nullptr) override {
+        thread_local std::string payload;
+        if (!inner->oblivious_remove(hash_name(key), &payload)) return false;
+        if (value) unpack(payload, key, *value);
+        return true;
+    }
+
+    void oblivious_insert_batch(const std::vector<std::pair<std::string, std::string>>& items) override {
+        std::vector<std::pair<NameKey, std::string>> hashed;
+        hashed.reserve(items.size());
+        for (const auto& item : items) hashed.emplace_back(hash_name(item.first), pack(item.first, item.second));
+        inner->oblivious_insert_batch(hashed);
+    }
+
+    size_t oblivious_lookup_batch(const std::vector<std::string>& keys, std::vector<std::string>& values,
+                                  std::vector<bool>& found) override {
+        std::vector<NameKey> hashed;
+        hashed.reserve(keys.size());
+        for (const auto& key : keys) hashed.push_back(hash_name(key));
+        std::vector<std::string> payloads;
+        size_t hits = inner->oblivious_lookup_batch(hashed, payloads, found);
+        values.assign(keys.size(), std::string());
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (found[i]) unpack(payloads[i], keys[i], values[i]);
+        }
+        return hits;
+    }
+
+    size_t expire_entries(const ExpiryPredicate& expired) override {
+        std::string name, value;
+        return inner->expire_entries([&](const NameKey&, const std::string& payload) {
+            // A malformed payload cannot be attributed to a name; keep it
+            if (!split(payload, name, &value)) return false;
+            return expired(name, value);
+        });
+    }
+
+    void oblivious_dummy_access() override { inner->oblivious_dummy_access(); }
+    void trigger_full_eviction() override { inner->trigger_full_eviction(); }
+
+    // The inner store wants its own keys sorted, which is a different order.
+    void bulk_load(const std::vector<std::pair<std::string, std::string>>& entries) override {
+        std::vector<std::pair<NameKey, std::string>> hashed;
+        hashed.reserve(entries.size());
+        for (const auto& entry : entries) hashed.emplace_back(hash_name(entry.first), pack(entry.first, entry.second));
+        std::sort(hashed.begin(), hashed.end(),
+                  [](const std::pair<NameKey, std::string>& a, const std::pair<NameKey, std::string>& b) {
+                      return a.first < b.first;
+                  });
+        inner->bulk_load(hashed);
+    }
+
+    void save_snapshot(std::ostream& out) override { inner->save_snapshot(out); }
+    void load_snapshot(std::istream& in) override { inner->load_snapshot(in); }
+
+    size_t getStashSize() const override { return inner->getStashSize(); }
+    size_t size() const override { return inner->size(); }
+    OramStats getStats() const override { return inner->getStats(); }
+    void resetStats() override { inner->resetStats(); }
+    bool isUnderPressure() const override { return inner->isUnderPressure(); }
+    int getTreeHeight() const override { return inner->getTreeHeight(); }
+    int getBucketCapacity() const override { return inner->getBucketCapacity(); }
+    size_t getStashLimit() const override { return inner->getStashLimit(); }
+    OramEngine getEngine() const override { return inner->getEngine(); }
+};
+
+// Builds a Path engine store with the given position map, over a MappedTree
+// file when `storage` is set.
+template<typename K, typename V, typename PosMap>
+std::unique_ptr<ObliviousStore<K,V>> make_path_store(int height, size_t stash_limit, int bucket_capacity,
+                                                     EvictionMode mode, const MappedStorageConfig* storage) {
+    if (storage) {
+        if constexpr (std::is_same<K, std::string>::value && std::is_same<V, std::string>::value) {
+            using MappedMap = ObliviousMap<K, V, PosMap, MappedTree>;
+            return std::unique_ptr<ObliviousStore<K,V>>(
+                new ObliviousStoreAdapter<K, V, MappedMap, OramEngine::Path>(
+                    MappedTree(height, bucket_capacity, *storage), stash_limit, mode));
+        } else {
+            throw std::invalid_argument("Mapped storage needs string keys and values");
+        }
+    }
+    return std::unique_ptr<ObliviousStore<K,V>>(
+        new ObliviousStoreAdapter<K, V, ObliviousMap<K, V, PosMap>, OramEngine::Path>(
+            height, stash_limit, bucket_capacity, mode));
+}
+
+// Builds a store for the given engine. Ring ORAM always evicts
+// deterministically, so `mode` only applies to the Path engine. With
+// `storage` set, the Path engine keeps its buckets in a MappedTree file
+// (string keys and values only). With `hashed_keys` a string-keyed store is
+// a HashedNameStore over a NameKey-keyed one; mapped trees hold string
+// keys, so the two cannot be combined. `posmap` picks the Path engine's
+// position map; Ring ORAM keeps its own.
+template<typename K, typename V>
+std::unique_ptr<ObliviousStore<K,V>> make_oblivious_store(OramEngine engine, int height, size_t stash_limit,
+                                                          int bucket_capacity, EvictionMode mode,
+                                                          const MappedStorageConfig* storage = nullptr,
+                                                          bool hashed_keys = false,
+                                                          PositionMapKind posmap = PositionMapKind::Hash) {
+    if (hashed_keys) {
+        if constexpr (std::is_same<K, std::string>::value && std::is_same<V, std::string>::value) {
+            if (storage)
+                throw std::invalid_argument("Hashed keys cannot be combined with mapped storage");
+            return std::unique_ptr<ObliviousStore<K,V>>(new HashedNameStore(
+                make_oblivious_store<NameKey, std::string>(engine, height, stash_limit, bucket_capacity, mode,
+                                                           nullptr, false, posmap)));
+        } else {
+            throw std::invalid_argument("Hashed keys need string keys and values");
+        }
+    }
+    if (engine == OramEngine::Ring) {
+        if (storage)
+            throw std::invalid_argument("Mapped storage is only available for the Path engine");
+        if (posmap != PositionMapKind::Hash)
+            throw std::invalid_argument("Position map choice is only available for the Path engine");
+        return std::unique_ptr<ObliviousStore<K,V>>(
+            new ObliviousStoreAdapter<K, V, RingObliviousMap<K,V>, OramEngine::Ring>(
+                height, stash_limit, bucket_capacity));
+    }
+    if (engine != OramEngine::Path) throw std::invalid_argument("Unknown ORAM engine");
+    switch (posmap) {
+    case PositionMapKind::Compact:
+        return make_path_store<K, V, CompactPositionMap<K>>(height, stash_limit, bucket_capacity, mode, storage);
+    case PositionMapKind::Recursive:
+        return make_path_store<K, V, RecursivePositionMap<K>>(height, stash_limit, bucket_capacity, mode, storage);
+    default:
+        return make_path_store<K, V, HashPositionMap<K>>(height, stash_limit, bucket_capacity, mode, storage);
+    }
+}
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef ORAM_LOG_HPP
+#define ORAM_LOG_HPP
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+// -------------------------
+// Log Levels
+// -------------------------
+#define ORAM_LOG_LEVEL_TRACE 0
+#define ORAM_LOG_LEVEL_DEBUG 1
+#define ORAM_LOG_LEVEL_INFO  2
+#define ORAM_LOG_LEVEL_WARN  3
+#define ORAM_LOG_LEVEL_ERROR 4
+#define ORAM_LOG_LEVEL_OFF   5
+
+// Compile-time floor: calls below it are discarded by the compiler, message
+// formatting included. Build with -DORAM_LOG_LEVEL=ORAM_LOG_LEVEL_TRACE to
+// bring per-packet and per-round tracing back.
+#ifndef ORAM_LOG_LEVEL
+#define ORAM_LOG_LEVEL ORAM_LOG_LEVEL_INFO
+#endif
+
+constexpr size_t ORAM_LOG_QUEUE_LIMIT = 4096;   // async sink: pending lines before dropping
+
+// -------------------------
+// OramLog (process-wide logger)
+// -------------------------
+// Messages at or above the runtime level (WARN by default) go to the sink:
+//   - Stderr: written synchronously (default);
+//   - Async: queued and written by a background thread, so the caller only
+//     pays for formatting. A full queue drops lines instead of blocking and
+//     reports how many were lost;
+//   - Null: discarded.
+// configure_from_env() reads ORAM_LOG (trace|debug|info|warn|error|off) and
+// ORAM_LOG_SINK (stderr|async|null).
+class OramLog {
+public:
+    enum class Sink { Stderr, Async, Null };
+
+    static OramLog& instance() {
+        static OramLog log;
+        return log;
+    }
+
+    static bool enabled(int level) {
+        return level >= instance().level.load(std::memory_order_relaxed);
+    }
+
+    static void set_level(int level) { instance().level.store(level, std::memory_order_relaxed); }
+
+    static void set_sink(Sink sink) { instance().switch_sink(sink); }
+
+    static void configure_from_env() {
+        if (const char* name = std::getenv("ORAM_LOG")) {
+            int level = parse_level(name);
+            if (level >= 0) set_level(level);
+        }
+        if (const char* name = std::getenv("ORAM_LOG_SINK")) {
+            if (std::strcmp(name, "async") == 0) set_sink(Sink::Async);
+            else if (std::strcmp(name, "null") == 0) set_sink(Sink::Null);
+            else if (std::strcmp(name, "stderr") == 0) set_sink(Sink::Stderr);
+        }
+    }
+
+    // Level number for a name, or -1 if unknown.
+    static int parse_level(const char* name) {
+        static const char* names[] = {"trace", "debug", "info", "warn", "error", "off"};
+        for (int i = 0; i <= ORAM_LOG_LEVEL_OFF; i++) {
+            if (std::strcmp(name, names[i]) == 0) return i;
+        }
+        return -1;
+    }
+
+    static void write(int level, const std::string& message) { instance().emit(level, message); }
+
+    // Blocks until the async queue has been written out.
+    static void flush() { instance().drain(); }
+
+    ~OramLog() { switch_sink(Sink::Null); }
+
+private:
+    std::atomic<int> level;
+    std::atomic<int> sink;
+    std::mutex switchMtx;                // serialises sink changes
+    std::mutex mtx;                      // guards the async queue
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<std::string> pending;
+    std::thread writer;
+    bool stopping;
+    bool writing;
+    uint64_t dropped;
+
+    OramLog() : level(ORAM_LOG_LEVEL_WARN), sink(static_cast<int>(Sink::Stderr)),
+                stopping(false), writing(false), dropped(0) {}
+
+    static const char* level_tag(int level) {
+        static const char* tags[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+        return tags[level < 0 ? 0 : (level > ORAM_LOG_LEVEL_OFF ? ORAM_LOG_LEVEL_OFF : level)];
+    }
+
+    void emit(int lvl, const std::string& message) {
+        Sink current = static_cast<Sink>(sink.load(std::memory_order_acquire));
+        if (current == Sink::Null) return;
+        std::string line = std::string(level_tag(lvl)) + " " + message;
+        if (line.empty() || line.back() != '\n') line.push_back('\n');
+        if (current == Sink::Async) {
+            std::lock_guard<std::mutex> lock(mtx);
+            // switch_sink publishes the new sink before stopping the writer
+            // under this lock, so a line queued here is always written out
+            current = static_cast<Sink>(sink.load(std::memory_order_acquire));
+            if (current == Sink::Async) {
+                if (pending.size() >= ORAM_LOG_QUEUE_LIMIT) {
+                    dropped++;
+                    return;
+                }
+                pending.push_back(std::move(line));
+                wake.notify_one();
+                return;
+            }
+        }
+        if (current == Sink::Stderr) std::cerr << line;
+    }
+
+    void run() {
+        std::vector<std::string> batch;
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty() && stopping) break;
+            batch.swap(pending);
+            uint64_t lost = dropped;
+            dropped = 0;
+            writing = true;
+            lock.unlock();
+            for (const auto& line : batch) std::cerr << line;
+            if (lost) std::cerr << "WARN [OramLog] dropped " << lost << " log lines (queue full)\n";
+            std::cerr.flush();
+            batch.clear();
+            lock.lock();
+            writing = false;
+            idle.notify_all();
+        }
+    }
+
+    void drain() {
+        if (static_cast<Sink>(sink.load(std::memory_order_acquire)) != Sink::Async) return;
+        std::unique_lock<std::mutex> lock(mtx);
+        idle.wait(lock, [this] { return pending.empty() && !writing; });
+    }
+
+    void switch_sink(Sink next) {
+        std::lock_guard<std::mutex> guard(switchMtx);
+        Sink current = static_cast<Sink>(sink.load(std::memory_order_acquire));
+        if (current == next) return;
+        if (current == Sink::Async) {
+            // New lines take the new path; the writer empties the queue first
+            sink.store(static_cast<int>(next), std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+                wake.notify_one();
+            }
+            writer.join();
+            stopping = false;
+            return;
+        }
+        if (next == Sink::Async) {
+            writer = std::thread(&OramLog::run, this);
+        }
+        sink.store(static_cast<int>(next), std::memory_order_release);
+    }
+};
+
+// ORAM_LOG(level, a << b << ...): the stream expression is only evaluated
+// when the level survives both the compile-time floor and the runtime level.
+#define ORAM_LOG(lvl, ...)                                                   \
+    do {                                                                     \
+        if constexpr ((lvl) >= ORAM_LOG_LEVEL) {                             \
+            if (OramLog::enabled(lvl)) {                                     \
+                std::ostringstream oram_log_stream;                          \
+                oram_log_stream << __VA_ARGS__;                              \
+                OramLog::write((lvl), oram_log_stream.str());                \
+            }                                                                \
+        }                                                                    \
+    } while (0)
+
+#define ORAM_TRACE(...) ORAM_LOG(ORAM_LOG_LEVEL_TRACE, __VA_ARGS__)
+#define ORAM_DEBUG(...) ORAM_LOG(ORAM_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define ORAM_INFO(...)  ORAM_LOG(ORAM_LOG_LEVEL_INFO, __VA_ARGS__)
+#define ORAM_WARN(...)  ORAM_LOG(ORAM_LOG_LEVEL_WARN, __VA_ARGS__)
+#define ORAM_ERROR(...) ORAM_LOG(ORAM_LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef ORAM_METRICS_HPP
+#define ORAM_METRICS_HPP
+
+#include <iostream>
+#include <string>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <mutex>
+
+// -------------------------
+// HdrHistogram (fixed-memory log-linear histogram)
+// -------------------------
+// Values below 2^HDR_SUB_BITS get a bucket each; above that every power of
+// two is split into 2^(HDR_SUB_BITS-1) equal buckets, so a reported
+// percentile is within 1/32 (about 3%) of the true value. Values up to
+// 2^HDR_MAX_BITS (about 18 minutes in nanoseconds) are kept; larger ones
+// land in the top bucket. Recording is a few shifts and an add, and the
+// histogram is a fixed ~9.5 KB whatever the sample count.
+constexpr int HDR_SUB_BITS = 6;
+constexpr int HDR_MAX_BITS = 40;
+constexpr uint64_t HDR_HALF = static_cast<uint64_t>(1) << (HDR_SUB_BITS - 1);
+constexpr size_t HDR_BUCKETS = (HDR_MAX_BITS - HDR_SUB_BITS + 2) * HDR_HALF;
+
+class HdrHistogram {
+private:
+    std::array<uint64_t, HDR_BUCKETS> counts;
+    uint64_t total;
+    uint64_t minValue;
+    uint64_t maxValue;
+    double sum;
+    double sumSquares;
+
+    static size_t index_of(uint64_t v) {
+        if (v < 2 * HDR_HALF) return static_cast<size_t>(v);
+        int msb = 63 - __builtin_clzll(v);
+        if (msb >= HDR_MAX_BITS) return HDR_BUCKETS - 1;
+        int shift = msb - (HDR_SUB_BITS - 1);
+        return static_cast<size_t>(shift) * HDR_HALF + static_cast<size_t>(v >> shift);
+    }
+
+    // Midpoint of the values that map to bucket i.
+    static uint64_t value_at(size_t i) {
+        if (i < 2 * HDR_HALF) return i;
+        size_t shift = i / HDR_HALF - 1;
+        uint64_t lower = static_cast<uint64_t>(i - shift * HDR_HALF) << shift;
+        return lower + ((static_cast<uint64_t>(1) << shift) - 1) / 2;
+    }
+
+public:
+    HdrHistogram() { clear(); }
+
+    void clear() {
+        counts.fill(0);
+        total = 0;
+        minValue = UINT64_MAX;
+        maxValue = 0;
+        sum = 0;
+        sumSquares = 0;
+    }
+
+    void record(uint64_t v) {
+        counts[index_of(v)]++;
+        total++;
+        minValue = std::min(minValue, v);
+        maxValue = std::max(maxValue, v);
+        sum += static_cast<double>(v);
+        sumSquares += static_cast<double>(v) * static_cast<double>(v);
+    }
+
+    void merge(const HdrHistogram& other) {
+        for (size_t i = 0; i < HDR_BUCKETS; i++) counts[i] += other.counts[i];
+        total += other.total;
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+        sum += other.sum;
+        sumSquares += other.sumSquares;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? minValue : 0; }
+    uint64_t max() const { return maxValue; }
+    double mean() const { return total ? sum / total : 0.0; }
+    double total_value() const { return sum; }
+
+    double stddev() const {
+        if (!total) return 0.0;
+        double m = mean();
+        return std::sqrt(std::max(0.0, sumSquares / total - m * m));
+    }
+
+    // Value at quantile q in [0, 1] (e.g. 0.99 for p99). Clamped to the
+    // recorded min and max, so p0 and p100 are exact.
+    uint64_t percentile(double q) const {
+        if (!total) return 0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * total));
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < HDR_BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(maxValue, std::max(minValue, value_at(i)));
+        }
+        return maxValue;
+    }
+
+    // Calls fn(value, count) for every non-empty bucket, in value order.
+    template<typename Fn>
+    void for_each_bucket(Fn&& fn) const {
+        for (size_t i = 0; i < HDR_BUCKETS; i++) {
+            if (counts[i]) fn(value_at(i), counts[i]);
+        }
+    }
+
+    // {"count":..,"mean":..,"p50":..,...} in the recorded unit.
+    void write_json(std::ostream& out) const {
+        out << "{\"count\":" << total << ",\"mean\":" << mean() << ",\"stddev\":" << stddev()
+            << ",\"min\":" << min() << ",\"p50\":" << percentile(0.5) << ",\"p99\":" << percentile(0.99)
+            << ",\"p999\":" << percentile(0.999) << ",\"max\":" << max() << "}";
+    }
+};
+
+// -------------------------
+// ORAM Phase Statistics
+// -------------------------
+// Per-structure timings (nanoseconds), recorded under the structure's own
+// lock so no atomics are needed. Phases nest: write_path includes any
+// full_eviction it triggers, and Access covers the whole public call
+// including LockWait.
+enum class OramPhase {
+    Access,            // one public operation, lock wait included
+    LockWait,          // time spent acquiring the structure's mutex
+    ReadPath,          // moving path buckets into the stash
+    WritePath,         // eviction back onto the path(s), deterministic evictions included
+    Crypto,            // value encryption and decryption
+    FullEviction,
+    CriticalEviction,
+    Count
+};
+
+constexpr size_t ORAM_PHASE_COUNT = static_cast<size_t>(OramPhase::Count);
+
+inline const char* oram_phase_name(OramPhase phase) {
+    static const char* names[ORAM_PHASE_COUNT] = {
+        "Access", "LockWait", "ReadPath", "WritePath", "Crypto", "FullEviction", "CriticalEviction"
+    };
+    return names[static_cast<size_t>(phase)];
+}
+
+struct OramStats {
+    std::array<HdrHistogram, ORAM_PHASE_COUNT> phases;
+    uint64_t blocksRead = 0;       // tree -> stash
+    uint64_t blocksWritten = 0;    // stash -> tree
+    uint64_t emergencyDrops = 0;   // blocks discarded by emergency_drop_blocks
+    size_t stashHighWater = 0;
+
+    HdrHistogram& phase(OramPhase p) { return phases[static_cast<size_t>(p)]; }
+    const HdrHistogram& phase(OramPhase p) const { return phases[static_cast<size_t>(p)]; }
+
+    void note_stash(size_t size) { stashHighWater = std::max(stashHighWater, size); }
+
+    void clear() {
+        for (auto& h : phases) h.clear();
+        blocksRead = 0;
+        blocksWritten = 0;
+        emergencyDrops = 0;
+        stashHighWater = 0;
+    }
+
+    // Sums counters and histograms; the high-water mark is the larger of the
+    // two (shards have separate stashes).
+    void merge(const OramStats& other) {
+        for (size_t i = 0; i < ORAM_PHASE_COUNT; i++) phases[i].merge(other.phases[i]);
+        blocksRead += other.blocksRead;
+        blocksWritten += other.blocksWritten;
+        emergencyDrops += other.emergencyDrops;
+        stashHighWater = std::max(stashHighWater, other.stashHighWater);
+    }
+
+    // Metric,Value rows as in PerformanceMetrics::saveToCSV, names prefixed
+    // with `prefix` (e.g. "FIB.ReadPath.P99Ns").
+    void write_csv(std::ostream& out, const std::string& prefix) const {
+        for (size_t i = 0; i < ORAM_PHASE_COUNT; i++) {
+            const HdrHistogram& h = phases[i];
+            std::string name = prefix + "." + oram_phase_name(static_cast<OramPhase>(i));
+            out << name << ".Count," << h.count() << "\n";
+            out << name << ".TotalNs," << h.total_value() << "\n";
+            out << name << ".P50Ns," << h.percentile(0.5) << "\n";
+            out << name << ".P99Ns," << h.percentile(0.99) << "\n";
+            out << name << ".P999Ns," << h.percentile(0.999) << "\n";
+            out << name << ".MaxNs," << h.max() << "\n";
+        }
+        out << prefix << ".BlocksRead," << blocksRead << "\n";
+        out << prefix << ".BlocksWritten," << blocksWritten << "\n";
+        out << prefix << ".EmergencyDrops," << emergencyDrops << "\n";
+        out << prefix << ".StashHighWater," << stashHighWater << "\n";
+    }
+
+    void write_json(std::ostream& out) const {
+        out << "{\"phases\":{";
+        for (size_t i = 0; i < ORAM_PHASE_COUNT; i++) {
+            if (i) out << ",";
+            out << "\"" << oram_phase_name(static_cast<OramPhase>(i)) << "\":";
+            phases[i].write_json(out);
+        }
+        out << "},\"blocksRead\":" << blocksRead << ",\"blocksWritten\":" << blocksWritten
+            << ",\"emergencyDrops\":" << emergencyDrops << ",\"stashHighWater\":" << stashHighWater << "}";
+    }
+};
+
+// Records the lifetime of a scope into one phase histogram.
+class PhaseTimer {
+private:
+    HdrHistogram& hist;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    PhaseTimer(OramStats& stats, OramPhase phase)
+      : hist(stats.phase(phase)), start(std::chrono::steady_clock::now()) {}
+
+    ~PhaseTimer() {
+        hist.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+};
+
+// Locks a structure's mutex for one public operation, recording the wait
+// as LockWait and the whole operation as Access. Both are recorded before
+// the mutex is released.
+class TimedLock {
+private:
+    std::mutex& mtx;
+    OramStats& stats;
+    std::chrono::steady_clock::time_point start;
+
+    static uint64_t since(std::chrono::steady_clock::time_point t) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t).count());
+    }
+
+public:
+    TimedLock(std::mutex& m, OramStats& s) : mtx(m), stats(s), start(std::chrono::steady_clock::now()) {
+        mtx.lock();
+        stats.phase(OramPhase::LockWait).record(since(start));
+    }
+
+    ~TimedLock() {
+        stats.phase(OramPhase::Access).record(since(start));
+        mtx.unlock();
+    }
+
+    TimedLock(const TimedLock&) = delete;
+    TimedLock& operator=(const TimedLock&) = delete;
+};
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef ORAM_SNAPSHOT_HPP
+#define ORAM_SNAPSHOT_HPP
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include "crypto.hpp"
+
+// -------------------------
+// Snapshot Format
+// -------------------------
+// A snapshot is an 8-byte magic followed by sealed records: each record is
+// a little-endian uint32 length and an AES-GCM ciphertext under the process
+// key. Leaves, keys and slot states never reach the file in the clear, and a
+// snapshot written under another key (or tampered with) fails to load.
+// Values are already ciphertexts and are stored as they are.
+//
+// Snapshots are only readable by a process holding the same keys, so a
+// restarting router loads them after KeyManager::loadKeyFile().
+constexpr char SNAPSHOT_MAGIC[8] = {'O', 'R', 'A', 'M', 'S', 'N', 'P', '1'};
+constexpr uint32_t SNAPSHOT_MAX_RECORD = 1u << 30;
+
+// Structure kinds, recorded in the first record of every snapshot.
+constexpr uint32_t SNAPSHOT_KIND_PATH = 1;
+constexpr uint32_t SNAPSHOT_KIND_RING = 2;
+constexpr uint32_t SNAPSHOT_KIND_SHARDED = 3;
+
+// Accumulates one record's fields and writes it sealed.
+class SnapshotWriter {
+private:
+    std::ostream& out;
+    std::string record;
+    std::string sealed;
+
+public:
+    explicit SnapshotWriter(std::ostream& o) : out(o) {
+        out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    }
+
+    void u8(uint8_t v) { record.push_back(static_cast<char>(v)); }
+
+    void u32(uint32_t v) {
+        for (int i = 0; i < 4; i++) record.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    }
+
+    void u64(uint64_t v) {
+        for (int i = 0; i < 8; i++) record.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    }
+
+    void bytes(const std::string& v) {
+        u32(static_cast<uint32_t>(v.size()));
+        record.append(v);
+    }
+
+    // Fixed-size values (e.g. NameKey) are written as their raw bytes.
+    template<typename T>
+    void pod(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "pod() needs a trivially copyable type");
+        record.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    // Seals the fields added since the last call and writes them out.
+    void end_record() {
+        if (record.size() > SNAPSHOT_MAX_RECORD)
+            throw std::runtime_error("Snapshot record too large");
+        CryptoEngine::local().encrypt_into(record, sealed);
+        uint32_t length = static_cast<uint32_t>(sealed.size());
+        char header[4];
+        for (int i = 0; i < 4; i++) header[i] = static_cast<char>((length >> (8 * i)) & 0xff);
+        out.write(header, sizeof(header));
+        out.write(sealed.data(), sealed.size());
+        if (!out) throw std::runtime_error("Snapshot write failed");
+        record.clear();
+    }
+};
+
+// Opens records written by SnapshotWriter and reads their fields back.
+// Every read past the end of a record throws.
+class SnapshotReader {
+private:
+    std::istream& in;
+    std::string sealed;
+    std::string record;
+    size_t pos;
+
+    const unsigned char* take(size_t n) {
+        if (record.size() - pos < n)
+            throw std::runtime_error("Snapshot record is truncated");
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(record.data()) + pos;
+        pos += n;
+        return p;
+    }
+
+public:
+    explicit SnapshotReader(std::istream& i) : in(i), pos(0) {
+        char magic[sizeof(SNAPSHOT_MAGIC)];
+        if (!in.read(magic, sizeof(magic)) ||
+            std::char_traits<char>::compare(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0)
+            throw std::runtime_error("Not an ORAM snapshot");
+    }
+
+    // Reads and authenticates the next record.
+    void next_record() {
+        unsigned char header[4];
+        if (!in.read(reinterpret_cast<char*>(header), sizeof(header)))
+            throw std::runtime_error("Snapshot is truncated");
+        uint32_t length = 0;
+        for (int i = 0; i < 4; i++) length |= static_cast<uint32_t>(header[i]) << (8 * i);
+        if (length > SNAPSHOT_MAX_RECORD + CryptoEngine::OVERHEAD)
+            throw std::runtime_error("Snapshot record too large");
+        sealed.resize(length);
+        if (!in.read(&sealed[0], length))
+            throw std::runtime_error("Snapshot is truncated");
+        CryptoEngine::local().decrypt_into(sealed, record);
+        pos = 0;
+    }
+
+    uint8_t u8() { return *take(1); }
+
+    uint32_t u32() {
+        const unsigned char* p = take(4);
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+        return v;
+    }
+
+    uint64_t u64() {
+        const unsigned char* p = take(8);
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+        return v;
+    }
+
+    void bytes(std::string& v) {
+        uint32_t length = u32();
+        const unsigned char* p = take(length);
+        v.assign(reinterpret_cast<const char*>(p), length);
+    }
+
+    template<typename T>
+    void pod(T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "pod() needs a trivially copyable type");
+        std::memcpy(&v, take(sizeof(v)), sizeof(v));
+    }
+
+    // Checks that a structure's header matches the one being loaded into.
+    void expect(uint32_t got, uint32_t want, const char* what) {
+        if (got != want)
+            throw std::runtime_error(std::string("Snapshot does not match this structure: ") + what);
+    }
+};
+
+// Map keys: names as length-prefixed bytes, fixed-width keys raw.
+inline void snapshot_write_key(SnapshotWriter& w, const std::string& key) { w.bytes(key); }
+template<typename K>
+void snapshot_write_key(SnapshotWriter& w, const K& key) { w.pod(key); }
+
+inline void snapshot_read_key(SnapshotReader& r, std::string& key) { r.bytes(key); }
+template<typename K>
+void snapshot_read_key(SnapshotReader& r, K& key) { r.pod(key); }
+
+#endif
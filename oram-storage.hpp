@@ -0,0 +1,167 @@
+#ifndef ORAM_STORAGE_HPP
+#define ORAM_STORAGE_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+// -------------------------
+// Slot Flags
+// -------------------------
+constexpr uint8_t SLOT_VALID = 0x1;          // Slot holds a real block
+constexpr uint8_t SLOT_HIGH_PRIORITY = 0x2;  // Block must survive emergency drops
+
+// -------------------------
+// FlatTree: contiguous ORAM bucket arena
+// -------------------------
+// All buckets live in one arena in heap order (bucket 1 is the root, bucket i
+// has children 2i and 2i+1). Bucket b owns slots [(b-1)*Z, b*Z). Per-slot
+// state is kept as a struct of arrays so that scanning a path for valid
+// blocks touches only the dense flag and leaf arrays; the payload array is
+// read only for slots that actually hold a block.
+//
+// Payloads are stored as they are, so string keys and values keep their
+// own heap buffers. Moving a block between tree and stash hands a buffer
+// over rather than copying it. Fixed-width inline slots would have to be
+// sized for the largest block (a 2 KiB content-store chunk next to a
+// few-byte FIB face), multiplying the arena for the common small values.
+template<typename Payload>
+class FlatTree {
+private:
+    int height;
+    int capacity;                   // Z: slots per bucket
+    size_t numBuckets;
+    std::vector<uint8_t> flags;     // SLOT_* bits per slot
+    std::vector<uint32_t> leaves;   // assigned leaf per slot
+    std::vector<Payload> payloads;  // block contents per slot
+    std::vector<uint16_t> fill;     // valid slots per bucket (index 0 unused)
+    size_t validCount;
+
+    size_t base(size_t bucket) const {
+        return (bucket - 1) * static_cast<size_t>(capacity);
+    }
+
+public:
+    FlatTree(int treeHeight, int bucketCapacity)
+      : height(treeHeight), capacity(bucketCapacity), validCount(0)
+    {
+        if (treeHeight < 0 || treeHeight > 31)
+            throw std::invalid_argument("FlatTree height must be in [0, 31]");
+        if (bucketCapacity <= 0 || bucketCapacity > UINT16_MAX)
+            throw std::invalid_argument("FlatTree bucket capacity out of range");
+
+        numBuckets = (static_cast<size_t>(1) << (height + 1)) - 1;
+        size_t slots = numBuckets * capacity;
+        flags.assign(slots, 0);
+        leaves.assign(slots, 0);
+        payloads.resize(slots);
+        fill.assign(numBuckets + 1, 0);
+    }
+
+    size_t bucket_count() const { return numBuckets; }
+    int bucket_capacity() const { return capacity; }
+    int tree_height() const { return height; }
+    size_t size() const { return validCount; }
+
+    // Number of valid blocks currently held by a bucket.
+    int occupancy(size_t bucket) const { return fill[bucket]; }
+
+    // Moves every valid block of a bucket out through
+    // sink(leaf, flags, Payload&&) and frees the slots.
+    template<typename Sink>
+    void drain(size_t bucket, Sink&& sink) {
+        if (fill[bucket] == 0) return;
+        size_t first = base(bucket);
+        for (size_t s = first; s < first + capacity; s++) {
+            if (flags[s] & SLOT_VALID) {
+                uint8_t f = flags[s];
+                flags[s] = 0;
+                sink(static_cast<size_t>(leaves[s]), f, std::move(payloads[s]));
+            }
+        }
+        validCount -= fill[bucket];
+        fill[bucket] = 0;
+    }
+
+    // Calls visit(leaf, flags, const Payload&) for every valid block of a
+    // bucket without removing it.
+    template<typename Visit>
+    void visit(size_t bucket, Visit&& visit) const {
+        if (fill[bucket] == 0) return;
+        size_t first = base(bucket);
+        for (size_t s = first; s < first + capacity; s++) {
+            if (flags[s] & SLOT_VALID) {
+                visit(static_cast<size_t>(leaves[s]), flags[s], payloads[s]);
+            }
+        }
+    }
+
+    // Stores a block in the first free slot of a bucket; false when full.
+    bool store(size_t bucket, size_t leaf, uint8_t slotFlags, Payload&& payload) {
+        if (fill[bucket] >= capacity) return false;
+        size_t first = base(bucket);
+        for (size_t s = first; s < first + capacity; s++) {
+            if (!(flags[s] & SLOT_VALID)) {
+                flags[s] = slotFlags | SLOT_VALID;
+                leaves[s] = static_cast<uint32_t>(leaf);
+                payloads[s] = std::move(payload);
+                fill[bucket]++;
+                validCount++;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// -------------------------
+// Stash Storage Helpers
+// -------------------------
+// Stash order carries no meaning, so a block is removed in O(1) by moving
+// the last block into its place.
+template<typename BlockT>
+void stash_swap_remove(std::vector<BlockT>& stash, size_t index) {
+    if (index + 1 != stash.size()) {
+        stash[index] = std::move(stash.back());
+    }
+    stash.pop_back();
+}
+
+// BufferPool: recycled block buffers
+// Keys and ciphertexts of blocks that leave a structure (removed, popped,
+// dropped or expired) are parked here instead of freed, and new blocks take
+// their buffers from the pool. Assigning into a recycled std::string reuses
+// its capacity, so once the pool is warm a new block allocates nothing as
+// long as its contents fit.
+template<typename T>
+class BufferPool {
+private:
+    std::vector<T> buffers;
+    size_t limit;
+
+public:
+    explicit BufferPool(size_t maxBuffers) : limit(maxBuffers) {
+        buffers.reserve(maxBuffers);
+    }
+
+    // A recycled buffer (contents unspecified) or a fresh one.
+    T acquire() {
+        if (buffers.empty()) return T();
+        T buffer = std::move(buffers.back());
+        buffers.pop_back();
+        return buffer;
+    }
+
+    // Takes the buffer's storage, leaving `buffer` empty.
+    void release(T& buffer) {
+        if (buffers.size() < limit) {
+            buffers.push_back(std::move(buffer));
+        }
+    }
+
+    size_t size() const { return buffers.size(); }
+};
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef PATH_EVICTION_HPP
+#define PATH_EVICTION_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// -------------------------
+// Path Arithmetic
+// -------------------------
+// The ORAM trees are 1-indexed heaps: the root is bucket 1, the children of
+// bucket i are 2i and 2i+1, and leaf l lives in bucket (1 << height) + l.
+// Every question about "is this bucket on that path" reduces to shifts.
+
+// Bucket index of the leaf node for a given leaf id.
+inline size_t leaf_bucket(size_t leaf, int height) {
+    return (static_cast<size_t>(1) << height) + leaf;
+}
+
+// Bucket index at the given depth (0 = root) on the path to a leaf.
+inline size_t path_bucket_at_depth(size_t leaf, int depth, int height) {
+    return leaf_bucket(leaf, height) >> (height - depth);
+}
+
+// Depth (0 = root) of a bucket index.
+inline int bucket_depth(size_t bucket) {
+    int depth = -1;
+    while (bucket) {
+        bucket >>= 1;
+        depth++;
+    }
+    return depth;
+}
+
+// Depth of the deepest bucket shared by the paths to two leaves.
+inline int common_path_depth(size_t leafA, size_t leafB, int height) {
+    size_t diff = leafA ^ leafB;
+    int bits = 0;
+    while (diff) {
+        diff >>= 1;
+        bits++;
+    }
+    return height - bits;
+}
+
+// True if the bucket lies on the path from the root to the given leaf.
+inline bool path_contains(size_t leaf, size_t bucket, int height) {
+    int depth = bucket_depth(bucket);
+    return depth <= height && path_bucket_at_depth(leaf, depth, height) == bucket;
+}
+
+// -------------------------
+// Eviction Modes
+// -------------------------
+// Heuristic: threshold-driven write-back with stuck-block remaps and, under
+// pressure, emergency drops and stash growth.
+// Bounded: plain PathORAM write-back of every access path plus one
+// deterministic eviction per access along paths taken in
+// reverse-lexicographic order, as in Ring ORAM and Circuit ORAM. Nothing is
+// dropped, remapped or grown; for Z >= 4 the stash stays at O(log N) with
+// overwhelming probability. An access that leaves the stash over the limit
+// runs up to BOUNDED_OVERFLOW_EVICTIONS extra evictions; what remains carries
+// to the next access.
+enum class EvictionMode { Heuristic, Bounded };
+
+constexpr int BOUNDED_OVERFLOW_EVICTIONS = 8;  // Extra evictions an access may run over the stash bound
+
+// Leaf of the g-th deterministic eviction: the low `height` bits of g in
+// reverse order, so consecutive evictions alternate between subtrees and
+// every bucket at depth d is evicted once every 2^d evictions.
+inline size_t reverse_lex_leaf(uint64_t g, int height) {
+    size_t leaf = 0;
+    for (int i = 0; i < height; i++) {
+        leaf = (leaf << 1) | ((g >> i) & 1);
+    }
+    return leaf;
+}
+
+// -------------------------
+// Greedy Eviction Engine
+// -------------------------
+// Shared by ObliviousMap and ObliviousQueue. The engine only needs each stash
+// block's `leaf`; storage is reached through a `place(bucket, block)` callback
+// that moves the block into a free slot and returns false when the bucket is
+// full. Scratch buffers are kept between calls so steady-state eviction does
+// not allocate.
+class PathEvictor {
+private:
+    std::vector<size_t> order;       // stash indices grouped by target depth
+    std::vector<size_t> depthStart;  // counting-sort offsets, one per depth
+    std::vector<size_t> depthFill;   // write cursors while building `order`
+    std::vector<char> placed;        // stash indices already written back
+
+    template<typename BlockT>
+    size_t compact(std::vector<BlockT>& stash) {
+        size_t out = 0;
+        size_t evicted = 0;
+        for (size_t i = 0; i < stash.size(); i++) {
+            if (placed[i]) {
+                evicted++;
+                continue;
+            }
+            if (out != i) {
+                stash[out] = std::move(stash[i]);
+            }
+            out++;
+        }
+        stash.resize(out);
+        return evicted;
+    }
+
+public:
+    // Evicts stash blocks onto the path to `leaf`, deepest buckets first.
+    // One pass buckets the stash by the deepest level it may occupy on this
+    // path; the walk from leaf to root then only ever considers blocks that
+    // are legal at the current level. Returns the number of blocks evicted.
+    template<typename BlockT, typename Place>
+    size_t evict_path(std::vector<BlockT>& stash, size_t leaf, int height, Place&& place) {
+        if (stash.empty()) return 0;
+
+        depthStart.assign(height + 2, 0);
+        for (const auto& blk : stash) {
+            depthStart[common_path_depth(blk.leaf, leaf, height) + 1]++;
+        }
+        for (int d = 0; d <= height; d++) {
+            depthStart[d + 1] += depthStart[d];
+        }
+        order.resize(stash.size());
+        depthFill.assign(depthStart.begin(), depthStart.end() - 1);
+        for (size_t i = 0; i < stash.size(); i++) {
+            order[depthFill[common_path_depth(stash[i].leaf, leaf, height)]++] = i;
+        }
+
+        placed.assign(stash.size(), 0);
+
+        // Candidates with depth >= level form a suffix of `order`; walking
+        // levels upward only ever grows that suffix, so a single cursor over
+        // it suffices. Blocks that did not fit lower stay eligible higher up.
+        size_t cursor = stash.size();
+        for (int level = height; level >= 0; level--) {
+            size_t lowest = depthStart[level];
+            size_t bucket = path_bucket_at_depth(leaf, level, height);
+            while (cursor > lowest) {
+                size_t idx = order[cursor - 1];
+                if (!place(bucket, stash[idx])) break;
+                placed[idx] = 1;
+                cursor--;
+            }
+        }
+
+        return compact(stash);
+    }
+
+    // Evicts stash blocks anywhere in the tree: each block goes to the
+    // deepest bucket on its own path that `place` accepts. Used for full
+    // sweeps and for multi-path write-backs where `place` rejects buckets
+    // outside the touched set. Returns the number of blocks evicted.
+    template<typename BlockT, typename Place>
+    size_t evict_tree(std::vector<BlockT>& stash, int height, Place&& place) {
+        if (stash.empty()) return 0;
+
+        placed.assign(stash.size(), 0);
+        for (size_t i = 0; i < stash.size(); i++) {
+            for (int level = height; level >= 0; level--) {
+                if (place(path_bucket_at_depth(stash[i].leaf, level, height), stash[i])) {
+                    placed[i] = 1;
+                    break;
+                }
+            }
+        }
+
+        return compact(stash);
+    }
+};
+
+#endif
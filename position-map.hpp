@@ -0,0 +1,114 @@
+#ifndef POSITION_MAP_HPP
+#define POSITION_MAP_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "crypto.hpp"
+
+// -------------------------
+// Position Map Policies
+// -------------------------
+// ObliviousMap takes its position map as a template parameter. Every policy
+// is constructed from (treeHeight, bucketCapacity) and provides:
+//
+//   bool remap(key, newLeaf, oldLeaf&)  If the key's entry is mapped, store
+//                                       newLeaf and return the old leaf.
+//                                       Unmapped entries stay unmapped.
+//   void assign(key, leaf)              Map the key's entry to a leaf.
+//   void erase(key)                     Forget the key's entry.
+//   bool same_entry(a, b)               True if a and b share one entry.
+//   size_t memory_bytes()               Approximate resident size.
+//
+// Policies with shares_entries == true may place several keys on one entry.
+// Those keys then always share a leaf, so ObliviousMap moves every stash
+// block of an entry together when it remaps one of them.
+
+constexpr int COMPACT_POSMAP_IDS_PER_SLOT = 2;  // Id space relative to tree capacity
+constexpr uint32_t POSMAP_UNMAPPED = UINT32_MAX;
+
+// Size of the hashed id space for a tree: the next power of two at or above
+// COMPACT_POSMAP_IDS_PER_SLOT ids per block slot.
+inline size_t position_map_id_space(int treeHeight, int bucketCapacity) {
+    size_t slots = ((static_cast<size_t>(1) << (treeHeight + 1)) - 1) * bucketCapacity;
+    size_t want = slots * COMPACT_POSMAP_IDS_PER_SLOT;
+    size_t ids = 1;
+    while (ids < want) ids <<= 1;
+    return ids;
+}
+
+// HashPositionMap:
+// Exact map from full key to leaf. Default policy; one node per key.
+template<typename K>
+class HashPositionMap {
+private:
+    std::unordered_map<K, size_t> leaves;
+
+public:
+    static constexpr bool shares_entries = false;
+
+    HashPositionMap(int, int) {}
+
+    bool remap(const K& key, size_t newLeaf, size_t& oldLeaf) {
+        auto it = leaves.find(key);
+        if (it == leaves.end()) return false;
+        oldLeaf = it->second;
+        it->second = newLeaf;
+        return true;
+    }
+
+    void assign(const K& key, size_t leaf) { leaves[key] = leaf; }
+    void erase(const K& key) { leaves.erase(key); }
+    bool same_entry(const K& a, const K& b) const { return a == b; }
+
+    size_t memory_bytes() const {
+        // Buckets plus one node (key, leaf, next pointer) per entry.
+        return leaves.bucket_count() * sizeof(void*) +
+               leaves.size() * (sizeof(K) + sizeof(size_t) + sizeof(void*));
+    }
+};
+
+// CompactPositionMap:
+// Flat array of packed uint32_t leaves indexed by a keyed hash of the key.
+// Memory is fixed at construction (4 bytes per id) regardless of key
+// length. Keys whose hashes collide share an entry and therefore a leaf.
+template<typename K>
+class CompactPositionMap {
+private:
+    std::vector<uint32_t> leaves;
+    size_t mask;
+
+    size_t id_of(const K& key) const {
+        return static_cast<size_t>(keyed_hash(key)) & mask;
+    }
+
+public:
+    static constexpr bool shares_entries = true;
+
+    CompactPositionMap(int treeHeight, int bucketCapacity)
+      : leaves(position_map_id_space(treeHeight, bucketCapacity), POSMAP_UNMAPPED),
+        mask(leaves.size() - 1) {}
+
+    bool remap(const K& key, size_t newLeaf, size_t& oldLeaf) {
+        uint32_t& entry = leaves[id_of(key)];
+        if (entry == POSMAP_UNMAPPED) return false;
+        oldLeaf = entry;
+        entry = static_cast<uint32_t>(newLeaf);
+        return true;
+    }
+
+    void assign(const K& key, size_t leaf) { leaves[id_of(key)] = static_cast<uint32_t>(leaf); }
+
+    // Other keys may share the entry, so it is left mapped. A stale entry
+    // only costs a path read that finds nothing.
+    void erase(const K&) {}
+
+    bool same_entry(const K& a, const K& b) const { return id_of(a) == id_of(b); }
+
+    size_t memory_bytes() const { return leaves.size() * sizeof(uint32_t); }
+};
+
+#endif
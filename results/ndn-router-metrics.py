@@ -5,6 +5,7 @@ import seaborn as sns
 from matplotlib.gridspec import GridSpec
 import os
 import glob
+import json
 
 # Set style
 plt.style.use('ggplot')
@@ -335,6 +336,86 @@ def plot_stash_history(results_dir='results'):
     
     print("Stash size history plot saved as 'visualizations/stash_history.png'")
 
+def plot_oram_phases(results_dir='results'):
+    """Plot per-phase ORAM time (p50/p99/p999) from the JSON metrics files."""
+    print("Plotting ORAM phase breakdown from JSON metrics files")
+    
+    json_files = sorted(glob.glob(f"{results_dir}/*.json"))
+    runs = []
+    for file in json_files:
+        try:
+            with open(file, 'r') as f:
+                data = json.load(f)
+        except Exception as e:
+            print(f"Error loading {file}: {e}")
+            continue
+        if 'oram' in data:
+            runs.append((os.path.splitext(os.path.basename(file))[0], data['oram']))
+    
+    if not runs:
+        print("No JSON metrics files with ORAM statistics found.")
+        return
+    
+    # One figure per run: grouped bars of p50/p99/p999 per phase and table
+    for name, oram in runs:
+        fig, axes = plt.subplots(1, len(oram), figsize=(6 * len(oram), 6), squeeze=False)
+        for ax, (table, stats) in zip(axes[0], oram.items()):
+            phases = [p for p, h in stats['phases'].items() if h['count'] > 0 and p != 'Access']
+            if not phases:
+                ax.set_title(f'{table} (no samples)')
+                continue
+            x = np.arange(len(phases))
+            width = 0.25
+            for offset, q in zip((-width, 0, width), ('p50', 'p99', 'p999')):
+                ax.bar(x + offset, [stats['phases'][p][q] / 1000.0 for p in phases], width, label=q)
+            ax.set_xticks(x)
+            ax.set_xticklabels(phases, rotation=30, ha='right')
+            ax.set_ylabel('Latency (μs)')
+            ax.set_yscale('log')
+            ax.set_title(f"{table}: stash high-water {stats['stashHighWater']}, "
+                         f"drops {stats['emergencyDrops']}")
+            ax.legend()
+        fig.suptitle(f'ORAM phase latency: {name}')
+        plt.tight_layout()
+        os.makedirs('visualizations', exist_ok=True)
+        plt.savefig(f'visualizations/oram_phases_{name}.png', dpi=300, bbox_inches='tight')
+        plt.close()
+    
+    print(f"ORAM phase plots saved for {len(runs)} runs in 'visualizations/'")
+
+def plot_scaling(scaling_path='scaling_results.csv'):
+    """Plot throughput vs. load threads, one line per namespace size."""
+    print(f"Plotting throughput scaling from {scaling_path}")
+    
+    df = load_and_clean_data(scaling_path)
+    if df is None or df.empty:
+        return
+    df = df[pd.to_numeric(df['Throughput'], errors='coerce').notna()].copy()
+    if df.empty:
+        print("No successful scaling runs found.")
+        return
+    for column in ('Threads', 'NamespaceSize', 'Throughput', 'Speedup', 'P99InterestLatency'):
+        df[column] = pd.to_numeric(df[column])
+    
+    fig, axes = plt.subplots(1, 3, figsize=(18, 6))
+    for size, group in df.groupby('NamespaceSize'):
+        group = group.sort_values('Threads')
+        axes[0].plot(group['Threads'], group['Throughput'], marker='o', label=f'{size} names')
+        axes[1].plot(group['Threads'], group['Speedup'], marker='o', label=f'{size} names')
+        axes[2].plot(group['Threads'], group['P99InterestLatency'], marker='o', label=f'{size} names')
+    threads = sorted(df['Threads'].unique())
+    axes[1].plot(threads, [t / threads[0] for t in threads], 'k--', label='linear')
+    for ax, label in zip(axes, ('Throughput (ops/sec)', 'Speedup', 'P99 interest latency (μs)')):
+        ax.set_xlabel('Load threads')
+        ax.set_ylabel(label)
+        ax.set_xscale('log', base=2)
+        ax.legend()
+    fig.suptitle('Throughput scaling (Zipf workload)')
+    plt.tight_layout()
+    os.makedirs('visualizations', exist_ok=True)
+    plt.savefig('visualizations/scaling.png', dpi=300, bbox_inches='tight')
+    plt.close()
+
 def plot_config_parameters(config_benchmark_path='config_benchmark_results.csv'):
     """Plot the impact of different configuration parameters on performance."""
     print(f"Plotting configuration parameters from: {config_benchmark_path}")
@@ -727,9 +808,17 @@ def main():
     else:
         print("config_benchmark_results.csv not found, skipping configuration parameter visualization.")
     
+    if os.path.exists('scaling_results.csv'):
+        plot_scaling()
+    else:
+        print("scaling_results.csv not found, skipping throughput scaling visualization.")
+    
     # Plot stash history from detailed metrics files
     plot_stash_history()
     
+    # Plot per-phase ORAM latency from the JSON metrics files
+    plot_oram_phases()
+    
     # Plot emergency mode analysis if log files exist
     plot_emergency_mode_analysis()
     
@@ -549,9 +549,11 @@ if __name__ == "__main__":
             analyze_baseline_comparison()
         elif sys.argv[1] == "config":
             analyze_configuration_benchmark()
+        elif sys.argv[1] == "sweep":
+            analyze_configuration_benchmark("sweep_results.csv")
         else:
             print(f"Unknown visualization type: {sys.argv[1]}")
-            print("Available types: operations, baseline, config")
+            print("Available types: operations, baseline, config, sweep")
     else:
         # Process all visualizations
         print("Generating all visualizations...")
@@ -0,0 +1,614 @@
+#ifndef RING_MAP_HPP
+#define RING_MAP_HPP
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+#include <string>
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+#include "crypto.hpp"
+#include "secure-random.hpp"
+#include "path-eviction.hpp"
+#include "oram-storage.hpp"
+#include "eviction-scheduler.hpp"
+#include "position-map.hpp"
+#include "tree-map.hpp"
+#include "oram-snapshot.hpp"
+#include "oram-metrics.hpp"
+
+// -------------------------
+// Ring ORAM Parameters
+// -------------------------
+constexpr uint8_t RING_SLOT_REAL = 0x1;   // Slot holds a real block
+constexpr uint8_t RING_SLOT_FRESH = 0x2;  // Slot not read since the bucket was last shuffled
+constexpr int RING_OVERFLOW_EVICTIONS = 8;      // Extra path evictions an access may run over the stash bound
+constexpr size_t RING_FULL_EVICTION_PATHS = 64; // Path evictions per trigger_full_eviction call
+
+// Eviction rate A for Z real slots per bucket: the (Z, A) pairs published
+// in the Ring ORAM paper where Z is one of them, and otherwise 3Z/2 - 3, a
+// line through the small pairs that stays within a few of the large ones
+// (it gives 9, 21 and 45 for Z = 8, 16 and 32).
+inline int ring_eviction_rate(int bucketCapacity) {
+    static const int published[][2] = {{4, 3}, {8, 8}, {16, 20}, {32, 46}};
+    for (const auto& pair : published) {
+        if (pair[0] == bucketCapacity) return pair[1];
+    }
+    return std::max(1, (3 * bucketCapacity) / 2 - 3);
+}
+
+// -------------------------
+// RingObliviousMap Class (Ring ORAM)
+// -------------------------
+// Each bucket holds Z real and S dummy slots in a random permutation, with
+// per-slot metadata (real/fresh, leaf, key tag) kept next to the tree:
+//   - an access reads exactly one slot per bucket on the path: the key's
+//     block if the metadata places it there, otherwise an unread dummy;
+//   - every A accesses one path, in reverse-lexicographic order, is evicted:
+//     its remaining real blocks are read, the path is refilled greedily
+//     from the stash and each bucket is re-permuted;
+//   - a bucket read S times since its last shuffle is reshuffled early.
+// With S = A the root is evicted before it runs out of dummies, and deeper
+// buckets are evicted more rarely but also read more rarely. Compared with
+// PathORAM's Z x (height+1) block reads per access, an access moves
+// height+1 blocks plus the amortised eviction.
+//
+// The position map is exact (HashPositionMap). Batch calls run their
+// accesses back to back; eviction is inline, so there is no background
+// work and no eviction-mode choice.
+template<typename K, typename V>
+class RingObliviousMap {
+private:
+    int treeHeight;
+    int bucketCapacity;                     // Z: real slots per bucket
+    int dummySlots;                         // S
+    int evictionRate;                       // A
+    size_t slotsPerBucket;                  // Z + S
+    size_t numBuckets;
+    std::vector<MapSlot<K,V>> payloads;     // slot contents, heap order
+    std::vector<uint32_t> slotLeaf;
+    std::vector<uint64_t> slotTag;          // keyed hash of the slot's key
+    std::vector<uint8_t> slotState;         // RING_SLOT_* bits
+    std::vector<uint16_t> bucketReads;      // reads since last shuffle (index 0 unused)
+    std::vector<Block<K,V>> stash;
+    size_t stashLimit;
+    HashPositionMap<K> posMap;
+    mutable std::mutex mtx;                 // Global mutex for all operations
+    PathEvictor evictor;
+    std::vector<std::vector<Block<K,V>>> staging;  // blocks bound for each depth of a path
+    std::vector<size_t> perm;               // shuffle scratch
+    std::vector<uint64_t> scanScratch;      // stash tags for ct_find_u64
+    BufferPool<K> keyPool;
+    BufferPool<V> valuePool;
+    uint64_t accessCount;
+    uint64_t evictionCounter;               // deterministic evictions done
+    OramStats stats;                        // per-phase timings and counters (under mtx)
+
+    static constexpr size_t NO_BLOCK = static_cast<size_t>(-1);
+
+    struct AccessContext {
+        size_t pathLeaf;
+        size_t newLeaf;
+        size_t target;    // stash index of the key's block, or NO_BLOCK
+        uint64_t tag;     // keyed hash of the key
+    };
+
+    size_t base(size_t bucket) const { return (bucket - 1) * slotsPerBucket; }
+
+    // Reads one slot of a bucket: the key's block when the metadata says it
+    // is here, otherwise a uniformly random unread dummy.
+    void read_bucket(size_t bucket, const K& key, uint64_t tag, bool mapped) {
+        size_t first = base(bucket);
+        size_t hit = NO_BLOCK;
+        size_t dummies = 0;
+        for (size_t s = first; s < first + slotsPerBucket; s++) {
+            if (slotState[s] == (RING_SLOT_REAL | RING_SLOT_FRESH)) {
+                if (mapped && slotTag[s] == tag && payloads[s].key == key) hit = s;
+            } else if (slotState[s] == RING_SLOT_FRESH) {
+                dummies++;
+            }
+        }
+
+        if (hit == NO_BLOCK) {
+            if (dummies == 0)
+                throw std::runtime_error("Ring ORAM bucket ran out of dummy slots");
+            size_t pick = secure_random_index(dummies);
+            for (size_t s = first; s < first + slotsPerBucket; s++) {
+                if (slotState[s] == RING_SLOT_FRESH && pick-- == 0) {
+                    hit = s;
+                    break;
+                }
+            }
+        } else {
+            stash.emplace_back(std::move(payloads[hit].key), std::move(payloads[hit].value),
+                               slotLeaf[hit], false, slotTag[hit]);
+            stats.blocksRead++;
+        }
+
+        slotState[hit] = 0;
+        bucketReads[bucket]++;
+    }
+
+    // Moves every real block still in a bucket to the given list.
+    void drain_bucket(size_t bucket, std::vector<Block<K,V>>& out) {
+        size_t first = base(bucket);
+        for (size_t s = first; s < first + slotsPerBucket; s++) {
+            if (slotState[s] & RING_SLOT_REAL) {
+                out.emplace_back(std::move(payloads[s].key), std::move(payloads[s].value), slotLeaf[s],
+                                 false, slotTag[s]);
+                stats.blocksRead++;
+            }
+            slotState[s] = 0;
+        }
+    }
+
+    // Writes up to Z blocks into a bucket at random positions; every other
+    // slot becomes a fresh dummy.
+    void rebuild_bucket(size_t bucket, std::vector<Block<K,V>>& blocks) {
+        size_t first = base(bucket);
+        for (size_t i = 0; i < slotsPerBucket; i++) {
+            perm[i] = i;
+            slotState[first + i] = RING_SLOT_FRESH;
+        }
+        for (size_t i = 0; i < blocks.size(); i++) {
+            std::swap(perm[i], perm[i + secure_random_index(slotsPerBucket - i)]);
+            size_t s = first + perm[i];
+            slotTag[s] = blocks[i].tag;
+            slotLeaf[s] = static_cast<uint32_t>(blocks[i].leaf);
+            payloads[s].key = std::move(blocks[i].key);
+            payloads[s].value = std::move(blocks[i].value);
+            slotState[s] = RING_SLOT_REAL | RING_SLOT_FRESH;
+        }
+        stats.blocksWritten += blocks.size();
+        blocks.clear();
+        bucketReads[bucket] = 0;
+    }
+
+    // Reads the next path in reverse-lexicographic order, refills it from
+    // the stash and re-permutes every bucket on it.
+    void evict_next_path() {
+        size_t leaf = reverse_lex_leaf(evictionCounter++, treeHeight);
+        for (int depth = 0; depth <= treeHeight; depth++) {
+            drain_bucket(path_bucket_at_depth(leaf, depth, treeHeight), stash);
+        }
+        evictor.evict_path(stash, leaf, treeHeight,
+            [this](size_t bucketIndex, Block<K,V>& blk) {
+                auto& slots = staging[bucket_depth(bucketIndex)];
+                if (slots.size() >= static_cast<size_t>(bucketCapacity)) return false;
+                slots.push_back(std::move(blk));
+                return true;
+            });
+        for (int depth = 0; depth <= treeHeight; depth++) {
+            rebuild_bucket(path_bucket_at_depth(leaf, depth, treeHeight), staging[depth]);
+        }
+    }
+
+    // Reshuffles buckets on the accessed path that have used up their dummies.
+    void early_reshuffle(size_t leaf) {
+        for (int depth = 0; depth <= treeHeight; depth++) {
+            size_t bucket = path_bucket_at_depth(leaf, depth, treeHeight);
+            if (bucketReads[bucket] < dummySlots) continue;
+            drain_bucket(bucket, staging[depth]);
+            rebuild_bucket(bucket, staging[depth]);
+        }
+    }
+
+    AccessContext begin_access(const K& key) {
+        AccessContext ctx;
+        ctx.newLeaf = secure_random_index(1 << treeHeight);
+        bool mapped = posMap.remap(key, ctx.newLeaf, ctx.pathLeaf);
+        if (!mapped) ctx.pathLeaf = secure_random_index(1 << treeHeight);
+
+        uint64_t tag = keyed_hash(key);
+        ctx.tag = tag;
+        {
+            PhaseTimer timer(stats, OramPhase::ReadPath);
+            for (int depth = 0; depth <= treeHeight; depth++) {
+                read_bucket(path_bucket_at_depth(ctx.pathLeaf, depth, treeHeight), key, tag, mapped);
+            }
+            stats.note_stash(stash.size());
+        }
+
+        // Branch-free scan of the stash tags (see ObliviousMap::find_in_stash)
+        ctx.target = NO_BLOCK;
+        if (mapped) {
+            size_t n = stash.size();
+            scanScratch.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                scanScratch[i] = ct_select_u64(stash[i].valid, stash[i].tag, ~tag);
+            }
+            size_t hit = ct_find_u64(scanScratch.data(), n, tag);
+            if (hit != n && !(stash[hit].key == key)) {
+                // Tag collision: compare every candidate
+                hit = n;
+                for (size_t i = 0; i < n; i++) {
+                    if (scanScratch[i] == tag && stash[i].key == key) hit = i;
+                }
+            }
+            if (hit != n) {
+                stash[hit].leaf = ctx.newLeaf;
+                ctx.target = hit;
+            }
+        }
+        return ctx;
+    }
+
+    Block<K,V>& create_block(const K& key, AccessContext& ctx) {
+        posMap.assign(key, ctx.newLeaf);
+        K blockKey = keyPool.acquire();
+        blockKey = key;
+        stash.emplace_back(std::move(blockKey), valuePool.acquire(), ctx.newLeaf, false, ctx.tag);
+        ctx.target = stash.size() - 1;
+        return stash.back();
+    }
+
+    // The access has already changed the stash and position map, so a stash
+    // over its bound is worked off with extra evictions (in the same
+    // reverse-lexicographic order) rather than reported as a failure.
+    // Whatever RING_OVERFLOW_EVICTIONS leave over carries to the next access.
+    void end_access(const AccessContext& ctx) {
+        PhaseTimer timer(stats, OramPhase::WritePath);
+        if (++accessCount % evictionRate == 0) {
+            evict_next_path();
+        }
+        early_reshuffle(ctx.pathLeaf);
+        for (int i = 0; i < RING_OVERFLOW_EVICTIONS && stash.size() > stashLimit; i++) {
+            evict_next_path();
+        }
+    }
+
+    void seal(const V& plaintext, V& out) {
+        PhaseTimer timer(stats, OramPhase::Crypto);
+        CryptoEngine::local().encrypt_into(plaintext, out);
+    }
+
+    void unseal(const V& ciphertext, V& out) {
+        PhaseTimer timer(stats, OramPhase::Crypto);
+        CryptoEngine::local().decrypt_into(ciphertext, out);
+    }
+
+    void discard_stash_block(size_t index) {
+        keyPool.release(stash[index].key);
+        valuePool.release(stash[index].value);
+        stash_swap_remove(stash, index);
+    }
+
+    // Puts a block into a random fresh dummy slot of a bucket that still
+    // has room for a real block; false otherwise. Used by bulk_load.
+    bool place_fresh(size_t bucket, Block<K,V>& blk) {
+        size_t first = base(bucket);
+        size_t real = 0;
+        size_t dummies = 0;
+        for (size_t s = first; s < first + slotsPerBucket; s++) {
+            if (slotState[s] & RING_SLOT_REAL) real++;
+            else if (slotState[s] == RING_SLOT_FRESH) dummies++;
+        }
+        if (real >= static_cast<size_t>(bucketCapacity) || dummies == 0) return false;
+        size_t pick = secure_random_index(dummies);
+        for (size_t s = first; s < first + slotsPerBucket; s++) {
+            if (slotState[s] == RING_SLOT_FRESH && pick-- == 0) {
+                slotTag[s] = blk.tag;
+                slotLeaf[s] = static_cast<uint32_t>(blk.leaf);
+                payloads[s].key = std::move(blk.key);
+                payloads[s].value = std::move(blk.value);
+                slotState[s] = RING_SLOT_REAL | RING_SLOT_FRESH;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool is_empty() const {
+        if (!stash.empty()) return false;
+        for (uint8_t state : slotState) {
+            if (state & RING_SLOT_REAL) return false;
+        }
+        return true;
+    }
+
+public:
+    RingObliviousMap(int height = TREE_HEIGHT_DEFAULT,
+                     size_t stash_limit = STASH_LIMIT_DEFAULT,
+                     int bucket_capacity = BUCKET_CAPACITY_DEFAULT)
+      : treeHeight(height), bucketCapacity(bucket_capacity),
+        dummySlots(ring_eviction_rate(bucket_capacity)), evictionRate(ring_eviction_rate(bucket_capacity)),
+        stashLimit(stash_limit), posMap(height, bucket_capacity),
+        keyPool(stash_limit), valuePool(stash_limit), accessCount(0), evictionCounter(0)
+    {
+        if (height < 0 || height > 31)
+            throw std::invalid_argument("RingObliviousMap height must be in [0, 31]");
+        if (bucket_capacity <= 0 || bucket_capacity + dummySlots > UINT16_MAX)
+            throw std::invalid_argument("RingObliviousMap bucket capacity out of range");
+
+        slotsPerBucket = static_cast<size_t>(bucketCapacity + dummySlots);
+        numBuckets = (static_cast<size_t>(1) << (height + 1)) - 1;
+        size_t slots = numBuckets * slotsPerBucket;
+        payloads.resize(slots);
+        slotLeaf.assign(slots, 0);
+        slotTag.assign(slots, 0);
+        slotState.assign(slots, RING_SLOT_FRESH);
+        bucketReads.assign(numBuckets + 1, 0);
+        staging.resize(height + 1);
+        for (auto& slotsAtDepth : staging) slotsAtDepth.reserve(bucketCapacity);
+        perm.resize(slotsPerBucket);
+        stash.reserve(stash_limit + static_cast<size_t>(height + 1) * bucket_capacity);
+    }
+
+    // Inserts or updates a key-value pair.
+    void oblivious_insert(const K& key, const V& value) {
+        TimedLock lock(mtx, stats);
+        AccessContext ctx = begin_access(key);
+        Block<K,V>& blk = (ctx.target != NO_BLOCK) ? stash[ctx.target] : create_block(key, ctx);
+        seal(value, blk.value);
+        end_access(ctx);
+    }
+
+    // Looks up a key.
+    bool oblivious_lookup(const K& key, V& value) {
+        TimedLock lock(mtx, stats);
+        AccessContext ctx = begin_access(key);
+        bool found = (ctx.target != NO_BLOCK);
+        if (found) {
+            unseal(stash[ctx.target].value, value);
+        }
+        end_access(ctx);
+        return found;
+    }
+
+    // Removes a key in one access. When `value` is given it receives the
+    // removed plaintext.
+    bool oblivious_remove(const K& key, V* value = nullptr) {
+        TimedLock lock(mtx, stats);
+        AccessContext ctx = begin_access(key);
+        bool found = (ctx.target != NO_BLOCK);
+        if (found) {
+            if (value) {
+                unseal(stash[ctx.target].value, *value);
+            }
+            discard_stash_block(ctx.target);
+            posMap.erase(key);
+        }
+        end_access(ctx);
+        return found;
+    }
+
+    void oblivious_insert_batch(const std::vector<std::pair<K,V>>& items) {
+        for (const auto& item : items) {
+            oblivious_insert(item.first, item.second);
+        }
+    }
+
+    size_t oblivious_lookup_batch(const std::vector<K>& keys, std::vector<V>& values,
+                                  std::vector<bool>& found) {
+        values.assign(keys.size(), V());
+        found.assign(keys.size(), false);
+        size_t hits = 0;
+        for (size_t i = 0; i < keys.size(); i++) {
+            found[i] = oblivious_lookup(keys[i], values[i]);
+            if (found[i]) hits++;
+        }
+        return hits;
+    }
+
+    // Bulk expiry over every real slot and the stash. Expired slots become
+    // unread dummies, so bucket layouts stay valid. Returns the number of
+    // entries removed.
+    template<typename Pred>
+    size_t expire_entries(Pred&& expired) {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        V plaintext;
+        size_t removed = 0;
+        for (size_t s = 0; s < payloads.size(); s++) {
+            if (!(slotState[s] & RING_SLOT_REAL)) continue;
+            unseal(payloads[s].value, plaintext);
+            if (expired(payloads[s].key, static_cast<const V&>(plaintext))) {
+                posMap.erase(payloads[s].key);
+                slotState[s] &= ~RING_SLOT_REAL;
+                removed++;
+            }
+        }
+
+        for (size_t i = 0; i < stash.size();) {
+            unseal(stash[i].value, plaintext);
+            if (expired(stash[i].key, static_cast<const V&>(plaintext))) {
+                posMap.erase(stash[i].key);
+                discard_stash_block(i);
+                removed++;
+            } else {
+                i++;
+            }
+        }
+        return removed;
+    }
+
+    // Fills an empty map in one linear pass (see ObliviousMap::bulk_load):
+    // each entry goes to a random fresh dummy slot of the deepest bucket on
+    // its path with room, so buckets stay randomly permuted and no
+    // evictions run. Entries must be sorted by key without repeats.
+    void bulk_load(const std::vector<std::pair<K,V>>& entries) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!is_empty())
+            throw std::runtime_error("bulk_load needs an empty map");
+        for (size_t i = 1; i < entries.size(); i++) {
+            if (!(entries[i - 1].first < entries[i].first))
+                throw std::invalid_argument("bulk_load entries must be sorted by key without repeats");
+        }
+
+        for (const auto& entry : entries) {
+            size_t leaf = secure_random_index(1 << treeHeight);
+            posMap.assign(entry.first, leaf);
+            K key = keyPool.acquire();
+            key = entry.first;
+            Block<K,V> blk(std::move(key), valuePool.acquire(), leaf);
+            CryptoEngine::local().encrypt_into(entry.second, blk.value);
+
+            bool placed = false;
+            for (int depth = treeHeight; depth >= 0 && !placed; depth--) {
+                placed = place_fresh(path_bucket_at_depth(leaf, depth, treeHeight), blk);
+            }
+            if (!placed) stash.push_back(std::move(blk));
+        }
+        if (stash.size() > stashLimit)
+            throw std::runtime_error("Ring ORAM stash overflow in bulk_load: too many entries for this tree");
+    }
+
+    // Writes every bucket's slot layout, the stash and the eviction state
+    // (see oram-snapshot.hpp): one header record, one record per bucket and
+    // one for the stash.
+    void save_snapshot(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        SnapshotWriter w(out);
+        w.u32(SNAPSHOT_KIND_RING);
+        w.u32(static_cast<uint32_t>(treeHeight));
+        w.u32(static_cast<uint32_t>(bucketCapacity));
+        w.u32(static_cast<uint32_t>(dummySlots));
+        w.u64(accessCount);
+        w.u64(evictionCounter);
+        w.end_record();
+
+        for (size_t bucket = 1; bucket <= numBuckets; bucket++) {
+            w.u32(bucketReads[bucket]);
+            size_t first = base(bucket);
+            for (size_t s = first; s < first + slotsPerBucket; s++) {
+                w.u8(slotState[s]);
+                if (slotState[s] & RING_SLOT_REAL) {
+                    w.u32(slotLeaf[s]);
+                    snapshot_write_key(w, payloads[s].key);
+                    w.bytes(payloads[s].value);
+                }
+            }
+            w.end_record();
+        }
+
+        w.u32(static_cast<uint32_t>(stash.size()));
+        for (const auto& blk : stash) {
+            w.u32(static_cast<uint32_t>(blk.leaf));
+            snapshot_write_key(w, blk.key);
+            w.bytes(blk.value);
+        }
+        w.end_record();
+    }
+
+    // Restores a snapshot written by save_snapshot into an empty map of the
+    // same geometry, rebuilding the position map and key tags.
+    void load_snapshot(std::istream& in) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!is_empty())
+            throw std::runtime_error("load_snapshot needs an empty map");
+
+        SnapshotReader r(in);
+        r.next_record();
+        r.expect(r.u32(), SNAPSHOT_KIND_RING, "kind");
+        r.expect(r.u32(), static_cast<uint32_t>(treeHeight), "tree height");
+        r.expect(r.u32(), static_cast<uint32_t>(bucketCapacity), "bucket capacity");
+        r.expect(r.u32(), static_cast<uint32_t>(dummySlots), "dummy slots");
+        accessCount = r.u64();
+        evictionCounter = r.u64();
+
+        size_t leaves = static_cast<size_t>(1) << treeHeight;
+        for (size_t bucket = 1; bucket <= numBuckets; bucket++) {
+            r.next_record();
+            bucketReads[bucket] = static_cast<uint16_t>(r.u32());
+            size_t first = base(bucket);
+            for (size_t s = first; s < first + slotsPerBucket; s++) {
+                slotState[s] = r.u8();
+                if (!(slotState[s] & RING_SLOT_REAL)) continue;
+                slotLeaf[s] = r.u32();
+                snapshot_read_key(r, payloads[s].key);
+                r.bytes(payloads[s].value);
+                if (slotLeaf[s] >= leaves)
+                    throw std::runtime_error("Snapshot block leaf out of range");
+                slotTag[s] = keyed_hash(payloads[s].key);
+                posMap.assign(payloads[s].key, slotLeaf[s]);
+            }
+        }
+
+        r.next_record();
+        uint32_t stashed = r.u32();
+        for (uint32_t i = 0; i < stashed; i++) {
+            size_t leaf = r.u32();
+            K key = keyPool.acquire();
+            V value = valuePool.acquire();
+            snapshot_read_key(r, key);
+            r.bytes(value);
+            if (leaf >= leaves)
+                throw std::runtime_error("Snapshot block leaf out of range");
+            posMap.assign(key, leaf);
+            stash.emplace_back(std::move(key), std::move(value), leaf);
+        }
+        // A stash over its limit is a state the map can be in (the excess
+        // carries from one access to the next, see end_access), so it
+        // loads as it was saved and the next accesses work it off.
+    }
+
+    // Reads one dummy slot per bucket on a random path.
+    void oblivious_dummy_access() {
+        TimedLock lock(mtx, stats);
+        AccessContext ctx;
+        ctx.pathLeaf = secure_random_index(1 << treeHeight);
+        for (int depth = 0; depth <= treeHeight; depth++) {
+            read_bucket(path_bucket_at_depth(ctx.pathLeaf, depth, treeHeight), K(), 0, false);
+        }
+        end_access(ctx);
+    }
+
+    // Runs deterministic evictions until the stash is empty, every leaf has
+    // been visited once or RING_FULL_EVICTION_PATHS paths were evicted, so
+    // one call holds the lock for a bounded time. Later calls carry on from
+    // the next path in order.
+    void trigger_full_eviction() {
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t paths = std::min(static_cast<size_t>(1) << treeHeight, RING_FULL_EVICTION_PATHS);
+        for (size_t i = 0; i < paths && !stash.empty(); i++) {
+            evict_next_path();
+        }
+    }
+
+    size_t getStashSize() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stash.size();
+    }
+
+    bool isUnderPressure() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stash.size() > stashLimit * EVICTION_HIGH_WATERMARK;
+    }
+
+    OramStats getStats() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats;
+    }
+
+    void resetStats() {
+        std::lock_guard<std::mutex> lock(mtx);
+        stats.clear();
+    }
+
+    // Number of live entries. Counts real slots, so it costs a pass over
+    // the slot states; meant for occasional sampling.
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t live = 0;
+        for (uint8_t state : slotState) {
+            if (state & RING_SLOT_REAL) live++;
+        }
+        for (const auto& blk : stash) {
+            if (blk.valid) live++;
+        }
+        return live;
+    }
+
+    int getTreeHeight() const { return treeHeight; }
+    int getBucketCapacity() const { return bucketCapacity; }
+    int getDummySlots() const { return dummySlots; }
+    int getEvictionRate() const { return evictionRate; }
+    size_t getStashLimit() const { return stashLimit; }
+    size_t getPositionMapBytes() const { return posMap.memory_bytes(); }
+};
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef SECURE_RANDOM_HPP
+#define SECURE_RANDOM_HPP
+
+/**
+ * ---------------------------------------------------------------------
+ * Buffered CSPRNG shared by the ORAM structures (tree-map.hpp,
+ * tree-queue.hpp) and the lightweight oblivious structures (ob-map.hpp,
+ * ob-queue.hpp).
+ *
+ * Each thread owns an AES-256-CTR keystream seeded from RAND_bytes. The
+ * keystream is generated in large chunks, so a stash-wide remap of a few
+ * hundred blocks costs one refill instead of one library call per leaf.
+ * The stream is rekeyed from RAND_bytes every SECURE_RANDOM_RESEED_BYTES.
+ * ---------------------------------------------------------------------
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <openssl/rand.h>
+#include <openssl/evp.h>
+
+constexpr size_t SECURE_RANDOM_BUFFER_BYTES = 4096;             // Keystream bytes per refill
+constexpr uint64_t SECURE_RANDOM_RESEED_BYTES = 1ull << 30;     // Rekey after 1 GiB of output
+
+/**
+ * uniform_below:
+ * Lemire's multiply-and-reject reduction of the 64-bit words returned by
+ * next() to an unbiased value in [0, range). Returns 0 if the range is 0.
+ * Kept apart from SecureRandom so the rejection step can be driven by a
+ * scripted source in tests.
+ */
+template<typename Next>
+uint64_t uniform_below(uint64_t range, Next&& next) {
+    if (range == 0) return 0;
+    __uint128_t m = static_cast<__uint128_t>(next()) * range;
+    uint64_t low = static_cast<uint64_t>(m);
+    if (low < range) {
+        uint64_t threshold = (0 - range) % range;
+        while (low < threshold) {
+            m = static_cast<__uint128_t>(next()) * range;
+            low = static_cast<uint64_t>(m);
+        }
+    }
+    return static_cast<uint64_t>(m >> 64);
+}
+
+/**
+ * SecureRandom:
+ * Thread-local buffered keystream generator. Use SecureRandom::local().
+ */
+class SecureRandom {
+public:
+    static SecureRandom& local() {
+        thread_local SecureRandom rng;
+        return rng;
+    }
+
+    SecureRandom(const SecureRandom&) = delete;
+    SecureRandom& operator=(const SecureRandom&) = delete;
+
+    ~SecureRandom() {
+        EVP_CIPHER_CTX_free(ctx);
+    }
+
+    uint32_t next_u32() {
+        uint32_t v;
+        take(&v, sizeof(v));
+        return v;
+    }
+
+    uint64_t next_u64() {
+        uint64_t v;
+        take(&v, sizeof(v));
+        return v;
+    }
+
+    /**
+     * uniform:
+     * Returns an unbiased value in [0, range) (see uniform_below).
+     * Returns 0 if the range is 0.
+     */
+    uint64_t uniform(uint64_t range) {
+        return uniform_below(range, [this] { return next_u64(); });
+    }
+
+private:
+    EVP_CIPHER_CTX* ctx;
+    unsigned char buffer[SECURE_RANDOM_BUFFER_BYTES];
+    size_t pos;
+    uint64_t produced;
+
+    SecureRandom() : ctx(nullptr), pos(SECURE_RANDOM_BUFFER_BYTES), produced(0) {
+        ctx = EVP_CIPHER_CTX_new();
+        if (!ctx)
+            throw std::runtime_error("EVP_CIPHER_CTX_new failed in SecureRandom");
+        reseed();
+    }
+
+    void reseed() {
+        unsigned char seed[32 + 16];
+        if (RAND_bytes(seed, sizeof(seed)) != 1)
+            throw std::runtime_error("RAND_bytes failed in SecureRandom");
+        if (EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), NULL, seed, seed + 32) != 1)
+            throw std::runtime_error("EVP_EncryptInit_ex failed in SecureRandom");
+        std::memset(seed, 0, sizeof(seed));
+        produced = 0;
+    }
+
+    void refill() {
+        if (produced >= SECURE_RANDOM_RESEED_BYTES) {
+            reseed();
+        }
+        // CTR mode over zeros yields the raw keystream.
+        std::memset(buffer, 0, sizeof(buffer));
+        int len = 0;
+        if (EVP_EncryptUpdate(ctx, buffer, &len, buffer, sizeof(buffer)) != 1 ||
+            len != static_cast<int>(sizeof(buffer)))
+            throw std::runtime_error("EVP_EncryptUpdate failed in SecureRandom");
+        produced += sizeof(buffer);
+        pos = 0;
+    }
+
+    void take(void* out, size_t n) {
+        if (pos + n > sizeof(buffer)) {
+            refill();
+        }
+        std::memcpy(out, buffer + pos, n);
+        // Consumed keystream is not kept around.
+        std::memset(buffer + pos, 0, n);
+        pos += n;
+    }
+};
+
+/**
+ * secure_random:
+ * Returns a cryptographically secure 32-bit random number.
+ */
+inline uint32_t secure_random() {
+    return SecureRandom::local().next_u32();
+}
+
+/**
+ * secure_random_index:
+ * Returns an unbiased random index in [0, range). Returns 0 if the range is 0.
+ */
+inline size_t secure_random_index(size_t range) {
+    return static_cast<size_t>(SecureRandom::local().uniform(range));
+}
+
+#endif
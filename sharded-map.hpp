@@ -0,0 +1,288 @@
+#ifndef SHARDED_MAP_HPP
+#define SHARDED_MAP_HPP
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+#include "crypto.hpp"
+#include "secure-random.hpp"
+#include "tree-map.hpp"
+#include "oram-engine.hpp"
+#include "oram-autotune.hpp"
+#include "oram-snapshot.hpp"
+
+// -------------------------
+// Default Configuration Parameters
+// -------------------------
+constexpr int SHARD_COUNT_DEFAULT = 1;        // Single ORAM, same as a plain ObliviousMap
+constexpr int SHARD_COVER_ACCESSES_DEFAULT = 0; // Dummy accesses to random shards per operation
+
+// -------------------------
+// ShardedObliviousMap Class (partitioned PathORAM)
+// -------------------------
+// Splits the key space over N independent sub-ORAMs, each with its own
+// tree, stash, position map and lock, so operations on different shards run
+// in parallel. Shards are ObliviousStores, so every shard runs the engine
+// (PathORAM or Ring ORAM) chosen at construction.
+//
+// The partition selector is a keyed PRF (SipHash under the process hash
+// key): an observer sees which shard is touched but cannot map names to
+// shards. Unlike partition ORAM, a key stays in its shard for its lifetime,
+// so repeated accesses to one key hit the same shard. Setting
+// `coverAccesses` > 0 adds that many dummy accesses to uniformly random
+// shards per operation, which blurs the per-shard access counts at the
+// cost of extra path reads.
+template<typename K, typename V>
+class ShardedObliviousMap {
+private:
+    std::vector<std::unique_ptr<ObliviousStore<K,V>>> shards;
+    int coverAccesses;
+
+    size_t shard_of(const K& key) const {
+        return static_cast<size_t>(keyed_hash(key) % shards.size());
+    }
+
+    void cover_traffic() {
+        for (int i = 0; i < coverAccesses; i++) {
+            shards[secure_random_index(shards.size())]->oblivious_dummy_access();
+        }
+    }
+
+    // One batched lookup per shard; with padTo > 0 every shard's batch is
+    // filled up to padTo keys with padKey(j).
+    template<typename PadKey>
+    size_t lookup_batch(const std::vector<K>& keys, std::vector<V>& values, std::vector<bool>& found,
+                        size_t padTo, PadKey&& padKey) {
+        std::vector<std::vector<K>> perShard(shards.size());
+        std::vector<std::vector<size_t>> origin(shards.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            size_t s = shard_of(keys[i]);
+            perShard[s].push_back(keys[i]);
+            origin[s].push_back(i);
+        }
+        
+        values.assign(keys.size(), V());
+        found.assign(keys.size(), false);
+        size_t hits = 0;
+        std::vector<V> shardValues;
+        std::vector<bool> shardFound;
+        for (size_t s = 0; s < shards.size(); s++) {
+            for (size_t j = 0; perShard[s].size() < padTo; j++) perShard[s].push_back(padKey(j));
+            if (perShard[s].empty()) continue;
+            shards[s]->oblivious_lookup_batch(perShard[s], shardValues, shardFound);
+            for (size_t j = 0; j < origin[s].size(); j++) {
+                values[origin[s][j]] = std::move(shardValues[j]);
+                found[origin[s][j]] = shardFound[j];
+                if (shardFound[j]) hits++;
+            }
+        }
+        for (size_t i = 0; i < keys.size(); i++) cover_traffic();
+        return hits;
+    }
+
+public:
+    // Each shard gets the given tree height, stash limit, bucket capacity,
+    // eviction mode and engine. With `storage` set, shard i keeps its tree
+    // in the file "<storage->path>.<i>". With `hashed_keys` every shard is
+    // keyed by hash_name() (see HashedNameStore). With `autotune` set, each
+    // shard is an AutotunedStore that grows its own tree under load, starting
+    // from `height`; it cannot be combined with `storage`. `posmap` picks the
+    // Path engine's position map.
+    ShardedObliviousMap(int numShards = SHARD_COUNT_DEFAULT,
+                        int height = TREE_HEIGHT_DEFAULT,
+                        size_t stash_limit = STASH_LIMIT_DEFAULT,
+                        int bucket_capacity = BUCKET_CAPACITY_DEFAULT,
+                        int cover_accesses = SHARD_COVER_ACCESSES_DEFAULT,
+                        EvictionMode mode = EvictionMode::Heuristic,
+                        OramEngine engine = OramEngine::Path,
+                        const MappedStorageConfig* storage = nullptr,
+                        bool hashed_keys = false,
+                        const AutotuneConfig* autotune = nullptr,
+                        PositionMapKind posmap = PositionMapKind::Hash)
+      : coverAccesses(cover_accesses)
+    {
+        if (numShards < 1)
+            throw std::invalid_argument("ShardedObliviousMap needs at least one shard");
+        if (autotune && storage)
+            throw std::invalid_argument("Autotuning cannot be combined with mapped storage");
+        shards.reserve(numShards);
+        for (int i = 0; i < numShards; i++) {
+            if (autotune) {
+                auto factory = [=](int h) {
+                    return make_oblivious_store<K,V>(engine, h, stash_limit, bucket_capacity, mode,
+                                                     nullptr, hashed_keys, posmap);
+                };
+                shards.push_back(std::unique_ptr<ObliviousStore<K,V>>(
+                    new AutotunedStore<K,V>(factory, height, *autotune)));
+            } else if (storage) {
+                MappedStorageConfig shardStorage = *storage;
+                shardStorage.path += "." + std::to_string(i);
+                shards.push_back(make_oblivious_store<K,V>(engine, height, stash_limit, bucket_capacity,
+                                                           mode, &shardStorage, hashed_keys, posmap));
+            } else {
+                shards.push_back(make_oblivious_store<K,V>(engine, height, stash_limit, bucket_capacity, mode,
+                                                           nullptr, hashed_keys, posmap));
+            }
+        }
+    }
+
+    void oblivious_insert(const K& key, const V& value) {
+        shards[shard_of(key)]->oblivious_insert(key, value);
+        cover_traffic();
+    }
+
+    bool oblivious_lookup(const K& key, V& value) {
+        bool found = shards[shard_of(key)]->oblivious_lookup(key, value);
+        cover_traffic();
+        return found;
+    }
+
+    bool oblivious_remove(const K& key, V* value = nullptr) {
+        bool found = shards[shard_of(key)]->oblivious_remove(key, value);
+        cover_traffic();
+        return found;
+    }
+
+    // Sweeps every shard; returns the total number of entries removed.
+    template<typename Pred>
+    size_t expire_entries(Pred&& expired) {
+        size_t removed = 0;
+        typename ObliviousStore<K,V>::ExpiryPredicate predicate(std::forward<Pred>(expired));
+        for (auto& shard : shards) {
+            removed += shard->expire_entries(predicate);
+        }
+        return removed;
+    }
+
+    // Splits the batch by shard and runs one batched access per shard.
+    void oblivious_insert_batch(const std::vector<std::pair<K,V>>& items) {
+        std::vector<std::vector<std::pair<K,V>>> perShard(shards.size());
+        for (const auto& item : items) {
+            perShard[shard_of(item.first)].push_back(item);
+        }
+        for (size_t s = 0; s < shards.size(); s++) {
+            if (!perShard[s].empty()) shards[s]->oblivious_insert_batch(perShard[s]);
+        }
+        for (size_t i = 0; i < items.size(); i++) cover_traffic();
+    }
+
+    // Splits the batch by shard and scatters the results back in key order.
+    size_t oblivious_lookup_batch(const std::vector<K>& keys, std::vector<V>& values,
+                                  std::vector<bool>& found) {
+        return lookup_batch(keys, values, found, 0, [](size_t) { return K(); });
+    }
+
+    // Same, but every shard runs a batch of exactly keys.size() lookups,
+    // topped up with padKey(0), padKey(1), ... (keys that are never
+    // present), so the per-shard batch sizes do not reveal how the keys
+    // split over the shards. Costs one full batch per shard.
+    template<typename PadKey>
+    size_t oblivious_lookup_batch_padded(const std::vector<K>& keys, std::vector<V>& values,
+                                         std::vector<bool>& found, PadKey&& padKey) {
+        return lookup_batch(keys, values, found, keys.size(), std::forward<PadKey>(padKey));
+    }
+
+    // Splits the sorted entries by shard (order is kept) and bulk-loads
+    // each shard.
+    void bulk_load(const std::vector<std::pair<K,V>>& entries) {
+        std::vector<std::vector<std::pair<K,V>>> perShard(shards.size());
+        for (const auto& entry : entries) {
+            perShard[shard_of(entry.first)].push_back(entry);
+        }
+        for (size_t s = 0; s < shards.size(); s++) {
+            shards[s]->bulk_load(perShard[s]);
+        }
+    }
+
+    // Writes a header with the shard count followed by each shard's own
+    // snapshot. Shard selection is keyed, so the snapshot only loads back
+    // under the same hash key.
+    void save_snapshot(std::ostream& out) {
+        SnapshotWriter w(out);
+        w.u32(SNAPSHOT_KIND_SHARDED);
+        w.u32(static_cast<uint32_t>(shards.size()));
+        w.end_record();
+        for (auto& shard : shards) {
+            shard->save_snapshot(out);
+        }
+    }
+
+    // Restores a snapshot written by save_snapshot into empty shards of the
+    // same count and geometry.
+    void load_snapshot(std::istream& in) {
+        SnapshotReader r(in);
+        r.next_record();
+        r.expect(r.u32(), SNAPSHOT_KIND_SHARDED, "kind");
+        r.expect(r.u32(), static_cast<uint32_t>(shards.size()), "shard count");
+        for (auto& shard : shards) {
+            shard->load_snapshot(in);
+        }
+    }
+
+    void trigger_full_eviction() {
+        for (auto& shard : shards) {
+            shard->trigger_full_eviction();
+        }
+    }
+
+    // Total stash occupancy across all shards.
+    size_t getStashSize() const {
+        size_t total = 0;
+        for (const auto& shard : shards) {
+            total += shard->getStashSize();
+        }
+        return total;
+    }
+
+    // Statistics of all shards merged.
+    OramStats getStats() const {
+        OramStats total;
+        for (const auto& shard : shards) {
+            total.merge(shard->getStats());
+        }
+        return total;
+    }
+
+    void resetStats() {
+        for (auto& shard : shards) {
+            shard->resetStats();
+        }
+    }
+
+    // True if any shard is above its background-eviction watermark.
+    bool isUnderPressure() const {
+        for (const auto& shard : shards) {
+            if (shard->isUnderPressure()) return true;
+        }
+        return false;
+    }
+
+    // Live entries over all shards.
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& shard : shards) total += shard->size();
+        return total;
+    }
+
+    size_t getShardCount() const { return shards.size(); }
+    // Shard that holds `key` (for routing work per shard, e.g. AsyncObliviousMap).
+    size_t shard_index(const K& key) const { return shard_of(key); }
+    ObliviousStore<K,V>& getShard(size_t i) { return *shards[i]; }
+    OramEngine getEngine() const { return shards[0]->getEngine(); }
+    // Tallest shard; shards only differ when autotuned.
+    int getTreeHeight() const {
+        int height = 0;
+        for (const auto& shard : shards) height = std::max(height, shard->getTreeHeight());
+        return height;
+    }
+    int getBucketCapacity() const { return shards[0]->getBucketCapacity(); }
+    size_t getStashLimit() const { return shards[0]->getStashLimit(); }
+};
+
+#endif
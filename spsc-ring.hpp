@@ -0,0 +1,94 @@
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <stdexcept>
+
+// -------------------------
+// SpscRing (lock-free single-producer/single-consumer queue)
+// -------------------------
+// Bounded ring with a power-of-two capacity. head is written only by the
+// consumer and tail only by the producer; each side keeps a cached copy of
+// the other's index and reloads it only when the ring looks full (or
+// empty), so a push or pop is normally one relaxed load, one slot move and
+// one release store. The two sides' fields sit on separate cache lines.
+// close() is called by the producer after its last push; the consumer sees
+// drained() once everything pushed before it has been popped.
+constexpr size_t SPSC_CACHE_LINE = 64;
+
+template<typename T>
+class SpscRing {
+private:
+    std::vector<T> slots;
+    size_t mask;
+
+    // Consumer side
+    alignas(SPSC_CACHE_LINE) std::atomic<size_t> head;
+    size_t cachedTail;
+
+    // Producer side
+    alignas(SPSC_CACHE_LINE) std::atomic<size_t> tail;
+    size_t cachedHead;
+    std::atomic<bool> closed;
+
+public:
+    // Capacity is rounded up to a power of two.
+    explicit SpscRing(size_t capacity)
+      : head(0), cachedTail(0), tail(0), cachedHead(0), closed(false) {
+        if (capacity == 0) throw std::invalid_argument("SpscRing capacity must be positive");
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer only. False if the ring is full.
+    bool try_push(T&& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead > mask) return false;
+        }
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. False if the ring is empty.
+    bool try_pop(T& out) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return false;
+        }
+        out = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only: no more pushes will follow.
+    void close() { closed.store(true, std::memory_order_release); }
+
+    // Consumer only: closed and empty. The flag is read before the tail so
+    // a push made just before close() is never missed.
+    bool drained() const {
+        bool done = closed.load(std::memory_order_acquire);
+        return done && head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+    }
+
+    // Approximate number of queued items (exact when called by either side
+    // while the other is idle).
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return mask + 1; }
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
@@ -7,6 +9,9 @@
 // (Make sure the include paths are set correctly in your build system.)
 #include "ob-map.hpp"
 #include "ob-queue.hpp"
+#include "oblivious-primitives.hpp"
+#include "spsc-ring.hpp"
+#include "oram-async.hpp"
 
 // Optionally include the NDNRouter from ob-sim.cpp if refactored to be testable.
 // For demonstration, we re-declare minimal structures for testing.
@@ -97,6 +102,59 @@ TEST(ObliviousMapTest, InsertLookupRemove) {
     EXPECT_FALSE(found);
 }
 
+TEST(ObliviousMapTest, SlotTableGrowsAndOverwrites) {
+    ObliviousMap<std::string, int> map(1);
+    const int n = 5000;       // far past the initial slot count
+    for (int i = 0; i < n; i++) {
+        map.oblivious_insert("/name/" + std::to_string(i), i);
+    }
+    map.oblivious_insert("/name/7", -7);
+    EXPECT_EQ(map.size(), static_cast<size_t>(n));
+    
+    for (int i = 0; i < n; i += 2) {
+        map.oblivious_remove("/name/" + std::to_string(i));
+    }
+    EXPECT_EQ(map.size(), static_cast<size_t>(n / 2));
+    
+    int value = 0;
+    for (int i = 0; i < n; i++) {
+        bool found = map.oblivious_lookup("/name/" + std::to_string(i), value);
+        ASSERT_EQ(found, i % 2 == 1) << i;
+        if (found) {
+            EXPECT_EQ(value, i == 7 ? -7 : i);
+        }
+    }
+}
+
+TEST(ObliviousMapTest, FullGroupFailsInsteadOfGrowingForever) {
+    // Under a known table key, collect nine keys that share a group at
+    // every size insert() will try, so the ninth can never be placed.
+    unsigned char hashKey[SIPHASH_KEY_SIZE] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    const size_t groups = OB_MAP_INITIAL_GROUPS * 2 << OB_MAP_MAX_GROWTHS;
+    std::vector<std::vector<std::string>> byGroup(groups);
+    std::vector<std::string> colliding;
+    for (int i = 0; colliding.empty(); i++) {
+        std::string key = "/c/" + std::to_string(i);
+        auto& group = byGroup[(slot_tag_hash(key, hashKey) >> 32) & (groups - 1)];
+        group.push_back(key);
+        if (group.size() == OB_MAP_GROUP_SLOTS + 1) colliding = group;
+    }
+
+    ObliviousSlotTable<std::string, int> table(hashKey);
+    for (size_t i = 0; i < OB_MAP_GROUP_SLOTS; i++) table.insert(colliding[i], static_cast<int>(i));
+    EXPECT_THROW(table.insert(colliding.back(), -1), std::runtime_error);
+
+    // The failed insert leaves the table untouched
+    EXPECT_EQ(table.size(), OB_MAP_GROUP_SLOTS);
+    EXPECT_EQ(table.slots(), OB_MAP_INITIAL_GROUPS * OB_MAP_GROUP_SLOTS);
+    int value = 0;
+    for (size_t i = 0; i < OB_MAP_GROUP_SLOTS; i++) {
+        ASSERT_TRUE(table.lookup(colliding[i], value));
+        EXPECT_EQ(value, static_cast<int>(i));
+    }
+    EXPECT_FALSE(table.lookup(colliding.back(), value));
+}
+
 // -----------------------
 // ObliviousQueue Unit Tests
 // -----------------------
@@ -127,6 +185,137 @@ TEST(ObliviousQueueTest, PushPopAndOverflow) {
     EXPECT_FALSE(queue.oblivious_pop(val));
 }
 
+// -----------------------
+// SecureRandom Unit Tests
+// -----------------------
+
+TEST(SecureRandomTest, IndexStaysInRangeAndCoversIt) {
+    // Rejection only happens with probability about range / 2^64, so random
+    // draws practically never reach it; see RejectsTheBiasedLowWords.
+    const size_t range = 7;
+    int counts[range] = {0};
+    for (int i = 0; i < 7000; i++) {
+        size_t idx = secure_random_index(range);
+        ASSERT_LT(idx, range);
+        counts[idx]++;
+    }
+    for (size_t i = 0; i < range; i++) {
+        EXPECT_GT(counts[i], 0);
+    }
+    EXPECT_EQ(secure_random_index(0), 0u);
+}
+
+TEST(SecureRandomTest, RejectsTheBiasedLowWords) {
+    // For range 7, 2^64 mod 7 = 2, so words whose product with 7 has a low
+    // half below 2 are biased and must be redrawn. 0 is one of them; the
+    // next word, 2^64 - 1, maps to 6.
+    std::vector<uint64_t> script = {0, UINT64_MAX};
+    size_t drawn = 0;
+    auto next = [&] { return script.at(drawn++); };
+    EXPECT_EQ(uniform_below(7, next), 6u);
+    EXPECT_EQ(drawn, 2u);
+
+    // A word with a low half of at least the threshold is accepted at once
+    script = {UINT64_MAX / 7 + 1, 0};
+    drawn = 0;
+    EXPECT_EQ(uniform_below(7, next), 1u);
+    EXPECT_EQ(drawn, 1u);
+
+    // Powers of two have no biased words
+    script = {0};
+    drawn = 0;
+    EXPECT_EQ(uniform_below(8, next), 0u);
+    EXPECT_EQ(drawn, 1u);
+}
+
+// -----------------------
+// Oblivious Primitive Unit Tests
+// -----------------------
+
+TEST(ObliviousPrimitivesTest, ScanKernelsAgreeAndSortOrders) {
+    std::vector<uint64_t> v(257);
+    for (size_t i = 0; i < v.size(); i++) v[i] = (i * 37) % 101;
+    for (uint64_t needle : {0ull, 5ull, 100ull, 1000ull}) {
+        for (size_t n : {size_t(0), size_t(3), size_t(8), v.size()}) {
+            size_t want = n;
+            for (size_t i = 0; i < n; i++) {
+                if (v[i] == needle) want = i;
+            }
+            EXPECT_EQ(ct_find_u64_portable(v.data(), n, needle), want);
+            EXPECT_EQ(ct_find_u64(v.data(), n, needle), want) << ct_find_kernel_name();
+        }
+    }
+    EXPECT_EQ(ct_select_u64(true, 1, 2), 1u);
+    EXPECT_EQ(ct_select_u64(false, 1, 2), 2u);
+    
+    std::vector<uint64_t> sorted = v;
+    bitonic_sort_u64(sorted);
+    std::vector<uint64_t> reference = v;
+    std::sort(reference.begin(), reference.end());
+    EXPECT_EQ(sorted, reference);
+}
+
+// -----------------------
+// SpscRing Unit Tests
+// -----------------------
+
+TEST(SpscRingTest, KeepsOrderAcrossThreads) {
+    SpscRing<uint64_t> ring(1000);
+    EXPECT_EQ(ring.capacity(), 1024u);
+    
+    const uint64_t count = 100000;
+    std::thread producer([&ring, count] {
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t v = i;
+            while (!ring.try_push(std::move(v))) std::this_thread::yield();
+        }
+        ring.close();
+    });
+    
+    uint64_t expected = 0, v = 0;
+    bool ordered = true;
+    while (!ring.drained()) {
+        if (!ring.try_pop(v)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered = ordered && v == expected;
+        expected++;
+    }
+    producer.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(expected, count);
+    EXPECT_FALSE(ring.try_pop(v));
+}
+
+// -----------------------
+// Async Access Unit Tests
+// -----------------------
+
+TEST(AsyncObliviousMapTest, KeepsPerKeyOrderAndPropagatesErrors) {
+    // ob-map is not thread-safe, so everything runs on one strand
+    OramStrandPool pool(1, 4);
+    ObliviousMap<std::string, int> map;
+    AsyncObliviousMap<std::string, int, ObliviousMap<std::string, int>> asyncMap(
+        map, pool, [](const std::string&) { return size_t(0); });
+    
+    std::vector<std::future<AsyncResult<int>>> lookups;
+    for (int i = 1; i <= 20; i++) {
+        asyncMap.async_insert("key", i);
+        lookups.push_back(asyncMap.async_lookup("key"));
+    }
+    for (int i = 1; i <= 20; i++) {
+        AsyncResult<int> r = lookups[i - 1].get();
+        EXPECT_TRUE(r.found);
+        EXPECT_EQ(r.value, i);
+    }
+    EXPECT_FALSE(asyncMap.async_lookup("absent").get().found);
+    
+    std::future<int> failed = pool.post(0, []() -> int { throw std::runtime_error("boom"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+    EXPECT_EQ(pool.post(0, [] { return 7; }).get(), 7);
+}
+
 // -----------------------
 // NDNRouter Integration Tests
 // -----------------------
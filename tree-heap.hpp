@@ -0,0 +1,332 @@
+#ifndef TREE_HEAP_HPP
+#define TREE_HEAP_HPP
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+#include <string>
+#include <mutex>
+
+#include "crypto.hpp"
+#include "secure-random.hpp"
+#include "path-eviction.hpp"
+#include "oram-storage.hpp"
+#include "eviction-scheduler.hpp"
+#include "oram-metrics.hpp"
+#include "oblivious-primitives.hpp"
+
+// -------------------------
+// Configuration Parameters
+// -------------------------
+constexpr int HEAP_TREE_HEIGHT_DEFAULT = 8;        // Default tree height for the heap
+constexpr int HEAP_BUCKET_CAPACITY_DEFAULT = 4;    // Z; two evictions per operation keep this small
+constexpr size_t HEAP_STASH_LIMIT_DEFAULT = 250;   // Same budget as the map and queue
+
+// Handle returned by insert: the element id and the leaf it was assigned.
+// Needed to remove or re-prioritise an element that is not the minimum.
+struct HeapRef {
+    uint64_t id;
+    size_t leaf;
+};
+
+// -------------------------
+// HeapBlock Structure
+// -------------------------
+template<typename T, typename P>
+struct HeapBlock {
+    bool valid;
+    P priority;
+    uint64_t id;   // Insertion order; breaks ties between equal priorities
+    T data;
+    size_t leaf;   // Assigned leaf index
+
+    HeapBlock() : valid(false), priority(), id(0), data(), leaf(0) {}
+    HeapBlock(const P& p, uint64_t id_, T&& d, size_t leaf_)
+      : valid(true), priority(p), id(id_), data(std::move(d)), leaf(leaf_) {}
+
+    // Move-only, like the map's Block.
+    HeapBlock(const HeapBlock&) = delete;
+    HeapBlock& operator=(const HeapBlock&) = delete;
+    HeapBlock(HeapBlock&&) = default;
+    HeapBlock& operator=(HeapBlock&&) = default;
+};
+
+// Tree slot contents.
+template<typename T, typename P>
+struct HeapSlot {
+    P priority;
+    uint64_t id;
+    T data;
+};
+
+// Smallest element of a subtree (or of the stash).
+template<typename P>
+struct HeapMin {
+    bool valid;
+    P priority;
+    uint64_t id;
+    size_t leaf;
+
+    HeapMin() : valid(false), priority(), id(0), leaf(0) {}
+    HeapMin(const P& p, uint64_t id_, size_t leaf_) : valid(true), priority(p), id(id_), leaf(leaf_) {}
+
+    bool before(const HeapMin& other) const {
+        if (!valid) return false;
+        if (!other.valid) return true;
+        if (priority < other.priority) return true;
+        if (other.priority < priority) return false;
+        return id < other.id;
+    }
+};
+
+// -------------------------
+// ObliviousHeap Class (Path Oblivious Heap)
+// -------------------------
+// A PathORAM tree where every bucket also records the minimum element of
+// its subtree (Shi, "Path Oblivious Heap", 2019). Elements keep the random
+// leaf they were inserted with, so no position map is needed:
+//   - find-min reads the root's subtree minimum and the stash;
+//   - insert adds the block to the stash and evicts two random paths;
+//   - extract-min / remove read the path to the element's leaf, remove it,
+//     write the path back and evict one more random path.
+// Every write-back recomputes the subtree minima bottom-up along its path.
+// Each operation therefore touches O(1) paths regardless of stash
+// occupancy; a stash left over its limit gets a few extra random-path
+// evictions (see write_path) and otherwise carries over. Used with P = access time (LRU) or hit count (LFU) for cache
+// replacement; lower priorities come out first.
+template<typename T, typename P = uint64_t>
+class ObliviousHeap {
+private:
+    FlatTree<HeapSlot<T,P>> tree;          // The ORAM tree (1-indexed, contiguous)
+    int treeHeight;
+    std::vector<HeapBlock<T,P>> stash;
+    size_t stashLimit;
+    int bucketCapacity;
+    std::vector<HeapMin<P>> subtreeMin;    // Per bucket (index 0 unused)
+    uint64_t nextId;
+    size_t count;
+    mutable std::mutex mtx;                // Global mutex for all operations
+    PathEvictor evictor;                   // Reusable greedy eviction engine
+    BufferPool<T> dataPool;                // buffers of removed blocks
+    std::vector<uint64_t> idScratch;       // stash element ids for ct_find_u64
+    OramStats stats;                       // per-phase timings and counters (under mtx)
+
+    bool place_block(size_t bucketIndex, HeapBlock<T,P>& blk) {
+        // Check first: storing moves the block's data out.
+        if (tree.occupancy(bucketIndex) >= bucketCapacity) return false;
+        bool stored = tree.store(bucketIndex, blk.leaf, 0,
+                                 HeapSlot<T,P>{blk.priority, blk.id, std::move(blk.data)});
+        if (stored) stats.blocksWritten++;
+        return stored;
+    }
+
+    // Reads blocks along the path to the given leaf into the stash.
+    void read_path(size_t leaf) {
+        PhaseTimer timer(stats, OramPhase::ReadPath);
+        for (int depth = 0; depth <= treeHeight; depth++) {
+            tree.drain(path_bucket_at_depth(leaf, depth, treeHeight),
+                [this](size_t blkLeaf, uint8_t, HeapSlot<T,P>&& slot) {
+                    stash.emplace_back(slot.priority, slot.id, std::move(slot.data), blkLeaf);
+                    stats.blocksRead++;
+                });
+        }
+        stats.note_stash(stash.size());
+    }
+
+    // Evicts onto the path and recomputes subtree minima from leaf to root.
+    void write_back(size_t leaf) {
+        PhaseTimer timer(stats, OramPhase::WritePath);
+        evictor.evict_path(stash, leaf, treeHeight,
+            [this](size_t bucketIndex, HeapBlock<T,P>& blk) { return place_block(bucketIndex, blk); });
+
+        for (int depth = treeHeight; depth >= 0; depth--) {
+            size_t bucketIndex = path_bucket_at_depth(leaf, depth, treeHeight);
+            HeapMin<P> best;
+            tree.visit(bucketIndex, [&best](size_t blkLeaf, uint8_t, const HeapSlot<T,P>& slot) {
+                HeapMin<P> candidate(slot.priority, slot.id, blkLeaf);
+                if (candidate.before(best)) best = candidate;
+            });
+            if (depth < treeHeight) {
+                if (subtreeMin[2 * bucketIndex].before(best)) best = subtreeMin[2 * bucketIndex];
+                if (subtreeMin[2 * bucketIndex + 1].before(best)) best = subtreeMin[2 * bucketIndex + 1];
+            }
+            subtreeMin[bucketIndex] = best;
+        }
+    }
+
+    // Writes the accessed path back, then evicts up to
+    // BOUNDED_OVERFLOW_EVICTIONS random paths while the stash is over its
+    // limit. The operation has already taken effect, so whatever is left
+    // over carries to the next access.
+    void write_path(size_t leaf) {
+        write_back(leaf);
+        for (int i = 0; i < BOUNDED_OVERFLOW_EVICTIONS && stash.size() > stashLimit; i++) {
+            size_t extra = secure_random_index(1 << treeHeight);
+            read_path(extra);
+            write_back(extra);
+        }
+    }
+
+    void evict_random_path() {
+        size_t leaf = secure_random_index(1 << treeHeight);
+        read_path(leaf);
+        write_path(leaf);
+    }
+
+    HeapMin<P> global_min() const {
+        HeapMin<P> best = subtreeMin[1];
+        for (const auto& blk : stash) {
+            HeapMin<P> candidate(blk.priority, blk.id, blk.leaf);
+            if (blk.valid && candidate.before(best)) best = candidate;
+        }
+        return best;
+    }
+
+    // Reads the element's path, removes it, writes back and evicts once
+    // more. Looks the same whether or not the element is found.
+    bool remove_locked(uint64_t id, size_t leaf, P* priority, T* value) {
+        read_path(leaf);
+
+        // One branch-free scan of every stash id, found or not (ids are
+        // unique, and no block carries the dummy ids)
+        size_t n = stash.size();
+        idScratch.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            idScratch[i] = ct_select_u64(stash[i].valid, stash[i].id, ~id);
+        }
+        size_t hit = ct_find_u64(idScratch.data(), n, id);
+
+        bool found = (hit != n);
+        if (found) {
+            if (priority) *priority = stash[hit].priority;
+            if (value) {
+                PhaseTimer timer(stats, OramPhase::Crypto);
+                CryptoEngine::local().decrypt_into(stash[hit].data, *value);
+            }
+            dataPool.release(stash[hit].data);
+            stash_swap_remove(stash, hit);
+            count--;
+        }
+
+        write_path(leaf);
+        evict_random_path();
+        return found;
+    }
+
+public:
+    ObliviousHeap(int height = HEAP_TREE_HEIGHT_DEFAULT,
+                  size_t stash_limit = HEAP_STASH_LIMIT_DEFAULT,
+                  int bucket_capacity = HEAP_BUCKET_CAPACITY_DEFAULT)
+      : tree(height, bucket_capacity), treeHeight(height), stashLimit(stash_limit),
+        bucketCapacity(bucket_capacity), nextId(0), count(0), dataPool(stash_limit)
+    {
+        subtreeMin.resize(tree.bucket_count() + 1);
+        stash.reserve(stash_limit + static_cast<size_t>(height + 1) * bucket_capacity);
+    }
+
+    // Inserts an item with the given priority and returns its handle.
+    HeapRef oblivious_insert(const P& priority, const T& item) {
+        TimedLock lock(mtx, stats);
+
+        HeapRef ref{nextId++, secure_random_index(1 << treeHeight)};
+        stash.emplace_back(priority, ref.id, dataPool.acquire(), ref.leaf);
+        {
+            PhaseTimer timer(stats, OramPhase::Crypto);
+            CryptoEngine::local().encrypt_into(item, stash.back().data);
+        }
+        count++;
+
+        evict_random_path();
+        evict_random_path();
+        return ref;
+    }
+
+    // Same two random-path evictions as an insert, adding nothing.
+    void oblivious_dummy_insert() {
+        TimedLock lock(mtx, stats);
+        evict_random_path();
+        evict_random_path();
+    }
+
+    // Handle that matches no element, for a remove that must look real.
+    HeapRef dummy_ref() const {
+        return HeapRef{UINT64_MAX, secure_random_index(1 << treeHeight)};
+    }
+
+    // Reports the minimum without touching the tree. Returns false if empty.
+    bool oblivious_find_min(P& priority, HeapRef& ref) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        HeapMin<P> best = global_min();
+        if (!best.valid) return false;
+        priority = best.priority;
+        ref = HeapRef{best.id, best.leaf};
+        return true;
+    }
+
+    // Removes and returns the minimum. An empty heap still reads and
+    // evicts random paths, so emptiness is not visible in the access pattern.
+    bool oblivious_extract_min(P& priority, T& item) {
+        TimedLock lock(mtx, stats);
+        HeapMin<P> best = global_min();
+        if (!best.valid) {
+            remove_locked(nextId, secure_random_index(1 << treeHeight), nullptr, nullptr);
+            return false;
+        }
+        return remove_locked(best.id, best.leaf, &priority, &item);
+    }
+
+    // Removes an arbitrary element by handle. When `item` is given it
+    // receives the removed plaintext.
+    bool oblivious_remove(const HeapRef& ref, T* item = nullptr) {
+        TimedLock lock(mtx, stats);
+        return remove_locked(ref.id, ref.leaf, nullptr, item);
+    }
+
+    // Changes an element's priority (e.g. refreshes an LRU timestamp) by
+    // removing and re-inserting it. Returns the new handle; `ref` is stale.
+    HeapRef oblivious_update_priority(const HeapRef& ref, const P& priority) {
+        T item;
+        if (!oblivious_remove(ref, &item)) {
+            throw std::runtime_error("Heap element not found for priority update");
+        }
+        return oblivious_insert(priority, item);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return count;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t getStashSize() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stash.size();
+    }
+
+    // True while the stash is above the background-eviction watermark, as
+    // for the map and queue. The heap evicts inline on every operation, so
+    // this only serves as back-pressure for its owner.
+    bool isUnderPressure() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stash.size() > stashLimit * EVICTION_HIGH_WATERMARK;
+    }
+
+    // Copy of the per-phase statistics (see oram-metrics.hpp).
+    OramStats getStats() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats;
+    }
+
+    void resetStats() {
+        std::lock_guard<std::mutex> lock(mtx);
+        stats.clear();
+    }
+
+    int getTreeHeight() const { return treeHeight; }
+    int getBucketCapacity() const { return bucketCapacity; }
+    size_t getStashLimit() const { return stashLimit; }
+};
+
+#endif
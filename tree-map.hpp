@@ -5,16 +5,25 @@
 #include <vector>
 #include <stdexcept>
 #include <cstdint>
-#include <atomic>
 #include <unordered_map>
 #include <string>
 #include <algorithm>
+#include <functional>
+#include <type_traits>
 #include <cassert>
 #include <mutex>
-#include <thread>
-#include <chrono>
 
 #include "crypto.hpp"
+#include "secure-random.hpp"
+#include "path-eviction.hpp"
+#include "oram-storage.hpp"
+#include "eviction-scheduler.hpp"
+#include "position-map.hpp"
+#include "oram-snapshot.hpp"
+#include "oram-metrics.hpp"
+#include "oram-log.hpp"
+#include "oblivious-primitives.hpp"
+#include "hashed-name.hpp"
 
 // -------------------------
 // Default Configuration Parameters - SIGNIFICANTLY INCREASED
@@ -24,23 +33,18 @@ constexpr int BUCKET_CAPACITY_DEFAULT = 20;          // Increased from 12 to 20
 constexpr size_t STASH_LIMIT_DEFAULT = 250;          // Increased from 100 to 250
 
 // -------------------------
-// Utility Functions
+// Block and Slot Structures - SIMPLIFIED
 // -------------------------
-inline uint32_t secure_random() {
-    uint32_t num;
-    if (RAND_bytes(reinterpret_cast<unsigned char*>(&num), sizeof(num)) != 1) {
-        throw std::runtime_error("RAND_bytes failed in secure_random");
-    }
-    return num;
-}
+// Stash lookups compare 64-bit key tags with ct_find_u64 and check the key
+// itself only at the matching index. Tags are computed once when a block is
+// created and travel with it through the tree, so reading a path hashes
+// nothing.
+inline uint64_t block_tag(const std::string& key) { return keyed_hash(key); }
+inline uint64_t block_tag(const NameKey& key) { return key.low; }
 
-inline size_t secure_random_index(size_t range) {
-    return (range == 0) ? 0 : secure_random() % range;
-}
+template<typename K>
+uint64_t block_tag(const K& key) { return static_cast<uint64_t>(std::hash<K>{}(key)); }
 
-// -------------------------
-// Block and Bucket Structures - SIMPLIFIED
-// -------------------------
 template<typename K, typename V>
 struct Block {
     bool valid;  
@@ -49,87 +53,241 @@ struct Block {
     size_t leaf; // assigned leaf index
     int eviction_attempt_count; // Track how many times we've tried to evict this block
     bool high_priority; // Flag for high-priority blocks that shouldn't be dropped
+    uint64_t tag; // block_tag(key)
 
-    Block() : valid(false), key(), value(), leaf(0), eviction_attempt_count(0), high_priority(false) {}
+    Block() : valid(false), key(), value(), leaf(0), eviction_attempt_count(0), high_priority(false), tag(0) {}
     Block(const K& k, const V& v, size_t leaf_, bool hp = false) 
-        : valid(true), key(k), value(v), leaf(leaf_), eviction_attempt_count(0), high_priority(hp) {}
+        : valid(true), key(k), value(v), leaf(leaf_), eviction_attempt_count(0), high_priority(hp),
+          tag(block_tag(key)) {}
+    Block(K&& k, V&& v, size_t leaf_, bool hp = false) 
+        : valid(true), key(std::move(k)), value(std::move(v)), leaf(leaf_), eviction_attempt_count(0), high_priority(hp),
+          tag(block_tag(key)) {}
+    // For blocks whose tag is already known (read back from the tree)
+    Block(K&& k, V&& v, size_t leaf_, bool hp, uint64_t tag_) 
+        : valid(true), key(std::move(k)), value(std::move(v)), leaf(leaf_), eviction_attempt_count(0), high_priority(hp),
+          tag(tag_) {}
+
+    // Move-only: blocks change hands between the tree, the stash and the
+    // buffer pools, and a copy would duplicate both buffers.
+    Block(const Block&) = delete;
+    Block& operator=(const Block&) = delete;
+    Block(Block&&) = default;
+    Block& operator=(Block&&) = default;
 };
 
+// Per-slot payload kept in the tree arena; validity, leaf and priority live
+// in the arena's dense metadata arrays instead.
 template<typename K, typename V>
-struct Bucket {
-    std::vector<Block<K,V>> blocks;
-    
-    Bucket() {
-        blocks.resize(BUCKET_CAPACITY_DEFAULT);
-    }
-    
-    explicit Bucket(int capacity) {
-        blocks.resize(capacity);
-    }
+struct MapSlot {
+    K key;
+    V value;
+    uint64_t tag = 0;   // block_tag(key)
 };
 
 // -------------------------
 // ObliviousMap Class (PathORAM-based)
 // -------------------------
-template<typename K, typename V>
-class ObliviousMap {
+// PosMap selects the position map policy (see position-map.hpp):
+// HashPositionMap (exact, default), CompactPositionMap (packed hashed ids)
+// or RecursivePositionMap (stored in a smaller ORAM, defined below).
+// Storage holds the buckets: FlatTree in RAM by default, or any type with
+// the same drain/store/occupancy interface (e.g. MappedTree).
+template<typename K, typename V, typename PosMap = HashPositionMap<K>,
+         typename Storage = FlatTree<MapSlot<K,V>>>
+class ObliviousMap : public EvictionClient {
 private:
-    std::vector<Bucket<K,V>> tree;         // The ORAM tree (1-indexed)
+    Storage tree;                          // The ORAM tree (1-indexed)
     int numBuckets;                        
     int treeHeight;                        
     std::vector<Block<K,V>> stash;         
     size_t stashLimit;                     
     int bucketCapacity;                    
-    std::unordered_map<K, size_t> posMap;  
+    PosMap posMap;                         
     mutable std::mutex mtx;                // Global mutex for all operations
     int evictionFailCount; // Track consecutive eviction failures
     bool dropNonEssentialBlocks; // Flag to enable dropping non-essential blocks in emergencies
-    
-    // Background eviction thread components.
-    std::atomic<bool> evictionThreadRunning;
-    std::thread evictionThread;
+    PathEvictor evictor;                   // Reusable greedy eviction engine
+    std::vector<size_t> touched;        // buckets read by the current access
+    std::vector<uint64_t> scanScratch;  // stash tags or sort keys for the oblivious primitives
+    std::vector<uint8_t> touchedMark;   // per bucket: 1 while in `touched`
+    EvictionMode evictionMode;
+    uint64_t evictionCounter;           // deterministic evictions done (Bounded mode)
+    EvictionScheduler& scheduler;          // Shared background eviction pool
+    BufferPool<K> keyPool;                 // buffers of blocks that left the stash
+    BufferPool<V> valuePool;
+    V plainScratch;                        // plaintext buffer reused across accesses
+    OramStats stats;                       // per-phase timings and counters (under mtx)
+
+    friend struct OramBenchAccess;         // oram-bench.cpp times the private primitives
 
     int compute_numBuckets(int height) {
         return (1 << (height + 1)) - 1;
     }
 
-    // Returns the path from a leaf to the root.
+    // Returns the path from the root to a leaf.
     std::vector<int> get_path_indices(size_t leaf) {
-        std::vector<int> path;
-        int index = (1 << treeHeight) - 1 + leaf;
-        while (index > 0) {
-            path.push_back(index);
-            index /= 2;
+        std::vector<int> path(treeHeight + 1);
+        for (int depth = 0; depth <= treeHeight; depth++) {
+            path[depth] = static_cast<int>(path_bucket_at_depth(leaf, depth, treeHeight));
         }
-        std::reverse(path.begin(), path.end());
         return path;
     }
 
-    // Reads blocks along the given path into the stash.
-    void read_path(const std::vector<int>& path) {
+    // Moves a block into a free slot of the given bucket; false if it is full.
+    // The eviction attempt counter is not stored in the tree, so it restarts
+    // at zero when the block is read back.
+    bool place_block(size_t bucketIndex, Block<K,V>& blk) {
+        uint8_t flags = blk.high_priority ? SLOT_HIGH_PRIORITY : 0;
+        // Check first: building the slot moves the block's key and value out.
+        if (tree.occupancy(bucketIndex) >= bucketCapacity) return false;
+        bool stored = tree.store(bucketIndex, blk.leaf, flags,
+                                 MapSlot<K,V>{std::move(blk.key), std::move(blk.value), blk.tag});
+        if (stored) stats.blocksWritten++;
+        return stored;
+    }
+
+    // Storage with fixed-size slots (MappedTree) says whether a block fits;
+    // FlatTree takes anything.
+    template<typename S>
+    static auto slot_accepts(const S& store, const K& key, size_t valueBytes, int)
+        -> decltype(store.accepts(key, valueBytes)) {
+        return store.accepts(key, valueBytes);
+    }
+    template<typename S>
+    static bool slot_accepts(const S&, const K&, size_t, long) { return true; }
+
+    // Storage that survives a restart (MappedTree with `reopen`) hands back
+    // the stash and eviction epoch it kept, and the position map is rebuilt
+    // from every stored block's leaf, as load_snapshot does. FlatTree keeps
+    // nothing.
+    template<typename S>
+    auto restore_from_storage(S& store, int) -> decltype(store.reopened(), void()) {
+        if (!store.reopened()) return;
+        size_t leaves = static_cast<size_t>(1) << treeHeight;
+        auto adopt = [&](size_t blkLeaf, const K& key) {
+            if (blkLeaf >= leaves) throw std::runtime_error("Stored block leaf out of range");
+            posMap.assign(key, blkLeaf);
+        };
+        for (size_t bucketIndex = 1; bucketIndex <= store.bucket_count(); bucketIndex++) {
+            store.visit(bucketIndex, [&](size_t blkLeaf, uint8_t, const MapSlot<K,V>& slot) {
+                adopt(blkLeaf, slot.key);
+            });
+        }
+        evictionCounter = store.restore_stash([&](size_t blkLeaf, uint8_t flags, MapSlot<K,V>&& slot) {
+            adopt(blkLeaf, slot.key);
+            stash.emplace_back(std::move(slot.key), std::move(slot.value), blkLeaf,
+                               (flags & SLOT_HIGH_PRIORITY) != 0, slot.tag);
+        });
+    }
+    template<typename S>
+    void restore_from_storage(S&, long) {}
+
+    // Counterpart of restore_from_storage, run by the destructor: places
+    // what it can of the stash in the tree and hands the rest to the
+    // storage. A stash the storage cannot keep leaves the file unclean,
+    // so it is refused on reopen rather than read without those blocks.
+    template<typename S>
+    auto persist_to_storage(S& store, int) -> decltype(store.stash_capacity(), void()) {
+        std::lock_guard<std::mutex> lock(mtx);
+        evictor.evict_tree(stash, treeHeight,
+            [this](size_t bucketIndex, Block<K,V>& blk) { return place_block(bucketIndex, blk); });
+        if (stash.size() > store.stash_capacity()) {
+            ORAM_ERROR("[Storage] Stash of " << stash.size() << " blocks exceeds the "
+                       << store.stash_capacity() << " the file can keep; tree not closed cleanly");
+            return;
+        }
+        store.close_clean(evictionCounter, stash.size(), [this](size_t i, size_t& blkLeaf, uint8_t& flags) {
+            const Block<K,V>& blk = stash[i];
+            blkLeaf = blk.leaf;
+            flags = blk.high_priority ? SLOT_HIGH_PRIORITY : 0;
+            return MapSlot<K,V>{blk.key, blk.value, blk.tag};
+        });
+    }
+    template<typename S>
+    void persist_to_storage(S&, long) {}
+
+    // Rejects a block the tree could not hold, before the access moves
+    // anything into the stash.
+    void check_block_fits(const K& key, const V& plaintext) const {
+        if (!slot_accepts(tree, key, plaintext.size() + CryptoEngine::OVERHEAD, 0))
+            throw std::invalid_argument("Block too large for a tree slot");
+    }
+
+    // Value encryption and decryption, timed as the Crypto phase.
+    void seal(const V& plaintext, V& out) {
+        PhaseTimer timer(stats, OramPhase::Crypto);
+        CryptoEngine::local().encrypt_into(plaintext, out);
+    }
+
+    void unseal(const V& ciphertext, V& out) {
+        PhaseTimer timer(stats, OramPhase::Crypto);
+        CryptoEngine::local().decrypt_into(ciphertext, out);
+    }
+
+    // Reads blocks along the path to the given leaf into the stash.
+    void read_path(size_t leaf) {
+        touched.clear();
+        for (int depth = 0; depth <= treeHeight; depth++) {
+            touched.push_back(path_bucket_at_depth(leaf, depth, treeHeight));
+        }
+        read_touched();
+    }
+
+    // Adds the buckets on the path to a leaf that are not yet in `touched`.
+    // Walking up from the leaf, the first bucket already present means the
+    // rest of the path is too. Returns the blocks those buckets hold.
+    size_t touch_path(size_t leaf) {
+        size_t blocks = 0;
+        for (int depth = treeHeight; depth >= 0; depth--) {
+            size_t bucketIndex = path_bucket_at_depth(leaf, depth, treeHeight);
+            if (touchedMark[bucketIndex]) break;
+            touchedMark[bucketIndex] = 1;
+            touched.push_back(bucketIndex);
+            blocks += tree.occupancy(bucketIndex);
+        }
+        return blocks;
+    }
+
+    // Moves every bucket in `touched` into the stash.
+    void drain_touched() {
+        for (size_t bucketIndex : touched) {
+            tree.drain(bucketIndex,
+                [this](size_t blkLeaf, uint8_t flags, MapSlot<K,V>&& slot) {
+                    stash.emplace_back(std::move(slot.key), std::move(slot.value), blkLeaf,
+                                       (flags & SLOT_HIGH_PRIORITY) != 0, slot.tag);
+                    stats.blocksRead++;
+                });
+        }
+        stats.note_stash(stash.size());
+    }
+
+    // Reads every bucket in `touched` into the stash.
+    void read_touched() {
+        PhaseTimer timer(stats, OramPhase::ReadPath);
+        if (!heuristic()) {
+            drain_touched();
+            return;
+        }
+        
         // SUPER aggressive protection - allow path reads to proceed even with high stash usage
         // but ensure we periodically check to prevent complete overflow
         if (stash.size() >= stashLimit * 0.5) {
-            std::cerr << "[EMERGENCY] Stash at " << stash.size() << "/" << stashLimit 
-                      << " before read_path. Performing critical eviction.\n";
+            ORAM_WARN("[EMERGENCY] Stash at " << stash.size() << "/" << stashLimit 
+                   << " before read_path. Performing critical eviction.");
             critical_eviction();
         }
         
         // Count how many blocks we'll be adding from this path
         size_t potential_new_blocks = 0;
-        for (int idx : path) {
-            for (auto& blk : tree[idx].blocks) {
-                if (blk.valid) {
-                    potential_new_blocks++;
-                }
-            }
+        for (size_t bucketIndex : touched) {
+            potential_new_blocks += tree.occupancy(bucketIndex);
         }
         
         // If adding these blocks would exceed the stash limit, we need to take extreme measures
         if (stash.size() + potential_new_blocks > stashLimit * 0.9) {
-            std::cerr << "[CRITICAL] Reading path would add " << potential_new_blocks 
-                      << " blocks to a stash of size " << stash.size() 
-                      << " (limit: " << stashLimit << "). Taking drastic measures.\n";
+            ORAM_WARN("[CRITICAL] Reading path would add " << potential_new_blocks 
+                   << " blocks to a stash of size " << stash.size() 
+                   << " (limit: " << stashLimit << "). Taking drastic measures.");
             
             // Enable dropping of non-essential blocks
             dropNonEssentialBlocks = true;
@@ -138,7 +296,7 @@ private:
             while (stash.size() + potential_new_blocks > stashLimit * 0.7) {
                 if (!emergency_drop_blocks()) {
                     // If we can't drop more blocks, we need to expand our stash
-                    std::cerr << "[EXTREME EMERGENCY] Cannot free enough space. Dynamically expanding stash.\n";
+                    ORAM_WARN("[EXTREME EMERGENCY] Cannot free enough space. Dynamically expanding stash.");
                     stashLimit = static_cast<size_t>(stashLimit * 1.2); // Increase stash limit by 20%
                     break;
                 }
@@ -146,26 +304,19 @@ private:
         }
         
         // Now read the path
-        for (int idx : path) {
-            for (auto& blk : tree[idx].blocks) {
-                if (blk.valid) {
-                    stash.push_back(blk);
-                    blk.valid = false;
-                }
-            }
-        }
+        drain_touched();
         
         // Final safety check
         if (stash.size() > stashLimit) {
-            std::cerr << "[OVERFLOW] Stash size " << stash.size() 
-                      << " exceeds limit " << stashLimit << " after read_path\n";
+            ORAM_WARN("[OVERFLOW] Stash size " << stash.size() 
+                   << " exceeds limit " << stashLimit << " after read_path");
             
             // One last chance - drop enough blocks to get under the limit
             while (stash.size() > stashLimit * 0.9) {
                 if (!emergency_drop_blocks()) {
                     // Expand stash as a last resort
                     stashLimit = static_cast<size_t>(stashLimit * 1.2);
-                    std::cerr << "[EXTREME] Dynamically expanded stash limit to " << stashLimit << "\n";
+                    ORAM_WARN("[EXTREME] Dynamically expanded stash limit to " << stashLimit);
                     break;
                 }
             }
@@ -177,106 +328,119 @@ private:
         }
     }
 
+    // Drops stash[index], keeping its buffers for the next new block.
+    void discard_stash_block(size_t index) {
+        keyPool.release(stash[index].key);
+        valuePool.release(stash[index].value);
+        stash_swap_remove(stash, index);
+    }
+
     // Emergency drop of non-essential blocks to prevent stash overflow
     bool emergency_drop_blocks() {
-        // Sort to prioritize dropping blocks with high eviction counts
-        std::sort(stash.begin(), stash.end(), [](const Block<K,V>& a, const Block<K,V>& b) {
-            // Don't drop high priority blocks
-            if (a.high_priority != b.high_priority)
-                return b.high_priority;
-            
-            // Drop blocks with more eviction attempts first
-            return a.eviction_attempt_count > b.eviction_attempt_count;
-        });
-        
-        // Count blocks we can potentially drop
-        int droppable_count = 0;
-        for (const auto& blk : stash) {
-            if (!blk.high_priority) {
-                droppable_count++;
-            }
+        // Rank blocks with a bitonic sort over packed keys instead of
+        // sorting the blocks: high-priority blocks last, then most
+        // eviction attempts first, then stash index
+        size_t droppable_count = 0;
+        scanScratch.resize(stash.size());
+        for (size_t i = 0; i < stash.size(); i++) {
+            const Block<K,V>& blk = stash[i];
+            uint64_t attempts = std::min<uint64_t>(static_cast<uint64_t>(std::max(blk.eviction_attempt_count, 0)),
+                                                   0x7fffffff);
+            scanScratch[i] = (static_cast<uint64_t>(blk.high_priority) << 63) |
+                             ((0x7fffffff - attempts) << 32) | static_cast<uint64_t>(i);
+            droppable_count += !blk.high_priority;
         }
         
         if (droppable_count == 0) {
-            std::cerr << "[CRITICAL] No non-essential blocks to drop!\n";
+            ORAM_WARN("[CRITICAL] No non-essential blocks to drop!");
             return false;
         }
+        bitonic_sort_u64(scanScratch);
         
-        // Drop 20% of non-essential blocks
-        size_t to_drop = std::max(1, static_cast<int>(droppable_count * 0.2));
-        size_t dropped = 0;
+        // Drop 20% of non-essential blocks: the front of the ranking. Their
+        // stash indices are discarded highest first, so swap-and-pop never
+        // moves a block that is still to be dropped.
+        size_t to_drop = std::max<size_t>(1, static_cast<size_t>(droppable_count * 0.2));
+        std::vector<size_t> victims;
+        victims.reserve(to_drop);
+        for (size_t r = 0; r < to_drop; r++) {
+            victims.push_back(static_cast<size_t>(scanScratch[r] & 0xffffffff));
+        }
+        std::sort(victims.begin(), victims.end(), std::greater<size_t>());
         
-        auto it = stash.begin();
-        while (it != stash.end() && dropped < to_drop) {
-            if (!it->high_priority) {
-                // For dropped blocks, re-add their key to posMap with a new random leaf
-                if (it->valid) {
-                    posMap[it->key] = secure_random_index(1 << treeHeight);
-                }
-                
-                it = stash.erase(it);
-                dropped++;
-            } else {
-                ++it;
+        size_t dropped = 0;
+        for (size_t index : victims) {
+            // A dropped block is gone; forget its position
+            if (stash[index].valid) {
+                posMap.erase(stash[index].key);
             }
+            discard_stash_block(index);
+            dropped++;
         }
         
-        std::cerr << "[EMERGENCY] Dropped " << dropped << " non-essential blocks from stash\n";
+        stats.emergencyDrops += dropped;
+        ORAM_WARN("[EMERGENCY] Dropped " << dropped << " non-essential blocks from stash");
         return dropped > 0;
     }
 
-    // Eviction routine for blocks along a specific path.
-    void write_path(const std::vector<int>& path) {
+    bool heuristic() const { return evictionMode == EvictionMode::Heuristic; }
+
+    // Hands the structure to the shared scheduler once the stash crosses the
+    // watermark, replacing the old per-structure polling thread.
+    void request_background_eviction() {
+        if (heuristic() && stash.size() > stashLimit * EVICTION_HIGH_WATERMARK) {
+            scheduler.submit(this);
+        }
+    }
+
+    // Bounded mode: reads the next path in reverse-lexicographic order and
+    // writes it back with as many stash blocks as fit.
+    void evict_next_path() {
+        size_t leaf = reverse_lex_leaf(evictionCounter++, treeHeight);
+        read_path(leaf);
+        evictor.evict_path(stash, leaf, treeHeight,
+            [this](size_t bucketIndex, Block<K,V>& blk) { return place_block(bucketIndex, blk); });
+    }
+
+    // The access has already changed the stash and position map, so a stash
+    // over its bound is worked off with extra deterministic evictions rather
+    // than reported as a failure. Whatever BOUNDED_OVERFLOW_EVICTIONS leave
+    // over carries to the next access.
+    void settle_stash_bound() {
+        for (int i = 0; i < BOUNDED_OVERFLOW_EVICTIONS && stash.size() > stashLimit; i++) {
+            evict_next_path();
+        }
+    }
+
+    // Eviction routine for blocks along the path to a specific leaf.
+    void write_path(size_t leaf) {
+        PhaseTimer timer(stats, OramPhase::WritePath);
+        if (!heuristic()) {
+            evictor.evict_path(stash, leaf, treeHeight,
+                [this](size_t bucketIndex, Block<K,V>& blk) { return place_block(bucketIndex, blk); });
+            evict_next_path();
+            settle_stash_bound();
+            return;
+        }
+        
         size_t maxAttempts = 5; // Increased from 3 to 5
         size_t attempt = 0;
         
         while (stash.size() > stashLimit * 0.3 && attempt < maxAttempts) {
             size_t prevSize = stash.size();
-            size_t evictedCount = 0;
             
-            // Sort stash blocks by leaf depth and eviction attempts to prioritize eviction
-            std::sort(stash.begin(), stash.end(), [this](const Block<K,V>& a, const Block<K,V>& b) {
-                // Prioritize high-priority blocks
-                if (a.high_priority != b.high_priority)
-                    return a.high_priority;
-                
-                // Prioritize blocks that have been attempted less
-                if (a.eviction_attempt_count != b.eviction_attempt_count)
-                    return a.eviction_attempt_count < b.eviction_attempt_count;
-                
-                // Secondary sort by leaf depth (path length to root)
-                std::vector<int> pathA = get_path_indices(a.leaf);
-                std::vector<int> pathB = get_path_indices(b.leaf);
-                return pathA.size() < pathB.size();
-            });
+            // Greedily place blocks on the path, deepest legal bucket first
+            size_t evictedCount = evictor.evict_path(stash, leaf, treeHeight,
+                [this](size_t bucketIndex, Block<K,V>& blk) { return place_block(bucketIndex, blk); });
             
-            // Increment attempt counter for all blocks
+            // Count the round against every block that is still stuck
             for (auto& blk : stash) {
                 blk.eviction_attempt_count++;
             }
             
-            // Try to place blocks in buckets
-            for (int bucketIndex : path) {
-                Bucket<K, V>& bucket = tree[bucketIndex];
-                for (auto &slot : bucket.blocks) {
-                    if (!slot.valid) {
-                        auto it = std::find_if(stash.begin(), stash.end(), [&](const Block<K,V>& blk) {
-                            std::vector<int> blkPath = get_path_indices(blk.leaf);
-                            return std::find(blkPath.begin(), blkPath.end(), bucketIndex) != blkPath.end();
-                        });
-                        if (it != stash.end()) {
-                            slot = *it;
-                            slot.eviction_attempt_count = 0; // Reset counter once evicted
-                            stash.erase(it);
-                            evictedCount++;
-                        }
-                    }
-                }
-            }
-            
-            std::cerr << "[Eviction] write_path round " << attempt+1 << ": prev stash size = " << prevSize 
-                      << ", evicted = " << evictedCount 
-                      << ", new stash size = " << stash.size() << "\n";
+            ORAM_DEBUG("[Eviction] write_path round " << attempt+1 << ": prev stash size = " << prevSize 
+                    << ", evicted = " << evictedCount 
+                    << ", new stash size = " << stash.size());
                       
             if (evictedCount == 0) {
                 // If we couldn't evict anything, remap some blocks
@@ -286,12 +450,12 @@ private:
             if (stash.size() >= prevSize && attempt > 1) {
                 // If we've made no progress after multiple attempts, maybe try dropping blocks
                 if (dropNonEssentialBlocks) {
-                    std::cerr << "[Eviction] write_path: no progress after " << attempt 
-                              << " attempts. Trying emergency drop.\n";
+                    ORAM_DEBUG("[Eviction] write_path: no progress after " << attempt 
+                            << " attempts. Trying emergency drop.");
                     emergency_drop_blocks();
                 } else {
-                    std::cerr << "[Eviction] write_path: no progress after " << attempt 
-                              << " attempts, breaking loop\n";
+                    ORAM_DEBUG("[Eviction] write_path: no progress after " << attempt 
+                            << " attempts, breaking loop");
                     break;
                 }
             }
@@ -303,6 +467,64 @@ private:
         if (stash.size() > stashLimit * 0.7) {
             critical_eviction();
         }
+        
+        request_background_eviction();
+    }
+    
+    // Eviction routine for a multi-path access: each stash block goes to the
+    // deepest touched bucket on its own path, so every touched bucket is
+    // written back once no matter how many paths share it.
+    // `accesses` is the number of requests served, which sets how many
+    // deterministic evictions follow in Bounded mode.
+    void write_touched(size_t accesses) {
+        PhaseTimer timer(stats, OramPhase::WritePath);
+        auto placeTouched = [this](size_t bucketIndex, Block<K,V>& blk) {
+            return touchedMark[bucketIndex] && place_block(bucketIndex, blk);
+        };
+        
+        if (!heuristic()) {
+            evictor.evict_tree(stash, treeHeight, placeTouched);
+            for (size_t bucketIndex : touched) {
+                touchedMark[bucketIndex] = 0;
+            }
+            touched.clear();
+            for (size_t i = 0; i < accesses; i++) {
+                evict_next_path();
+            }
+            settle_stash_bound();
+            return;
+        }
+        
+        size_t maxAttempts = 5;
+        size_t attempt = 0;
+        
+        while (stash.size() > stashLimit * 0.3 && attempt < maxAttempts) {
+            size_t prevSize = stash.size();
+            size_t evictedCount = evictor.evict_tree(stash, treeHeight, placeTouched);
+            
+            for (auto& blk : stash) {
+                blk.eviction_attempt_count++;
+            }
+            
+            if (evictedCount == 0) {
+                remap_stuck_blocks();
+            }
+            if (stash.size() >= prevSize && attempt > 1) {
+                break;
+            }
+            attempt++;
+        }
+        
+        for (size_t bucketIndex : touched) {
+            touchedMark[bucketIndex] = 0;
+        }
+        touched.clear();
+        
+        if (stash.size() > stashLimit * 0.7) {
+            critical_eviction();
+        }
+        
+        request_background_eviction();
     }
     
     // Remap blocks that appear stuck in the stash
@@ -310,24 +532,22 @@ private:
         // Only remap blocks that have been attempted multiple times
         size_t remapped = 0;
         for (auto &blk : stash) {
-            if (blk.eviction_attempt_count > 2) {
-                blk.leaf = secure_random_index(1 << treeHeight);
-                blk.eviction_attempt_count = 0; // Reset counter
+            if (blk.eviction_attempt_count > 2 && remap_stash_block(blk)) {
                 remapped++;
             }
         }
-        std::cerr << "[Eviction] Remapped " << remapped << " stuck blocks\n";
+        ORAM_DEBUG("[Eviction] Remapped " << remapped << " stuck blocks");
     }
     
     // Critical eviction for when stash is nearing capacity - more extreme than emergency
     void critical_eviction() {
-        std::cerr << "[Eviction] CRITICAL EVICTION: stash size = " << stash.size() 
-                  << "/" << stashLimit << "\n";
+        PhaseTimer timer(stats, OramPhase::CriticalEviction);
+        ORAM_WARN("[Eviction] CRITICAL EVICTION: stash size = " << stash.size() 
+               << "/" << stashLimit);
         
         // Remap ALL blocks in the stash with fresh random leaves
         for (auto &blk : stash) {
-            blk.leaf = secure_random_index(1 << treeHeight);
-            blk.eviction_attempt_count = 0;
+            remap_stash_block(blk);
         }
         
         // Aggressive full tree sweep
@@ -335,69 +555,45 @@ private:
         
         // If still too full, try dropping non-essential blocks
         if (stash.size() > stashLimit * 0.8) {
-            std::cerr << "[Eviction] Critical eviction didn't free enough space. "
-                      << "Enabling emergency block dropping.\n";
+            ORAM_WARN("[Eviction] Critical eviction didn't free enough space. "
+                   << "Enabling emergency block dropping.");
             dropNonEssentialBlocks = true;
             emergency_drop_blocks();
         }
     }
     
     // Full eviction scans the entire tree and evicts eligible blocks.
-    void full_eviction(bool emergency = false) {
-        size_t maxRounds = emergency ? 8 : 5;  // Increased rounds
+    // roundLimit caps the rounds (0 keeps the default for the mode).
+    void full_eviction(bool emergency = false, size_t roundLimit = 0) {
+        PhaseTimer timer(stats, OramPhase::FullEviction);
+        size_t maxRounds = roundLimit ? roundLimit : (emergency ? 8 : 5);  // Increased rounds
         size_t round = 0;
         
         while ((stash.size() > stashLimit * (emergency ? 0.3 : 0.5)) && round < maxRounds) {
             size_t prevSize = stash.size();
-            size_t evictedCount = 0;
-            
-            // Sort stash to prioritize eviction of less-attempted blocks
-            std::sort(stash.begin(), stash.end(), [](const Block<K,V>& a, const Block<K,V>& b) {
-                // Prioritize high-priority blocks
-                if (a.high_priority != b.high_priority)
-                    return a.high_priority;
-                
-                return a.eviction_attempt_count < b.eviction_attempt_count;
-            });
             
-            // Try to place blocks in buckets across the entire tree
-            for (int idx = 1; idx <= numBuckets; idx++) {
-                Bucket<K, V>& bucket = tree[idx];
-                for (auto &slot : bucket.blocks) {
-                    if (!slot.valid && !stash.empty()) {
-                        auto it = std::find_if(stash.begin(), stash.end(), [&](const Block<K,V>& blk) {
-                            std::vector<int> blkPath = get_path_indices(blk.leaf);
-                            return std::find(blkPath.begin(), blkPath.end(), idx) != blkPath.end();
-                        });
-                        if (it != stash.end()) {
-                            slot = *it;
-                            slot.eviction_attempt_count = 0; // Reset counter once evicted
-                            stash.erase(it);
-                            evictedCount++;
-                        }
-                    }
-                }
-            }
+            // Place every block in the deepest bucket on its own path with room
+            size_t evictedCount = evictor.evict_tree(stash, treeHeight,
+                [this](size_t bucketIndex, Block<K,V>& blk) { return place_block(bucketIndex, blk); });
             
-            std::cerr << "[Eviction] full_eviction round " << round+1 << ": prev stash size = " << prevSize 
-                      << ", evicted = " << evictedCount 
-                      << ", new stash size = " << stash.size() << "\n";
+            ORAM_DEBUG("[Eviction] full_eviction round " << round+1 << ": prev stash size = " << prevSize 
+                    << ", evicted = " << evictedCount 
+                    << ", new stash size = " << stash.size());
                       
             if (evictedCount == 0 || stash.size() >= prevSize) {
-                std::cerr << "[Eviction] full_eviction: minimal progress, remapping all blocks\n";
+                ORAM_DEBUG("[Eviction] full_eviction: minimal progress, remapping all blocks");
                 
                 // Remap each block's leaf value in the stash
                 for (auto &blk : stash) {
-                    blk.leaf = secure_random_index(1 << treeHeight);
-                    blk.eviction_attempt_count = 0;
+                    remap_stash_block(blk);
                 }
                 
                 // If still no progress after remapping in emergency mode, try more extreme measures
                 if (emergency && round > 3 && stash.size() >= prevSize) {
                     // In extreme cases, we might need to drop some blocks
                     if (stash.size() > stashLimit * 0.8) {
-                        std::cerr << "[Eviction] WARNING: Critical stash overflow imminent. "
-                                  << "Taking extreme measures.\n";
+                        ORAM_WARN("[Eviction] WARNING: Critical stash overflow imminent. "
+                               << "Taking extreme measures.");
                         
                         // Enable dropping of non-essential blocks
                         dropNonEssentialBlocks = true;
@@ -410,150 +606,782 @@ private:
         }
     }
 
-    // Remaps a key in the position map.
-    size_t remap_key(const K& key) {
-        size_t newLeaf = secure_random_index(1 << treeHeight);
-        posMap[key] = newLeaf;
-        return newLeaf;
+    // Gives a stash block a fresh leaf and records it in the position map.
+    // Position maps that share entries keep every block of an entry on one
+    // leaf; moving one block without reading that path would strand its
+    // entry-mates, so under those policies stuck blocks simply wait.
+    bool remap_stash_block(Block<K,V>& blk) {
+        if (PosMap::shares_entries) return false;
+        blk.leaf = secure_random_index(1 << treeHeight);
+        blk.eviction_attempt_count = 0;
+        posMap.assign(blk.key, blk.leaf);
+        return true;
+    }
+
+    static constexpr size_t NO_BLOCK = static_cast<size_t>(-1);
+
+    // State carried from begin_access to end_access.
+    struct AccessContext {
+        size_t pathLeaf;  // path that was read and will be written back
+        size_t newLeaf;   // leaf the key's entry now points at
+        bool mapped;      // entry existed before this access
+        size_t target;    // stash index of the key's block, or NO_BLOCK
+        uint64_t tag;     // block_tag(key)
+    };
+
+    // Remaps the key's entry and chooses the path to read. Keys that are not
+    // mapped read an unrelated random path, so a miss is indistinguishable
+    // from a hit.
+    AccessContext prepare_access(const K& key) {
+        AccessContext ctx;
+        ctx.newLeaf = secure_random_index(1 << treeHeight);
+        ctx.mapped = posMap.remap(key, ctx.newLeaf, ctx.pathLeaf);
+        if (!ctx.mapped) {
+            ctx.pathLeaf = secure_random_index(1 << treeHeight);
+        }
+        ctx.target = NO_BLOCK;
+        ctx.tag = block_tag(key);
+        return ctx;
+    }
+
+    // Stash index of the key's block, or NO_BLOCK. One branch-free scan of
+    // every stash tag (invalid blocks never match); the key is compared
+    // only at the index it returns, and a tag collision falls back to
+    // comparing every candidate.
+    size_t find_in_stash(const K& key, uint64_t tag) {
+        size_t n = stash.size();
+        scanScratch.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            scanScratch[i] = ct_select_u64(stash[i].valid, stash[i].tag, ~tag);
+        }
+        size_t hit = ct_find_u64(scanScratch.data(), n, tag);
+        if (hit == n) return NO_BLOCK;
+        if (stash[hit].key == key) return hit;
+        for (size_t i = 0; i < n; i++) {
+            if (scanScratch[i] == tag && stash[i].key == key) return i;
+        }
+        return NO_BLOCK;
+    }
+
+    // Locates the key's block in the stash once its path has been read and
+    // moves it (and any entry-mates) to the new leaf.
+    void resolve_access(const K& key, AccessContext& ctx) {
+        if (!ctx.mapped) return;
+        ctx.target = find_in_stash(key, ctx.tag);
+        if (ctx.target != NO_BLOCK) {
+            stash[ctx.target].leaf = ctx.newLeaf;
+            stash[ctx.target].eviction_attempt_count = 0; // Reset counter on access
+        }
+        if (PosMap::shares_entries) {
+            // Entry-mates follow the entry to its new leaf
+            for (auto& blk : stash) {
+                if (blk.valid && posMap.same_entry(blk.key, key)) blk.leaf = ctx.newLeaf;
+            }
+        }
+    }
+
+    // First half of a PathORAM access: remaps the key, reads the old path
+    // into the stash and locates the key's block there.
+    AccessContext begin_access(const K& key) {
+        AccessContext ctx = prepare_access(key);
+        read_path(ctx.pathLeaf);
+        resolve_access(key, ctx);
+        return ctx;
+    }
+
+    // Mark FIB/PIT entries as higher priority
+    static bool is_high_priority(const K& key) {
+        if constexpr (std::is_same<K, std::string>::value) {
+            return key.find("/") == 0; // Routing entries are high priority
+        } else {
+            return true;               // hashed keys only ever hold NDN names
+        }
+    }
+
+    // Adds the key's block to the stash when begin_access found none.
+    Block<K,V>& create_block(const K& key, AccessContext& ctx) {
+        posMap.assign(key, ctx.newLeaf);
+        if (PosMap::shares_entries) {
+            // The entry may have moved since this key was resolved (another
+            // key of the same entry in one batch); every block of the entry
+            // is in the stash at this point, so bring them all along.
+            for (auto& blk : stash) {
+                if (blk.valid && posMap.same_entry(blk.key, key)) blk.leaf = ctx.newLeaf;
+            }
+        }
+        
+        // Recycled buffers keep their capacity, so this normally does not allocate
+        K blockKey = keyPool.acquire();
+        blockKey = key;
+        stash.emplace_back(std::move(blockKey), valuePool.acquire(), ctx.newLeaf, is_high_priority(key), ctx.tag);
+        ctx.target = stash.size() - 1;
+        return stash.back();
+    }
+
+    // Second half of a PathORAM access: writes the read path back.
+    void end_access(const AccessContext& ctx) {
+        write_path(ctx.pathLeaf);
+    }
+
+    // Runs a batch of accesses in rounds. Each round remaps its keys, reads
+    // the union of their paths once, resolves every key against the stash,
+    // calls apply(i, ctx) for each request in order and writes the merged
+    // path set back once. A round closes when the blocks it has read reach
+    // half the stash limit, so a large burst cannot flood the stash.
+    // Repeated keys within a round share one context and read an extra
+    // random path, keeping the number of paths equal to the batch size.
+    template<typename KeyAt, typename Apply>
+    void access_batch(size_t count, KeyAt&& keyAt, Apply&& apply) {
+        if (touchedMark.size() != tree.bucket_count() + 1) {
+            touchedMark.assign(tree.bucket_count() + 1, 0);
+        }
+        
+        std::vector<AccessContext> ctxs;
+        std::vector<size_t> slot;
+        std::unordered_map<K, size_t> seen;
+        size_t budget = stashLimit / 2;
+        
+        size_t begin = 0;
+        while (begin < count) {
+            touched.clear();
+            ctxs.clear();
+            slot.clear();
+            seen.clear();
+            
+            size_t pending = stash.size();
+            size_t end = begin;
+            while (end < count) {
+                const K& key = keyAt(end);
+                auto it = seen.find(key);
+                if (it == seen.end()) {
+                    seen.emplace(key, ctxs.size());
+                    slot.push_back(ctxs.size());
+                    ctxs.push_back(prepare_access(key));
+                    pending += touch_path(ctxs.back().pathLeaf);
+                } else {
+                    slot.push_back(it->second);
+                    pending += touch_path(secure_random_index(1 << treeHeight));
+                }
+                end++;
+                if (pending > budget) break;
+            }
+            
+            read_touched();
+            
+            // Contexts were created in order of first occurrence
+            size_t next = 0;
+            for (size_t i = begin; i < end; i++) {
+                if (slot[i - begin] == next) {
+                    resolve_access(keyAt(i), ctxs[next]);
+                    next++;
+                }
+            }
+            for (size_t i = begin; i < end; i++) {
+                apply(i, ctxs[slot[i - begin]]);
+            }
+            
+            write_touched(end - begin);
+            begin = end;
+        }
     }
 
 public:
     // Constructor with improved default parameters
     ObliviousMap(int height = TREE_HEIGHT_DEFAULT, 
                  size_t stash_limit = STASH_LIMIT_DEFAULT,
-                 int bucket_capacity = BUCKET_CAPACITY_DEFAULT)
-      : treeHeight(height), stashLimit(stash_limit), bucketCapacity(bucket_capacity),
-        evictionFailCount(0), dropNonEssentialBlocks(false)
+                 int bucket_capacity = BUCKET_CAPACITY_DEFAULT,
+                 EvictionMode mode = EvictionMode::Heuristic)
+      : tree(height, bucket_capacity), treeHeight(height), stashLimit(stash_limit),
+        bucketCapacity(bucket_capacity), posMap(height, bucket_capacity),
+        evictionFailCount(0), dropNonEssentialBlocks(false),
+        evictionMode(mode), evictionCounter(0), scheduler(EvictionScheduler::shared()),
+        keyPool(stash_limit), valuePool(stash_limit)
     {
         numBuckets = compute_numBuckets(treeHeight);
-        tree.clear();
         
-        // Create a dummy bucket at index 0 (we're 1-indexed)
-        tree.emplace_back(Bucket<K,V>());
-        
-        // Create the actual buckets
-        for (int i = 1; i <= numBuckets; i++) {
-            tree.emplace_back(Bucket<K,V>(bucketCapacity));
-        }
-        
-        // Start background eviction thread with more frequent checks
-        evictionThreadRunning = true;
-        evictionThread = std::thread([this]() {
-            while (evictionThreadRunning) {
-                {
-                    std::lock_guard<std::mutex> lock(mtx);
-                    if (stash.size() > stashLimit * 0.5) {
-                        full_eviction();
-                    }
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(5)); // Reduced from 10ms to 5ms
-            }
-        });
+        // Room for a full stash plus one path read, so steady-state accesses
+        // never grow the vector
+        stash.reserve(stash_limit + static_cast<size_t>(height + 1) * bucket_capacity);
     }
 
-    // Destructor: stops the background eviction thread.
+    // Builds the map over caller-constructed storage; height and bucket
+    // capacity are taken from it. A reopened MappedTree brings its blocks,
+    // stash and eviction epoch back (see restore_from_storage).
+    ObliviousMap(Storage&& storage, size_t stash_limit = STASH_LIMIT_DEFAULT,
+                 EvictionMode mode = EvictionMode::Heuristic)
+      : tree(std::move(storage)), treeHeight(tree.tree_height()), stashLimit(stash_limit),
+        bucketCapacity(tree.bucket_capacity()), posMap(treeHeight, bucketCapacity),
+        evictionFailCount(0), dropNonEssentialBlocks(false),
+        evictionMode(mode), evictionCounter(0), scheduler(EvictionScheduler::shared()),
+        keyPool(stash_limit), valuePool(stash_limit)
+    {
+        numBuckets = compute_numBuckets(treeHeight);
+        stash.reserve(stash_limit + static_cast<size_t>(treeHeight + 1) * bucketCapacity);
+        restore_from_storage(tree, 0);
+    }
+
+    // Builds the map pre-loaded with `entries` (see bulk_load).
+    ObliviousMap(const std::vector<std::pair<K,V>>& entries, int height,
+                 size_t stash_limit = STASH_LIMIT_DEFAULT,
+                 int bucket_capacity = BUCKET_CAPACITY_DEFAULT,
+                 EvictionMode mode = EvictionMode::Heuristic)
+      : ObliviousMap(height, stash_limit, bucket_capacity, mode)
+    {
+        bulk_load(entries);
+    }
+
+    // Destructor: waits out any eviction slice still running on this
+    // structure, then lets persistent storage keep the stash and epoch.
     ~ObliviousMap() {
-        evictionThreadRunning = false;
-        if (evictionThread.joinable()) {
-            evictionThread.join();
+        scheduler.retire(this);
+        try {
+            persist_to_storage(tree, 0);
+        } catch (const std::exception& e) {
+            ORAM_ERROR("[Storage] Closing the tree failed: " << e.what());
         }
     }
 
+    // Background eviction slice, run by the scheduler without our lock held:
+    // at most one full-eviction round. Returns true while the stash is still
+    // above the watermark and the round made progress.
+    bool eviction_slice() override {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!heuristic() || stash.size() <= stashLimit * EVICTION_HIGH_WATERMARK) return false;
+        size_t before = stash.size();
+        full_eviction(/*emergency=*/false, /*roundLimit=*/1);
+        return stash.size() < before && stash.size() > stashLimit * EVICTION_HIGH_WATERMARK;
+    }
+
+    // True while the stash is above the background-eviction watermark.
+    // Callers can use this as back-pressure and hold off new work.
+    bool isUnderPressure() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stash.size() > stashLimit * EVICTION_HIGH_WATERMARK;
+    }
+
+    // In Bounded mode this runs deterministic evictions until the stash is
+    // empty or every leaf has been visited once.
     void trigger_full_eviction() {
         std::lock_guard<std::mutex> lock(mtx);
+        if (!heuristic()) {
+            for (size_t i = 0; i < (static_cast<size_t>(1) << treeHeight) && !stash.empty(); i++) {
+                evict_next_path();
+            }
+            return;
+        }
         full_eviction(/*emergency=*/true);
     }
 
     // Inserts a key-value pair.
     void oblivious_insert(const K& key, const V& value) {
-        std::lock_guard<std::mutex> lock(mtx);
+        check_block_fits(key, value);
+        TimedLock lock(mtx, stats);
         
         // Check stash size before operation
-        if (stash.size() > stashLimit * 0.6) {
-            std::cerr << "[NDNRouter] WARNING: High stash utilization before insert: " 
-                      << stash.size() << "/" << stashLimit << "\n";
+        if (heuristic() && stash.size() > stashLimit * 0.6) {
+            ORAM_DEBUG("[NDNRouter] High stash utilization before insert: " 
+                   << stash.size() << "/" << stashLimit);
             full_eviction();
         }
         
-        size_t leaf = remap_key(key);
-        std::vector<int> path = get_path_indices(leaf);
-        read_path(path);
-        
-        // Mark FIB/PIT entries as higher priority
-        bool is_high_priority = (key.find("/") == 0); // Routing entries are high priority
+        // Existing keys are updated in place, so re-inserting a key never
+        // leaves a stale copy behind in the tree
+        AccessContext ctx = begin_access(key);
+        Block<K,V>& blk = (ctx.target != NO_BLOCK) ? stash[ctx.target] : create_block(key, ctx);
         
-        // Insert the new block
-        stash.push_back(Block<K, V>(key, secure_encrypt_string(value), leaf, is_high_priority));
+        // Encrypt straight into the block's value buffer
+        seal(value, blk.value);
         
         // Immediately try to evict blocks
-        write_path(path);
+        end_access(ctx);
         
         // Check stash size after operation
-        if (stash.size() > stashLimit * 0.6) {
+        if (heuristic() && stash.size() > stashLimit * 0.6) {
             full_eviction();
         }
-        
-        if (stash.size() > stashLimit) {
-            throw std::runtime_error("Stash overflow after insertion");
-        }
     }
 
     // Looks up a key.
     bool oblivious_lookup(const K& key, V& value) {
-        std::lock_guard<std::mutex> lock(mtx);
+        TimedLock lock(mtx, stats);
         
         // Check stash size before operation
-        if (stash.size() > stashLimit * 0.6) {
-            std::cerr << "[NDNRouter] WARNING: High stash utilization before lookup: " 
-                      << stash.size() << "/" << stashLimit << "\n";
+        if (heuristic() && stash.size() > stashLimit * 0.6) {
+            ORAM_DEBUG("[NDNRouter] High stash utilization before lookup: " 
+                   << stash.size() << "/" << stashLimit);
             full_eviction();
         }
         
-        if (posMap.find(key) == posMap.end()) return false;
-        
-        size_t leaf = posMap[key];
-        std::vector<int> path = get_path_indices(leaf);
-        read_path(path);
+        AccessContext ctx = begin_access(key);
         
-        bool found = false;
-        for (auto& blk : stash) {
-            if (blk.valid && blk.key == key) {
-                value = secure_decrypt_string(blk.value);
-                blk.leaf = remap_key(key);
-                blk.eviction_attempt_count = 0; // Reset counter on access
-                found = true;
-                break;
-            }
+        bool found = (ctx.target != NO_BLOCK);
+        if (found) {
+            unseal(stash[ctx.target].value, value);
         }
         
         // Evict blocks back to the tree
-        write_path(path);
+        end_access(ctx);
         
         // Check stash size after operation
-        if (stash.size() > stashLimit * 0.6) {
+        if (heuristic() && stash.size() > stashLimit * 0.6) {
             full_eviction();
         }
         
         return found;
     }
     
+    // Inserts several key-value pairs with one read and one write-back of
+    // the merged path set per round (see access_batch). Later pairs win
+    // when a key repeats.
+    void oblivious_insert_batch(const std::vector<std::pair<K,V>>& items) {
+        for (const auto& item : items) check_block_fits(item.first, item.second);
+        TimedLock lock(mtx, stats);
+        
+        if (heuristic() && stash.size() > stashLimit * 0.6) {
+            full_eviction();
+        }
+        
+        access_batch(items.size(),
+            [&items](size_t i) -> const K& { return items[i].first; },
+            [this, &items](size_t i, AccessContext& ctx) {
+                Block<K,V>& blk = (ctx.target != NO_BLOCK) ? stash[ctx.target]
+                                                           : create_block(items[i].first, ctx);
+                seal(items[i].second, blk.value);
+            });
+        
+        if (heuristic() && stash.size() > stashLimit * 0.6) {
+            full_eviction();
+        }
+    }
+
+    // Looks up several keys with one read and one write-back of the merged
+    // path set per round. values[i] and found[i] describe keys[i].
+    // Returns the number of keys found.
+    size_t oblivious_lookup_batch(const std::vector<K>& keys, std::vector<V>& values,
+                                  std::vector<bool>& found) {
+        TimedLock lock(mtx, stats);
+        
+        if (heuristic() && stash.size() > stashLimit * 0.6) {
+            full_eviction();
+        }
+        
+        values.assign(keys.size(), V());
+        found.assign(keys.size(), false);
+        size_t hits = 0;
+        
+        access_batch(keys.size(),
+            [&keys](size_t i) -> const K& { return keys[i]; },
+            [&](size_t i, AccessContext& ctx) {
+                if (ctx.target == NO_BLOCK) return;
+                unseal(stash[ctx.target].value, values[i]);
+                found[i] = true;
+                hits++;
+            });
+        
+        if (heuristic() && stash.size() > stashLimit * 0.6) {
+            full_eviction();
+        }
+        
+        return hits;
+    }
+    
+    // Removes a key in one access: the path is read, the block is dropped
+    // from the stash, the position-map entry is freed and the path is written
+    // back as usual. Absent keys cost the same random-path access. When
+    // `value` is given it receives the removed plaintext.
+    bool oblivious_remove(const K& key, V* value = nullptr) {
+        TimedLock lock(mtx, stats);
+        
+        AccessContext ctx = begin_access(key);
+        
+        bool found = (ctx.target != NO_BLOCK);
+        if (found) {
+            if (value) {
+                unseal(stash[ctx.target].value, *value);
+            }
+            discard_stash_block(ctx.target);
+            posMap.erase(key);
+        }
+        
+        end_access(ctx);
+        
+        return found;
+    }
+
+    // Bulk expiry: decrypts every entry in the tree and the stash once and
+    // deletes those for which expired(key, plaintext) returns true. Buckets
+    // are drained and refilled one at a time in index order, so the sweep
+    // touches the same storage whichever entries expire, and survivors stay
+    // in the bucket they came from. Returns the number of entries removed.
+    template<typename Pred>
+    size_t expire_entries(Pred&& expired) {
+        TimedLock lock(mtx, stats);
+        
+        struct Survivor {
+            size_t leaf;
+            uint8_t flags;
+            MapSlot<K,V> slot;
+        };
+        std::vector<Survivor> survivors;
+        V plaintext;
+        size_t removed = 0;
+        
+        for (size_t bucketIndex = 1; bucketIndex <= tree.bucket_count(); bucketIndex++) {
+            survivors.clear();
+            tree.drain(bucketIndex, [&](size_t blkLeaf, uint8_t flags, MapSlot<K,V>&& slot) {
+                unseal(slot.value, plaintext);
+                if (expired(slot.key, static_cast<const V&>(plaintext))) {
+                    posMap.erase(slot.key);
+                    keyPool.release(slot.key);
+                    valuePool.release(slot.value);
+                    removed++;
+                } else {
+                    survivors.push_back(Survivor{blkLeaf, flags, std::move(slot)});
+                }
+            });
+            for (auto& survivor : survivors) {
+                tree.store(bucketIndex, survivor.leaf, survivor.flags, std::move(survivor.slot));
+            }
+        }
+        
+        size_t out = 0;
+        for (size_t i = 0; i < stash.size(); i++) {
+            Block<K,V>& blk = stash[i];
+            if (blk.valid) {
+                unseal(blk.value, plaintext);
+                if (expired(blk.key, static_cast<const V&>(plaintext))) {
+                    posMap.erase(blk.key);
+                    keyPool.release(blk.key);
+                    valuePool.release(blk.value);
+                    removed++;
+                    continue;
+                }
+            }
+            if (out != i) stash[out] = std::move(blk);
+            out++;
+        }
+        stash.resize(out);
+        
+        return removed;
+    }
+
+    // Fills an empty map in one linear pass, for cold starts with a known
+    // table: each entry gets a random leaf and goes straight to the deepest
+    // bucket on its path with room, or to the stash if the whole path is
+    // full. There are no path reads and no evictions. Entries must be sorted
+    // by key without repeats.
+    void bulk_load(const std::vector<std::pair<K,V>>& entries) {
+        std::lock_guard<std::mutex> lock(mtx);
+        
+        if (tree.size() != 0 || !stash.empty())
+            throw std::runtime_error("bulk_load needs an empty map");
+        for (size_t i = 1; i < entries.size(); i++) {
+            if (!(entries[i - 1].first < entries[i].first))
+                throw std::invalid_argument("bulk_load entries must be sorted by key without repeats");
+        }
+        
+        for (const auto& entry : entries) {
+            size_t leaf = secure_random_index(1 << treeHeight);
+            size_t entryLeaf;
+            if (PosMap::shares_entries && posMap.remap(entry.first, leaf, entryLeaf)) {
+                // An entry-mate is already placed; join it on its leaf
+                posMap.remap(entry.first, entryLeaf, leaf);
+                leaf = entryLeaf;
+            } else {
+                posMap.assign(entry.first, leaf);
+            }
+            
+            K key = keyPool.acquire();
+            key = entry.first;
+            Block<K,V> blk(std::move(key), valuePool.acquire(), leaf, is_high_priority(entry.first));
+            seal(entry.second, blk.value);
+            
+            bool placed = false;
+            for (int depth = treeHeight; depth >= 0 && !placed; depth--) {
+                placed = place_block(path_bucket_at_depth(leaf, depth, treeHeight), blk);
+            }
+            if (!placed) stash.push_back(std::move(blk));
+        }
+        
+        if (stash.size() > stashLimit) {
+            throw std::runtime_error("Stash overflow in bulk_load: too many entries for this tree");
+        }
+    }
+
+    // Writes the tree, stash and eviction state to `out` (see
+    // oram-snapshot.hpp): one header record, one record per non-empty
+    // bucket and one for the stash. The position map is not written; every
+    // block carries its leaf, so load_snapshot rebuilds it.
+    void save_snapshot(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(mtx);
+        
+        SnapshotWriter w(out);
+        size_t used = 0;
+        for (size_t bucketIndex = 1; bucketIndex <= tree.bucket_count(); bucketIndex++) {
+            if (tree.occupancy(bucketIndex) > 0) used++;
+        }
+        w.u32(SNAPSHOT_KIND_PATH);
+        w.u32(static_cast<uint32_t>(treeHeight));
+        w.u32(static_cast<uint32_t>(bucketCapacity));
+        w.u64(evictionCounter);
+        w.u64(used);
+        w.end_record();
+        
+        for (size_t bucketIndex = 1; bucketIndex <= tree.bucket_count(); bucketIndex++) {
+            int occupancy = tree.occupancy(bucketIndex);
+            if (occupancy == 0) continue;
+            w.u32(static_cast<uint32_t>(bucketIndex));
+            w.u32(static_cast<uint32_t>(occupancy));
+            tree.visit(bucketIndex, [&w](size_t blkLeaf, uint8_t flags, const MapSlot<K,V>& slot) {
+                w.u32(static_cast<uint32_t>(blkLeaf));
+                w.u8(flags & SLOT_HIGH_PRIORITY);
+                snapshot_write_key(w, slot.key);
+                w.bytes(slot.value);
+            });
+            w.end_record();
+        }
+        
+        w.u32(static_cast<uint32_t>(stash.size()));
+        for (const auto& blk : stash) {
+            w.u32(static_cast<uint32_t>(blk.leaf));
+            w.u8(blk.high_priority ? SLOT_HIGH_PRIORITY : 0);
+            snapshot_write_key(w, blk.key);
+            w.bytes(blk.value);
+        }
+        w.end_record();
+    }
+
+    // Restores a snapshot written by save_snapshot into an empty map with
+    // the same height and bucket capacity, rebuilding the position map
+    // from the blocks' leaves. Throws on a mismatched, truncated or
+    // tampered snapshot, or one written under other keys.
+    void load_snapshot(std::istream& in) {
+        std::lock_guard<std::mutex> lock(mtx);
+        
+        if (tree.size() != 0 || !stash.empty())
+            throw std::runtime_error("load_snapshot needs an empty map");
+        
+        SnapshotReader r(in);
+        r.next_record();
+        r.expect(r.u32(), SNAPSHOT_KIND_PATH, "kind");
+        r.expect(r.u32(), static_cast<uint32_t>(treeHeight), "tree height");
+        r.expect(r.u32(), static_cast<uint32_t>(bucketCapacity), "bucket capacity");
+        evictionCounter = r.u64();
+        uint64_t used = r.u64();
+        
+        size_t leaves = static_cast<size_t>(1) << treeHeight;
+        auto readBlock = [&](Block<K,V>& blk) {
+            blk.leaf = r.u32();
+            blk.high_priority = (r.u8() & SLOT_HIGH_PRIORITY) != 0;
+            blk.key = keyPool.acquire();
+            blk.value = valuePool.acquire();
+            snapshot_read_key(r, blk.key);
+            r.bytes(blk.value);
+            blk.tag = block_tag(blk.key);
+            if (blk.leaf >= leaves)
+                throw std::runtime_error("Snapshot block leaf out of range");
+            posMap.assign(blk.key, blk.leaf);
+        };
+        
+        for (uint64_t b = 0; b < used; b++) {
+            r.next_record();
+            size_t bucketIndex = r.u32();
+            uint32_t count = r.u32();
+            if (bucketIndex == 0 || bucketIndex > tree.bucket_count() ||
+                count > static_cast<uint32_t>(bucketCapacity))
+                throw std::runtime_error("Snapshot bucket out of range");
+            for (uint32_t i = 0; i < count; i++) {
+                Block<K,V> blk;
+                readBlock(blk);
+                if (!place_block(bucketIndex, blk))
+                    throw std::runtime_error("Snapshot bucket overfull");
+            }
+        }
+        
+        r.next_record();
+        uint32_t stashed = r.u32();
+        for (uint32_t i = 0; i < stashed; i++) {
+            Block<K,V> blk;
+            readBlock(blk);
+            blk.valid = true;
+            stash.push_back(std::move(blk));
+        }
+        // A stash over its limit is a state the map can be in (the excess
+        // carries from one access to the next, see settle_stash_bound), so it
+        // loads as it was saved and the next accesses work it off.
+    }
+
+    // Reads, modifies and rewrites one value in a single access.
+    // fn(V& plaintext, bool exists) returns true to store the value back,
+    // creating the key if it was absent. Returns whether the key existed.
+    template<typename Fn>
+    bool oblivious_update(const K& key, Fn&& fn) {
+        TimedLock lock(mtx, stats);
+        
+        AccessContext ctx = begin_access(key);
+        
+        bool exists = (ctx.target != NO_BLOCK);
+        V& plaintext = plainScratch;
+        if (exists) {
+            unseal(stash[ctx.target].value, plaintext);
+        } else {
+            plaintext.clear();
+        }
+        bool fits = true;
+        if (fn(plaintext, exists)) {
+            // An oversized result keeps the old value (or no block at all)
+            fits = slot_accepts(tree, key, plaintext.size() + CryptoEngine::OVERHEAD, 0);
+            if (fits) {
+                Block<K,V>& blk = exists ? stash[ctx.target] : create_block(key, ctx);
+                seal(plaintext, blk.value);
+            }
+        }
+        
+        end_access(ctx);
+        if (!fits) throw std::invalid_argument("Block too large for a tree slot");
+        return exists;
+    }
+    
+    // Reads and rewrites a uniformly random path. Indistinguishable from a
+    // real access to an observer of the tree; used as cover traffic.
+    void oblivious_dummy_access() {
+        TimedLock lock(mtx, stats);
+        
+        size_t leaf = secure_random_index(1 << treeHeight);
+        read_path(leaf);
+        write_path(leaf);
+    }
+    
     size_t getStashSize() const {
         std::lock_guard<std::mutex> lock(mtx);
         return stash.size();
     }
+
+    // Copy of the per-phase statistics (see oram-metrics.hpp).
+    OramStats getStats() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats;
+    }
+
+    void resetStats() {
+        std::lock_guard<std::mutex> lock(mtx);
+        stats.clear();
+    }
+    
+    // Number of live entries: blocks in the tree plus real stash blocks.
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t live = tree.size();
+        for (const auto& blk : stash) {
+            if (blk.valid) live++;
+        }
+        return live;
+    }
     
     // Helper functions for diagnostics
     int getTreeHeight() const { return treeHeight; }
     int getBucketCapacity() const { return bucketCapacity; }
     size_t getStashLimit() const { return stashLimit; }
+    size_t getPositionMapBytes() const { return posMap.memory_bytes(); }
+    EvictionMode getEvictionMode() const { return evictionMode; }
     bool isEmergencyModeEnabled() const { return dropNonEssentialBlocks; }
     
     // Explicitly enable emergency mode (dropping non-essential blocks)
     void enableEmergencyMode(bool enable) {
         std::lock_guard<std::mutex> lock(mtx);
         dropNonEssentialBlocks = enable;
-        std::cerr << "[NDNRouter] Emergency mode " << (enable ? "ENABLED" : "DISABLED") << "\n";
+        ORAM_INFO("[NDNRouter] Emergency mode " << (enable ? "ENABLED" : "DISABLED"));
+    }
+};
+
+// -------------------------
+// RecursivePositionMap (position map stored in a smaller ORAM)
+// -------------------------
+// Leaves are packed RECURSIVE_POSMAP_LEAVES_PER_BLOCK to a block and kept in
+// an inner ObliviousMap two levels shorter than the outer tree, so the only
+// structure held in the clear is the position map of the innermost map
+// (`Inner`, itself recursive for deeper recursion). Each remap or assign is
+// one inner PathORAM access. The inner map evicts in Bounded mode: the
+// heuristic's emergency drops would throw away posmap groups, and with them
+// the leaves of every outer block they track.
+constexpr int RECURSIVE_POSMAP_LEAVES_PER_BLOCK = 16;
+
+template<typename K, typename Inner>
+class RecursivePositionMap;
+
+// Number of position maps held in ORAM trees below a policy.
+template<typename PosMap>
+struct position_map_depth { static constexpr int value = 0; };
+
+template<typename K, typename Inner>
+struct position_map_depth<RecursivePositionMap<K, Inner>> {
+    static constexpr int value = 1 + position_map_depth<Inner>::value;
+};
+
+template<typename K, typename Inner = CompactPositionMap<std::string>>
+class RecursivePositionMap {
+private:
+    ObliviousMap<std::string, std::string, Inner> inner;
+    size_t mask;
+
+    size_t id_of(const K& key) const {
+        return static_cast<size_t>(keyed_hash(key)) & mask;
+    }
+
+    static std::string group_key(size_t id) {
+        uint64_t group = id / RECURSIVE_POSMAP_LEAVES_PER_BLOCK;
+        return std::string(reinterpret_cast<const char*>(&group), sizeof(group));
+    }
+
+    static size_t group_offset(size_t id) {
+        return (id % RECURSIVE_POSMAP_LEAVES_PER_BLOCK) * sizeof(uint32_t);
+    }
+
+public:
+    static constexpr bool shares_entries = true;
+
+    RecursivePositionMap(int treeHeight, int bucketCapacity)
+      : inner(std::max(1, treeHeight - 2), STASH_LIMIT_DEFAULT, bucketCapacity, EvictionMode::Bounded),
+        mask(position_map_id_space(treeHeight, bucketCapacity) - 1) {}
+
+    bool remap(const K& key, size_t newLeaf, size_t& oldLeaf) {
+        size_t id = id_of(key);
+        bool mapped = false;
+        inner.oblivious_update(group_key(id), [&](std::string& group, bool exists) {
+            if (!exists) return false;
+            uint32_t entry;
+            std::memcpy(&entry, group.data() + group_offset(id), sizeof(entry));
+            if (entry == POSMAP_UNMAPPED) return false;
+            oldLeaf = entry;
+            entry = static_cast<uint32_t>(newLeaf);
+            std::memcpy(&group[group_offset(id)], &entry, sizeof(entry));
+            mapped = true;
+            return true;
+        });
+        return mapped;
+    }
+
+    void assign(const K& key, size_t leaf) {
+        size_t id = id_of(key);
+        inner.oblivious_update(group_key(id), [&](std::string& group, bool exists) {
+            if (!exists) {
+                std::vector<uint32_t> empty(RECURSIVE_POSMAP_LEAVES_PER_BLOCK, POSMAP_UNMAPPED);
+                group.assign(reinterpret_cast<const char*>(empty.data()),
+                             empty.size() * sizeof(uint32_t));
+            }
+            uint32_t entry = static_cast<uint32_t>(leaf);
+            std::memcpy(&group[group_offset(id)], &entry, sizeof(entry));
+            return true;
+        });
     }
+
+    // Entries may be shared, so they are left mapped (see CompactPositionMap).
+    void erase(const K&) {}
+
+    bool same_entry(const K& a, const K& b) const { return id_of(a) == id_of(b); }
+
+    // Only the inner map's position map is held outside an ORAM tree.
+    size_t memory_bytes() const { return inner.getPositionMapBytes(); }
 };
 
-#endif
\ No newline at end of file
+#endif
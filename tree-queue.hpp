@@ -5,15 +5,18 @@
 #include <vector>
 #include <stdexcept>
 #include <cstdint>
-#include <atomic>
 #include <algorithm>
 #include <string>
 #include <cassert>
 #include <mutex>
-#include <thread>
-#include <chrono>
 
 #include "crypto.hpp"
+#include "secure-random.hpp"
+#include "path-eviction.hpp"
+#include "oram-storage.hpp"
+#include "eviction-scheduler.hpp"
+#include "oram-metrics.hpp"
+#include "oblivious-primitives.hpp"
 
 // -------------------------
 // Configuration Parameters - SIGNIFICANTLY INCREASED
@@ -23,474 +26,331 @@ constexpr int QUEUE_BUCKET_CAPACITY_DEFAULT = 20;     // Increased from 12 to 20
 constexpr size_t QUEUE_STASH_LIMIT_DEFAULT = 250;    // Increased from 100 to 250
 
 // -------------------------
-// QueueBlock and QueueBucket Structures - SIMPLIFIED
+// QueueBlock Structure - SIMPLIFIED
 // -------------------------
 template<typename T>
 struct QueueBlock {
     bool valid;
     T data;
-    size_t leaf; // Assigned leaf index
-    int eviction_attempt_count; // Track how many times we've tried to evict this block
+    size_t leaf;   // Assigned leaf index
+    uint64_t seq;  // Position in the queue
 
-    QueueBlock() : valid(false), data(), leaf(0), eviction_attempt_count(0) {}
-    QueueBlock(const T& d, size_t leaf_) : valid(true), data(d), leaf(leaf_), eviction_attempt_count(0) {}
+    QueueBlock() : valid(false), data(), leaf(0), seq(0) {}
+    QueueBlock(const T& d, size_t leaf_, uint64_t seq_) : valid(true), data(d), leaf(leaf_), seq(seq_) {}
+    QueueBlock(T&& d, size_t leaf_, uint64_t seq_) : valid(true), data(std::move(d)), leaf(leaf_), seq(seq_) {}
+
+    // Move-only, like the map's Block.
+    QueueBlock(const QueueBlock&) = delete;
+    QueueBlock& operator=(const QueueBlock&) = delete;
+    QueueBlock(QueueBlock&&) = default;
+    QueueBlock& operator=(QueueBlock&&) = default;
 };
 
+// Tree slot contents: the block's queue position travels with its data.
 template<typename T>
-struct QueueBucket {
-    std::vector<QueueBlock<T>> blocks;
-    
-    QueueBucket() {
-        blocks.resize(QUEUE_BUCKET_CAPACITY_DEFAULT);
-    }
-    
-    explicit QueueBucket(int capacity) {
-        blocks.resize(capacity);
-    }
+struct QueueSlot {
+    uint64_t seq;
+    T data;
 };
 
 // -------------------------
-// ObliviousQueue Class (PathORAM-based for Queue)
+// ObliviousQueue Class (PathORAM-based FIFO)
 // -------------------------
+// Elements are numbered by head/tail counters, and element i lives on leaf
+// PRF(i) under a per-queue SipHash key. Every element is written once and
+// read once, so its leaf never needs remapping and no position map exists.
+//
+// Push reads a uniformly random path (never PRF(tail), which would link the
+// push to its later pop) and evicts the new block along it. Pop reads the
+// single path PRF(head) and takes the one block with seq == head, from that
+// path or the stash. An empty pop reads a random path, so it looks like any
+// other pop. Blocks are never dropped or remapped: either would break FIFO
+// order. A stash left over its limit after an access gets extra evictions
+// (see write_path) and otherwise carries over; it is never reported as an
+// error, because the push or pop has already taken effect.
 template<typename T>
-class ObliviousQueue {
+class ObliviousQueue : public EvictionClient {
 private:
-    std::vector<QueueBucket<T>> tree;      // The ORAM tree (1-indexed)
-    int numBuckets;                        
-    int treeHeight;                        
-    std::vector<QueueBlock<T>> stash;      
-    size_t stashLimit;                     
-    int bucketCapacity;                    
+    FlatTree<QueueSlot<T>> tree;           // The ORAM tree (1-indexed, contiguous)
+    int numBuckets;
+    int treeHeight;
+    std::vector<QueueBlock<T>> stash;
+    size_t stashLimit;
+    int bucketCapacity;
     mutable std::mutex mtx;                // Global mutex for all operations
-    int evictionFailCount; // Track consecutive eviction failures
-    bool emergencyMode; // Flag for emergency block dropping
-
-    // Background eviction thread components.
-    std::atomic<bool> evictionThreadRunning;
-    std::thread evictionThread;
+    uint64_t head;                         // Sequence number of the next pop
+    uint64_t tail;                         // Sequence number of the next push
+    unsigned char leafKey[SIPHASH_KEY_SIZE]; // PRF key for element leaves
+    PathEvictor evictor;                   // Reusable greedy eviction engine
+    EvictionMode evictionMode;
+    uint64_t evictionCounter;              // deterministic evictions done (Bounded mode)
+    EvictionScheduler& scheduler;          // Shared background eviction pool
+    BufferPool<T> dataPool;                // buffers of popped blocks
+    std::vector<uint64_t> seqScratch;      // stash sequence numbers for ct_find_u64
+    OramStats stats;                       // per-phase timings and counters (under mtx)
 
     int compute_numBuckets(int height) {
         return (1 << (height + 1)) - 1;
     }
 
-    // Returns the path from a given leaf to the root.
+    // Leaf of the element with the given sequence number.
+    size_t leaf_of(uint64_t seq) const {
+        return static_cast<size_t>(siphash24(&seq, sizeof(seq), leafKey) & ((1ull << treeHeight) - 1));
+    }
+
+    // Returns the path from the root to a given leaf.
     std::vector<int> get_path_indices(size_t leaf) {
-        std::vector<int> path;
-        int index = (1 << treeHeight) - 1 + leaf;
-        while (index > 0) {
-            path.push_back(index);
-            index /= 2;
+        std::vector<int> path(treeHeight + 1);
+        for (int depth = 0; depth <= treeHeight; depth++) {
+            path[depth] = static_cast<int>(path_bucket_at_depth(leaf, depth, treeHeight));
         }
-        std::reverse(path.begin(), path.end());
         return path;
     }
 
-    // Reads blocks along the path into the stash.
-    void read_path(const std::vector<int>& path) {
-        // SUPER aggressive protection - check stash utilization before reading
-        if (stash.size() >= stashLimit * 0.5) {
-            std::cerr << "[EMERGENCY] Queue stash at " << stash.size() << "/" << stashLimit 
-                      << " before read_path. Performing critical eviction.\n";
-            critical_eviction();
-        }
-        
-        // Count how many blocks we'll be adding from this path
-        size_t potential_new_blocks = 0;
-        for (int idx : path) {
-            for (auto& blk : tree[idx].blocks) {
-                if (blk.valid) {
-                    potential_new_blocks++;
-                }
-            }
-        }
-        
-        // If adding these blocks would exceed the stash limit, we need to take extreme measures
-        if (stash.size() + potential_new_blocks > stashLimit * 0.9) {
-            std::cerr << "[CRITICAL] Reading queue path would add " << potential_new_blocks 
-                      << " blocks to a stash of size " << stash.size() 
-                      << " (limit: " << stashLimit << "). Taking drastic measures.\n";
-            
-            // Enable emergency mode
-            emergencyMode = true;
-            
-            // We'll aggressively clear space
-            while (stash.size() + potential_new_blocks > stashLimit * 0.7) {
-                if (!emergency_drop_blocks()) {
-                    // If we can't drop more blocks, we need to expand our stash
-                    std::cerr << "[EXTREME EMERGENCY] Cannot free enough queue space. Dynamically expanding stash.\n";
-                    stashLimit = static_cast<size_t>(stashLimit * 1.2); // Increase stash limit by 20%
-                    break;
-                }
-            }
-        }
-        
-        // Now read the path
-        for (int idx : path) {
-            for (auto& blk : tree[idx].blocks) {
-                if (blk.valid) {
-                    stash.push_back(blk);
-                    blk.valid = false;
-                }
-            }
-        }
-        
-        // Final safety check
-        if (stash.size() > stashLimit) {
-            std::cerr << "[OVERFLOW] Queue stash size " << stash.size() 
-                      << " exceeds limit " << stashLimit << " after read_path\n";
-            
-            // One last chance - drop enough blocks to get under the limit
-            while (stash.size() > stashLimit * 0.9) {
-                if (!emergency_drop_blocks()) {
-                    // Expand stash as a last resort
-                    stashLimit = static_cast<size_t>(stashLimit * 1.2);
-                    std::cerr << "[EXTREME] Dynamically expanded queue stash limit to " << stashLimit << "\n";
-                    break;
-                }
-            }
-            
-            // If we're still over the limit, we have to throw
-            if (stash.size() > stashLimit) {
-                throw std::runtime_error("Queue stash overflow error in read_path despite emergency measures");
-            }
-        }
+    // Moves a block into a free slot of the given bucket; false if it is full.
+    bool place_block(size_t bucketIndex, QueueBlock<T>& blk) {
+        // Check first: storing moves the block's data out.
+        if (tree.occupancy(bucketIndex) >= bucketCapacity) return false;
+        bool stored = tree.store(bucketIndex, blk.leaf, 0, QueueSlot<T>{blk.seq, std::move(blk.data)});
+        if (stored) stats.blocksWritten++;
+        return stored;
     }
 
-    // Emergency drop of some blocks to prevent stash overflow
-    bool emergency_drop_blocks() {
-        if (stash.empty()) {
-            return false;
+    // Reads blocks along the path to the given leaf into the stash.
+    void read_path(size_t leaf) {
+        PhaseTimer timer(stats, OramPhase::ReadPath);
+        for (int depth = 0; depth <= treeHeight; depth++) {
+            tree.drain(path_bucket_at_depth(leaf, depth, treeHeight),
+                [this](size_t blkLeaf, uint8_t, QueueSlot<T>&& slot) {
+                    stash.emplace_back(std::move(slot.data), blkLeaf, slot.seq);
+                    stats.blocksRead++;
+                });
         }
-        
-        // Sort by eviction attempts (drop most "stuck" blocks first)
-        std::sort(stash.begin(), stash.end(), [](const QueueBlock<T>& a, const QueueBlock<T>& b) {
-            return a.eviction_attempt_count > b.eviction_attempt_count;
-        });
-        
-        // Drop 20% of blocks in extreme emergencies
-        size_t to_drop = std::max<size_t>(1, stash.size() * 0.2);
-        
-        std::cerr << "[EMERGENCY] Dropping " << to_drop << " blocks from queue stash\n";
-        
-        // Remove blocks from the beginning (highest eviction attempts)
-        stash.erase(stash.begin(), stash.begin() + to_drop);
-        
-        return true;
+        stats.note_stash(stash.size());
     }
 
-    // Eviction routine along a specific path.
-    void write_path(const std::vector<int>& path) {
-        size_t maxAttempts = 5; // Increased from 3 to 5
-        size_t attempt = 0;
-        
-        while (stash.size() > stashLimit * 0.3 && attempt < maxAttempts) {
-            size_t prevSize = stash.size();
-            size_t evictedCount = 0;
-            
-            // Sort stash blocks by eviction attempts to prioritize eviction
-            std::sort(stash.begin(), stash.end(), [this](const QueueBlock<T>& a, const QueueBlock<T>& b) {
-                // Prioritize blocks that have been attempted less
-                if (a.eviction_attempt_count != b.eviction_attempt_count)
-                    return a.eviction_attempt_count < b.eviction_attempt_count;
-                
-                // Secondary sort by leaf depth (path length to root)
-                std::vector<int> pathA = get_path_indices(a.leaf);
-                std::vector<int> pathB = get_path_indices(b.leaf);
-                return pathA.size() < pathB.size();
-            });
-            
-            // Increment attempt counter for all blocks
-            for (auto& blk : stash) {
-                blk.eviction_attempt_count++;
-            }
-            
-            // Try to place blocks in buckets
-            for (int bucketIndex : path) {
-                QueueBucket<T>& bucket = tree[bucketIndex];
-                for (auto &slot : bucket.blocks) {
-                    if (!slot.valid) {
-                        auto it = std::find_if(stash.begin(), stash.end(), [&](const QueueBlock<T>& blk) {
-                            std::vector<int> blkPath = get_path_indices(blk.leaf);
-                            return std::find(blkPath.begin(), blkPath.end(), bucketIndex) != blkPath.end();
-                        });
-                        if (it != stash.end()) {
-                            slot = *it;
-                            slot.eviction_attempt_count = 0; // Reset counter once evicted
-                            stash.erase(it);
-                            evictedCount++;
-                        }
-                    }
-                }
-            }
-            
-            std::cerr << "[Eviction] queue write_path round " << attempt+1 << ": prev stash size = " << prevSize 
-                      << ", evicted = " << evictedCount 
-                      << ", new stash size = " << stash.size() << "\n";
-                      
-            if (evictedCount == 0) {
-                // If we couldn't evict anything, remap some blocks
-                remap_stuck_blocks();
-            }
-            
-            if (stash.size() >= prevSize && attempt > 1) {
-                // If we've made no progress after multiple attempts, maybe try dropping blocks
-                if (emergencyMode) {
-                    std::cerr << "[Eviction] queue write_path: no progress after " << attempt 
-                              << " attempts. Trying emergency drop.\n";
-                    emergency_drop_blocks();
-                } else {
-                    std::cerr << "[Eviction] queue write_path: no progress after " << attempt 
-                              << " attempts, breaking loop\n";
-                    break;
-                }
-            }
-            
-            attempt++;
-        }
-        
-        // If stash is still too large after write_path, try a more aggressive approach
-        if (stash.size() > stashLimit * 0.7) {
-            critical_eviction();
+    bool heuristic() const { return evictionMode == EvictionMode::Heuristic; }
+
+    // Hands the structure to the shared scheduler once the stash crosses the
+    // watermark.
+    void request_background_eviction() {
+        if (heuristic() && stash.size() > stashLimit * EVICTION_HIGH_WATERMARK) {
+            scheduler.submit(this);
         }
     }
-    
-    // Remap blocks that appear stuck in the stash
-    void remap_stuck_blocks() {
-        // Only remap blocks that have been attempted multiple times
-        size_t remapped = 0;
-        for (auto &blk : stash) {
-            if (blk.eviction_attempt_count > 2) {
-                blk.leaf = secure_random_index(1 << treeHeight);
-                blk.eviction_attempt_count = 0; // Reset counter
-                remapped++;
-            }
+
+    // One branch-free scan of every stash sequence number, empty or not.
+    // Returns the index of the block with seq == head, or stash.size() (no
+    // block ever carries seq == tail, so an empty queue finds nothing).
+    size_t find_head() {
+        size_t n = stash.size();
+        seqScratch.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            seqScratch[i] = ct_select_u64(stash[i].valid, stash[i].seq, ~head);
         }
-        std::cerr << "[Eviction] Remapped " << remapped << " stuck queue blocks\n";
+        return ct_find_u64(seqScratch.data(), n, head);
     }
-    
-    // Critical eviction for when stash is nearing capacity - more extreme than emergency
-    void critical_eviction() {
-        std::cerr << "[Eviction] CRITICAL QUEUE EVICTION: stash size = " << stash.size() 
-                  << "/" << stashLimit << "\n";
-        
-        // Remap ALL blocks in the stash with fresh random leaves
-        for (auto &blk : stash) {
-            blk.leaf = secure_random_index(1 << treeHeight);
-            blk.eviction_attempt_count = 0;
-        }
-        
-        // Aggressive full tree sweep
-        full_eviction(/*emergency=*/true);
-        
-        // If still too full, try dropping blocks
-        if (stash.size() > stashLimit * 0.8) {
-            std::cerr << "[Eviction] Critical queue eviction didn't free enough space. "
-                      << "Enabling emergency block dropping.\n";
-            emergencyMode = true;
-            emergency_drop_blocks();
+
+    // Bounded mode: reads the next path in reverse-lexicographic order and
+    // writes it back with as many stash blocks as fit.
+    void evict_next_path() {
+        size_t leaf = reverse_lex_leaf(evictionCounter++, treeHeight);
+        read_path(leaf);
+        evictor.evict_path(stash, leaf, treeHeight,
+            [this](size_t bucketIndex, QueueBlock<T>& blk) { return place_block(bucketIndex, blk); });
+    }
+
+    // Writes the accessed path back with as many stash blocks as fit. In
+    // Heuristic mode a stash past 70% of the limit gets an immediate sweep
+    // and one past the watermark is queued for background eviction; in
+    // Bounded mode a deterministic eviction follows every access, plus up to
+    // BOUNDED_OVERFLOW_EVICTIONS more while the stash is over its limit.
+    // The access has already moved head or tail, so whatever is left over
+    // carries to the next access.
+    void write_path(size_t leaf) {
+        PhaseTimer timer(stats, OramPhase::WritePath);
+        evictor.evict_path(stash, leaf, treeHeight,
+            [this](size_t bucketIndex, QueueBlock<T>& blk) { return place_block(bucketIndex, blk); });
+
+        if (!heuristic()) {
+            evict_next_path();
+            for (int i = 0; i < BOUNDED_OVERFLOW_EVICTIONS && stash.size() > stashLimit; i++) {
+                evict_next_path();
+            }
+        } else if (stash.size() > stashLimit * 0.7) {
+            full_eviction(/*emergency=*/true);
         }
+
+        request_background_eviction();
     }
-    
-    // Full eviction over the entire tree.
-    void full_eviction(bool emergency = false) {
-        size_t maxRounds = emergency ? 8 : 5;  // Increased rounds
+
+    // Full eviction over the entire tree: every stash block goes to the
+    // deepest bucket on its own path with room. Blocks keep their leaves.
+    // roundLimit caps the rounds (0 keeps the default for the mode).
+    void full_eviction(bool emergency = false, size_t roundLimit = 0) {
+        PhaseTimer timer(stats, OramPhase::FullEviction);
+        size_t maxRounds = roundLimit ? roundLimit : (emergency ? 8 : 5);
         size_t round = 0;
-        
+
         while ((stash.size() > stashLimit * (emergency ? 0.3 : 0.5)) && round < maxRounds) {
-            size_t prevSize = stash.size();
-            size_t evictedCount = 0;
-            
-            // Sort stash to prioritize eviction of less-attempted blocks
-            std::sort(stash.begin(), stash.end(), [](const QueueBlock<T>& a, const QueueBlock<T>& b) {
-                return a.eviction_attempt_count < b.eviction_attempt_count;
-            });
-            
-            // Try to place blocks in buckets across the entire tree
-            for (int idx = 1; idx <= numBuckets; idx++) {
-                QueueBucket<T>& bucket = tree[idx];
-                for (auto &slot : bucket.blocks) {
-                    if (!slot.valid && !stash.empty()) {
-                        auto it = std::find_if(stash.begin(), stash.end(), [&](const QueueBlock<T>& blk) {
-                            std::vector<int> blkPath = get_path_indices(blk.leaf);
-                            return std::find(blkPath.begin(), blkPath.end(), idx) != blkPath.end();
-                        });
-                        if (it != stash.end()) {
-                            slot = *it;
-                            slot.eviction_attempt_count = 0; // Reset counter once evicted
-                            stash.erase(it);
-                            evictedCount++;
-                        }
-                    }
-                }
-            }
-            
-            std::cerr << "[Eviction] queue full_eviction round " << round+1 << ": prev stash size = " << prevSize 
-                      << ", evicted = " << evictedCount 
-                      << ", new stash size = " << stash.size() << "\n";
-                      
-            if (evictedCount == 0 || stash.size() >= prevSize) {
-                std::cerr << "[Eviction] queue full_eviction: minimal progress, remapping all blocks\n";
-                
-                // Remap each block's leaf value in the stash
-                for (auto &blk : stash) {
-                    blk.leaf = secure_random_index(1 << treeHeight);
-                    blk.eviction_attempt_count = 0;
-                }
-                
-                // If still no progress after remapping in emergency mode, try more extreme measures
-                if (emergency && round > 3 && stash.size() >= prevSize) {
-                    // In extreme cases, we might need to drop some blocks
-                    if (stash.size() > stashLimit * 0.8) {
-                        std::cerr << "[Eviction] WARNING: Critical queue stash overflow imminent. "
-                                  << "Taking extreme measures.\n";
-                        
-                        // Enable emergency mode
-                        emergencyMode = true;
-                        emergency_drop_blocks();
-                    }
-                }
-            }
-            
+            size_t evictedCount = evictor.evict_tree(stash, treeHeight,
+                [this](size_t bucketIndex, QueueBlock<T>& blk) { return place_block(bucketIndex, blk); });
+            if (evictedCount == 0) break;  // Leaves are fixed, so another round cannot help
             round++;
         }
     }
 
 public:
-    // Constructor: initializes tree and starts background eviction.
-    ObliviousQueue(int height = QUEUE_TREE_HEIGHT_DEFAULT, 
+    // Constructor: initializes the tree and the per-queue leaf key.
+    ObliviousQueue(int height = QUEUE_TREE_HEIGHT_DEFAULT,
                    size_t stash_limit = QUEUE_STASH_LIMIT_DEFAULT,
-                   int bucket_capacity = QUEUE_BUCKET_CAPACITY_DEFAULT)
-      : treeHeight(height), stashLimit(stash_limit), bucketCapacity(bucket_capacity),
-        evictionFailCount(0), emergencyMode(false)
+                   int bucket_capacity = QUEUE_BUCKET_CAPACITY_DEFAULT,
+                   EvictionMode mode = EvictionMode::Heuristic)
+      : tree(height, bucket_capacity), treeHeight(height), stashLimit(stash_limit),
+        bucketCapacity(bucket_capacity), head(0), tail(0),
+        evictionMode(mode), evictionCounter(0), scheduler(EvictionScheduler::shared()),
+        dataPool(stash_limit)
     {
         numBuckets = compute_numBuckets(treeHeight);
-        tree.clear();
-        
-        // Create a dummy bucket at index 0 (we're 1-indexed)
-        tree.emplace_back(QueueBucket<T>());
-        
-        // Create the actual buckets
-        for (int i = 1; i <= numBuckets; i++) {
-            tree.emplace_back(QueueBucket<T>(bucket_capacity));
-        }
-        
-        evictionThreadRunning = true;
-        evictionThread = std::thread([this]() {
-            while (evictionThreadRunning) {
-                {
-                    std::lock_guard<std::mutex> lock(mtx);
-                    if (stash.size() > stashLimit * 0.5) {
-                        full_eviction();
-                    }
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(5)); // Reduced from 10ms to 5ms
-            }
-        });
+        stash.reserve(stash_limit + static_cast<size_t>(height + 1) * bucket_capacity);
+
+        uint64_t k0 = SecureRandom::local().next_u64();
+        uint64_t k1 = SecureRandom::local().next_u64();
+        std::memcpy(leafKey, &k0, sizeof(k0));
+        std::memcpy(leafKey + sizeof(k0), &k1, sizeof(k1));
     }
 
-    // Destructor: stops background eviction thread.
+    // Destructor: waits out any eviction slice still running on this structure.
     ~ObliviousQueue() {
-        evictionThreadRunning = false;
-        if (evictionThread.joinable()) {
-            evictionThread.join();
-        }
+        scheduler.retire(this);
+    }
+
+    // Background eviction slice, run by the scheduler without our lock held:
+    // at most one full-eviction round. Returns true while the stash is still
+    // above the watermark and the round made progress.
+    bool eviction_slice() override {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!heuristic() || stash.size() <= stashLimit * EVICTION_HIGH_WATERMARK) return false;
+        size_t before = stash.size();
+        full_eviction(/*emergency=*/false, /*roundLimit=*/1);
+        return stash.size() < before && stash.size() > stashLimit * EVICTION_HIGH_WATERMARK;
     }
 
+    // True while the stash is above the background-eviction watermark.
+    // Callers can use this as back-pressure and hold off new work.
+    bool isUnderPressure() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stash.size() > stashLimit * EVICTION_HIGH_WATERMARK;
+    }
+
+    // In Bounded mode this runs deterministic evictions until the stash is
+    // empty or every leaf has been visited once.
     void trigger_full_eviction() {
         std::lock_guard<std::mutex> lock(mtx);
+        if (!heuristic()) {
+            for (size_t i = 0; i < (static_cast<size_t>(1) << treeHeight) && !stash.empty(); i++) {
+                evict_next_path();
+            }
+            return;
+        }
         full_eviction(/*emergency=*/true);
     }
 
-    // Pushes an item into the queue.
+    // Appends an item at the tail of the queue.
     void oblivious_push(const T& item) {
-        std::lock_guard<std::mutex> lock(mtx);
-        
-        // Check stash size before operation
-        if (stash.size() > stashLimit * 0.6) {
-            std::cerr << "[ObliviousQueue] WARNING: High stash utilization before push: " 
-                      << stash.size() << "/" << stashLimit << "\n";
-            full_eviction();
-        }
-        
+        TimedLock lock(mtx, stats);
+
         size_t leaf = secure_random_index(1 << treeHeight);
-        std::vector<int> path = get_path_indices(leaf);
-        read_path(path);
-        
-        // Insert the new block
-        stash.push_back(QueueBlock<T>(secure_encrypt_string(item), leaf));
-        
-        // Immediately try to evict blocks
-        write_path(path);
-        
-        // Check stash size after operation
-        if (stash.size() > stashLimit * 0.6) {
-            full_eviction();
-        }
-        
-        if (stash.size() > stashLimit) {
-            throw std::runtime_error("Stash overflow after push in queue");
+        read_path(leaf);
+
+        // Insert the new block, encrypting straight into its data buffer
+        uint64_t seq = tail++;
+        stash.emplace_back(dataPool.acquire(), leaf_of(seq), seq);
+        {
+            PhaseTimer timer(stats, OramPhase::Crypto);
+            CryptoEngine::local().encrypt_into(item, stash.back().data);
         }
+
+        // Immediately try to evict blocks
+        write_path(leaf);
     }
-    
-    // Pops an item from the queue.
+
+    // Removes the item at the head of the queue. Returns false if empty.
     bool oblivious_pop(T& item) {
-        std::lock_guard<std::mutex> lock(mtx);
-        
-        // Check stash size before operation
-        if (stash.size() > stashLimit * 0.6) {
-            std::cerr << "[ObliviousQueue] WARNING: High stash utilization before pop: " 
-                      << stash.size() << "/" << stashLimit << "\n";
-            full_eviction();
-        }
-        
-        // Select a random path to access (for obliviousness)
-        size_t leaf = secure_random_index(1 << treeHeight);
-        std::vector<int> path = get_path_indices(leaf);
-        read_path(path);
-        
+        TimedLock lock(mtx, stats);
+
+        bool empty = (head == tail);
+        size_t leaf = empty ? secure_random_index(1 << treeHeight) : leaf_of(head);
+        read_path(leaf);
+        size_t hit = find_head();
+
         bool found = false;
-        if (!stash.empty()) {
-            // Sort stash by eviction attempts to prioritize removal of "stuck" blocks
-            std::sort(stash.begin(), stash.end(), [](const QueueBlock<T>& a, const QueueBlock<T>& b) {
-                return a.eviction_attempt_count > b.eviction_attempt_count;
-            });
-            
-            auto it = stash.begin();
-            QueueBlock<T> blk = *it;
-            stash.erase(it);
-            if (blk.valid) {
-                item = secure_decrypt_string(blk.data);
-                found = true;
+        if (!empty) {
+            if (hit == stash.size()) {
+                throw std::runtime_error("Queue head block missing from its path");
+            }
+            {
+                PhaseTimer timer(stats, OramPhase::Crypto);
+                CryptoEngine::local().decrypt_into(stash[hit].data, item);
             }
+            dataPool.release(stash[hit].data);
+            stash_swap_remove(stash, hit);
+            found = true;
+            head++;
         }
-        
+
         // Evict blocks back to the tree
-        write_path(path);
-        
-        // Check stash size after operation
-        if (stash.size() > stashLimit * 0.6) {
-            full_eviction();
-        }
-        
+        write_path(leaf);
+
         return found;
     }
-    
+
+    // Reads and evicts a random path like a push, without queueing anything.
+    void oblivious_dummy_push() {
+        TimedLock lock(mtx, stats);
+        size_t leaf = secure_random_index(1 << treeHeight);
+        read_path(leaf);
+        write_path(leaf);
+    }
+
+    // Performs the accesses of a pop on an empty queue (a random path and
+    // the stash scan) without removing the head.
+    void oblivious_dummy_pop() {
+        TimedLock lock(mtx, stats);
+        size_t leaf = secure_random_index(1 << treeHeight);
+        read_path(leaf);
+        find_head();
+        write_path(leaf);
+    }
+
+    // Number of queued items.
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return static_cast<size_t>(tail - head);
+    }
+
+    bool empty() const { return size() == 0; }
+
     size_t getStashSize() const {
         std::lock_guard<std::mutex> lock(mtx);
         return stash.size();
     }
-    
+
+    // Copy of the per-phase statistics (see oram-metrics.hpp).
+    OramStats getStats() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats;
+    }
+
+    void resetStats() {
+        std::lock_guard<std::mutex> lock(mtx);
+        stats.clear();
+    }
+
     int getTreeHeight() const { return treeHeight; }
     int getBucketCapacity() const { return bucketCapacity; }
     size_t getStashLimit() const { return stashLimit; }
-    bool isEmergencyModeEnabled() const { return emergencyMode; }
-    
-    // Explicitly enable emergency mode (dropping blocks)
-    void enableEmergencyMode(bool enable) {
-        std::lock_guard<std::mutex> lock(mtx);
-        emergencyMode = enable;
-        std::cerr << "[ObliviousQueue] Emergency mode " << (enable ? "ENABLED" : "DISABLED") << "\n";
-    }
+    EvictionMode getEvictionMode() const { return evictionMode; }
 };
 
-#endif
\ No newline at end of file
+#endif
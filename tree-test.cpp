@@ -11,13 +11,34 @@
 #include <unistd.h>
 #include <fstream>
 #include <random>
+#include <cmath>
 #include <algorithm>
 #include <numeric>
 #include <iomanip>
 #include <sstream>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <deque>
+#include <future>
+#include <array>
+#include <unordered_map>
+#include <stdexcept>
+#include <pthread.h>
+#include <sched.h>
 
 #include "tree-map.hpp"
 #include "tree-queue.hpp"
+#include "sharded-map.hpp"
+#include "oram-engine.hpp"
+#include "oram-autotune.hpp"
+#include "content-store.hpp"
+#include "lpm-fib.hpp"
+#include "deferred-retrieval.hpp"
+#include "spsc-ring.hpp"
+#include "oram-async.hpp"
+#include "oram-metrics.hpp"
+#include "oram-log.hpp"
 
 // -------------------------
 // Structures for Packets and Content
@@ -51,6 +72,30 @@ struct ORAMConfig {
     int queueBucketCapacity;
     size_t queueStashLimit;
     
+    // Partitioning: FIB and PIT are split over this many sub-ORAMs
+    int numShards;
+    
+    // Interests handled per burst by the benchmark (1 = one at a time)
+    int interestBurst;
+    
+    // Eviction policy for every ORAM structure (see path-eviction.hpp)
+    EvictionMode evictionMode;
+    
+    // ORAM engine behind the FIB and PIT shards (see oram-engine.hpp)
+    OramEngine engine;
+    
+    // File prefix for memory-mapped FIB/PIT trees; empty keeps them in RAM
+    std::string storagePath;
+    
+    // Key FIB/PIT ORAMs by 128-bit name hashes instead of names (see hashed-name.hpp)
+    bool hashedKeys;
+    
+    // Grow FIB/PIT trees online when they fill up (see oram-autotune.hpp)
+    bool autotune;
+    
+    // Position map of the FIB/PIT Path engine trees (see oram-engine.hpp)
+    PositionMapKind positionMap;
+    
     // Constructor with default values
     ORAMConfig(
         int tHeight = TREE_HEIGHT_DEFAULT,
@@ -58,23 +103,50 @@ struct ORAMConfig {
         size_t sLimit = STASH_LIMIT_DEFAULT,
         int qHeight = QUEUE_TREE_HEIGHT_DEFAULT,
         int qCapacity = QUEUE_BUCKET_CAPACITY_DEFAULT,
-        size_t qLimit = QUEUE_STASH_LIMIT_DEFAULT
+        size_t qLimit = QUEUE_STASH_LIMIT_DEFAULT,
+        int shards = SHARD_COUNT_DEFAULT,
+        int burst = 1,
+        EvictionMode eviction = EvictionMode::Heuristic,
+        OramEngine oramEngine = OramEngine::Path,
+        const std::string& storage = "",
+        bool hashed = false,
+        bool autotuned = false,
+        PositionMapKind posmap = PositionMapKind::Hash
     ) : treeHeight(tHeight),
         bucketCapacity(bCapacity),
         stashLimit(sLimit),
         queueTreeHeight(qHeight),
         queueBucketCapacity(qCapacity),
-        queueStashLimit(qLimit) {}
+        queueStashLimit(qLimit),
+        numShards(shards),
+        interestBurst(burst),
+        evictionMode(eviction),
+        engine(oramEngine),
+        storagePath(storage),
+        hashedKeys(hashed),
+        autotune(autotuned),
+        positionMap(posmap) {}
         
     // Method to create a string representation of the config
     std::string toString() const {
         std::stringstream ss;
-        ss << "Map(h=" << treeHeight << ",b=" << bucketCapacity << ",s=" << stashLimit << ")_"
+        ss << "Map(h=" << treeHeight << ",b=" << bucketCapacity << ",s=" << stashLimit
+           << ",p=" << numShards << ",burst=" << interestBurst
+           << ",e=" << (evictionMode == EvictionMode::Bounded ? "bounded" : "heuristic")
+           << ",o=" << oram_engine_name(engine) << (storagePath.empty() ? "" : ",mapped")
+           << (hashedKeys ? ",hashed" : "") << (autotune ? ",autotune" : "")
+           << (positionMap != PositionMapKind::Hash ? std::string(",pm=") + position_map_name(positionMap) : "") << ")_"
            << "Queue(h=" << queueTreeHeight << ",b=" << queueBucketCapacity << ",s=" << queueStashLimit << ")";
         return ss.str();
     }
 };
 
+// Autotuning parameters for the FIB/PIT stores, or nullptr for fixed-size trees.
+const AutotuneConfig* table_autotune(const ORAMConfig& oramConfig) {
+    static const AutotuneConfig defaults;
+    return oramConfig.autotune ? &defaults : nullptr;
+}
+
 // Function to estimate current memory usage
 size_t getCurrentMemoryUsage() {
     // This is a platform-specific implementation
@@ -140,6 +212,78 @@ public:
         return DataPacket{contentName, data};
     }
 };
+
+// -------------------------
+// Zipf Workload (scaling benchmark)
+// -------------------------
+// Names "/<prefix>/item<r>" for popularity ranks r in [0, namespaceSize),
+// drawn with P(r) proportional to 1/(r+1)^s. The CDF is built once and
+// shared read-only, so each load thread only owns its RNG.
+class ZipfWorkload {
+private:
+    std::vector<double> cdf;
+    std::vector<std::string> prefixes;
+    std::vector<std::string> consumerIds;
+
+public:
+    ZipfWorkload(size_t namespaceSize, double exponent) {
+        if (namespaceSize == 0)
+            throw std::invalid_argument("ZipfWorkload needs a non-empty namespace");
+        cdf.resize(namespaceSize);
+        double total = 0;
+        for (size_t r = 0; r < namespaceSize; r++) {
+            total += 1.0 / std::pow(static_cast<double>(r + 1), exponent);
+            cdf[r] = total;
+        }
+        for (auto& c : cdf) c /= total;
+        prefixes = {"/videos", "/images", "/text", "/apps", "/streaming",
+                    "/social", "/data", "/content", "/example", "/news"};
+        for (int i = 1; i <= 20; i++) {
+            consumerIds.push_back("consumer_" + std::to_string(i));
+        }
+    }
+    
+    size_t namespaceSize() const { return cdf.size(); }
+    
+    std::string name(size_t rank) const {
+        return prefixes[rank % prefixes.size()] + "/item" + std::to_string(rank);
+    }
+    
+    template<typename Rng>
+    std::string sampleName(Rng& rng) const {
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        size_t rank = std::lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin();
+        return name(std::min(rank, cdf.size() - 1));
+    }
+    
+    template<typename Rng>
+    InterestPacket generateInterest(Rng& rng) const {
+        std::uniform_int_distribution<size_t> consumerDist(0, consumerIds.size() - 1);
+        return InterestPacket{sampleName(rng), consumerIds[consumerDist(rng)]};
+    }
+};
+
+// Relative weights of the three router operations in a scaling run.
+struct OperationMix {
+    int interest = 50;
+    int data = 30;
+    int serve = 20;
+    
+    // Parses "interest:data:serve", e.g. "50:30:20".
+    static OperationMix parse(const std::string& text) {
+        OperationMix mix;
+        char sep1 = 0, sep2 = 0;
+        std::istringstream in(text);
+        if (!(in >> mix.interest >> sep1 >> mix.data >> sep2 >> mix.serve) || sep1 != ':' || sep2 != ':' ||
+            mix.interest < 0 || mix.data < 0 || mix.serve < 0 || mix.interest + mix.data + mix.serve == 0)
+            throw std::invalid_argument("Operation mix must be interest:data:serve weights, e.g. 50:30:20");
+        return mix;
+    }
+    
+    std::string toString() const {
+        return std::to_string(interest) + ":" + std::to_string(data) + ":" + std::to_string(serve);
+    }
+};
     
 // -------------------------
 // Performance Metrics Structure
@@ -149,10 +293,10 @@ struct PerformanceMetrics {
     int totalOperations = 0;
     double totalTimeSeconds = 0;
     
-    // Latency (microseconds)
-    std::vector<double> interestLatencies;
-    std::vector<double> dataLatencies;
-    std::vector<double> retrievalLatencies;
+    // Latency (nanoseconds, fixed-memory histograms)
+    HdrHistogram interestLatencies;
+    HdrHistogram dataLatencies;
+    HdrHistogram retrievalLatencies;
     
     // Memory usage
     size_t peakMemoryUsage = 0;
@@ -161,6 +305,18 @@ struct PerformanceMetrics {
     size_t maxStashSize = 0;
     std::vector<size_t> stashSizeHistory;
     
+    // Content Store hits and misses
+    int csHits = 0;
+    int csMisses = 0;
+    
+    // Per-phase ORAM statistics, collected when a run stops (oblivious router only)
+    bool hasOramStats = false;
+    OramStats fibStats;
+    OramStats pitStats;
+    OramStats csStats;
+    int fibTreeHeight = 0;         // at the end of the run; differs from the config when autotuned
+    int pitTreeHeight = 0;
+    
     void clear() {
         totalOperations = 0;
         totalTimeSeconds = 0;
@@ -170,45 +326,43 @@ struct PerformanceMetrics {
         peakMemoryUsage = 0;
         maxStashSize = 0;
         stashSizeHistory.clear();
+        csHits = 0;
+        csMisses = 0;
+        hasOramStats = false;
+        fibStats.clear();
+        pitStats.clear();
+        csStats.clear();
+        fibTreeHeight = 0;
+        pitTreeHeight = 0;
+    }
+    
+    static uint64_t to_ns(double micros) {
+        return micros > 0 ? static_cast<uint64_t>(micros * 1000.0) : 0;
     }
     
+    static double mean_us(const HdrHistogram& h) { return h.mean() / 1000.0; }
+    
     void printSummary(const std::string& title) const {
         std::cout << "\n===== " << title << " =====\n";
         std::cout << "Total operations: " << totalOperations << "\n";
         std::cout << "Total time: " << totalTimeSeconds << " seconds\n";
         std::cout << "Throughput: " << (totalOperations / totalTimeSeconds) << " ops/sec\n";
-        
-        // Calculate latency statistics
-        auto calcStats = [](const std::vector<double>& latencies) {
-            if (latencies.empty()) return std::make_tuple(0.0, 0.0, 0.0);
-            double sum = std::accumulate(latencies.begin(), latencies.end(), 0.0);
-            double mean = sum / latencies.size();
-            
-            std::vector<double> sorted = latencies;
-            std::sort(sorted.begin(), sorted.end());
-            double median = sorted[sorted.size() / 2];
-            
-            double variance = 0.0;
-            for (double x : latencies) {
-                variance += (x - mean) * (x - mean);
-            }
-            variance /= latencies.size();
-            double stddev = std::sqrt(variance);
-            
-            return std::make_tuple(mean, median, stddev);
-        };
-        
-        auto [interestMean, interestMedian, interestStdDev] = calcStats(interestLatencies);
-        auto [dataMean, dataMedian, dataStdDev] = calcStats(dataLatencies);
-        auto [retrievalMean, retrievalMedian, retrievalStdDev] = calcStats(retrievalLatencies);
+        if (csHits + csMisses > 0) {
+            std::cout << "CS hit ratio: " << (100.0 * csHits / (csHits + csMisses)) << "% ("
+                      << csHits << "/" << (csHits + csMisses) << ")\n";
+        }
         
         std::cout << std::fixed << std::setprecision(3);
-        std::cout << "Interest handling latency (μs): mean=" << interestMean 
-                    << ", median=" << interestMedian << ", stddev=" << interestStdDev << "\n";
-        std::cout << "Data handling latency (μs): mean=" << dataMean 
-                    << ", median=" << dataMedian << ", stddev=" << dataStdDev << "\n";
-        std::cout << "Content retrieval latency (μs): mean=" << retrievalMean 
-                    << ", median=" << retrievalMedian << ", stddev=" << retrievalStdDev << "\n";
+        auto printLatency = [](const char* label, const HdrHistogram& h) {
+            std::cout << label << " latency (μs): mean=" << h.mean() / 1000.0
+                      << ", median=" << h.percentile(0.5) / 1000.0
+                      << ", p99=" << h.percentile(0.99) / 1000.0
+                      << ", p999=" << h.percentile(0.999) / 1000.0
+                      << ", stddev=" << h.stddev() / 1000.0 << "\n";
+        };
+        printLatency("Interest handling", interestLatencies);
+        printLatency("Data handling", dataLatencies);
+        printLatency("Content retrieval", retrievalLatencies);
         
         if (!stashSizeHistory.empty()) {
             double avgStash = std::accumulate(stashSizeHistory.begin(), stashSizeHistory.end(), 0.0) / stashSizeHistory.size();
@@ -217,6 +371,31 @@ struct PerformanceMetrics {
         }
         
         std::cout << "Peak memory usage: " << (peakMemoryUsage / 1024.0 / 1024.0) << " MB\n";
+        
+        printOramPhases();
+    }
+    
+    // Where the ORAM time went: per-phase percentiles for each table.
+    void printOramPhases() const {
+        if (!hasOramStats) return;
+        auto printPhases = [](const char* table, const OramStats& stats) {
+            std::cout << table << " phases (μs, p50/p99/p999, total ms):\n";
+            for (size_t i = 0; i < ORAM_PHASE_COUNT; i++) {
+                const HdrHistogram& h = stats.phases[i];
+                if (h.count() == 0) continue;
+                std::cout << "  " << std::left << std::setw(17) << oram_phase_name(static_cast<OramPhase>(i))
+                          << std::right << h.percentile(0.5) / 1000.0 << " / " << h.percentile(0.99) / 1000.0
+                          << " / " << h.percentile(0.999) / 1000.0 << "  (" << h.total_value() / 1e6
+                          << " ms over " << h.count() << ")\n";
+            }
+            std::cout << "  blocks read=" << stats.blocksRead << ", written=" << stats.blocksWritten
+                      << ", emergency drops=" << stats.emergencyDrops
+                      << ", stash high-water=" << stats.stashHighWater << "\n";
+        };
+        printPhases("FIB", fibStats);
+        printPhases("PIT", pitStats);
+        printPhases("CS", csStats);
+        std::cout << "Tree heights: FIB=" << fibTreeHeight << ", PIT=" << pitTreeHeight << "\n";
     }
     
     void saveToCSV(const std::string& filename) const {
@@ -231,40 +410,19 @@ struct PerformanceMetrics {
         file << "TotalOperations," << totalOperations << "\n";
         file << "TotalTimeSeconds," << totalTimeSeconds << "\n";
         file << "Throughput," << (totalOperations / totalTimeSeconds) << "\n";
+        file << "CSHits," << csHits << "\n";
+        file << "CSMisses," << csMisses << "\n";
         
-        // Calculate statistics
-        auto calcStats = [](const std::vector<double>& latencies) {
-            if (latencies.empty()) return std::make_tuple(0.0, 0.0, 0.0);
-            double sum = std::accumulate(latencies.begin(), latencies.end(), 0.0);
-            double mean = sum / latencies.size();
-            
-            std::vector<double> sorted = latencies;
-            std::sort(sorted.begin(), sorted.end());
-            double median = sorted[sorted.size() / 2];
-            
-            double variance = 0.0;
-            for (double x : latencies) {
-                variance += (x - mean) * (x - mean);
-            }
-            variance /= latencies.size();
-            double stddev = std::sqrt(variance);
-            
-            return std::make_tuple(mean, median, stddev);
+        auto writeLatency = [&file](const std::string& name, const HdrHistogram& h) {
+            file << name << "LatencyMean," << h.mean() / 1000.0 << "\n";
+            file << name << "LatencyMedian," << h.percentile(0.5) / 1000.0 << "\n";
+            file << name << "LatencyP99," << h.percentile(0.99) / 1000.0 << "\n";
+            file << name << "LatencyP999," << h.percentile(0.999) / 1000.0 << "\n";
+            file << name << "LatencyStdDev," << h.stddev() / 1000.0 << "\n";
         };
-        
-        auto [interestMean, interestMedian, interestStdDev] = calcStats(interestLatencies);
-        auto [dataMean, dataMedian, dataStdDev] = calcStats(dataLatencies);
-        auto [retrievalMean, retrievalMedian, retrievalStdDev] = calcStats(retrievalLatencies);
-        
-        file << "InterestLatencyMean," << interestMean << "\n";
-        file << "InterestLatencyMedian," << interestMedian << "\n";
-        file << "InterestLatencyStdDev," << interestStdDev << "\n";
-        file << "DataLatencyMean," << dataMean << "\n";
-        file << "DataLatencyMedian," << dataMedian << "\n";
-        file << "DataLatencyStdDev," << dataStdDev << "\n";
-        file << "RetrievalLatencyMean," << retrievalMean << "\n";
-        file << "RetrievalLatencyMedian," << retrievalMedian << "\n";
-        file << "RetrievalLatencyStdDev," << retrievalStdDev << "\n";
+        writeLatency("Interest", interestLatencies);
+        writeLatency("Data", dataLatencies);
+        writeLatency("Retrieval", retrievalLatencies);
         
         if (!stashSizeHistory.empty()) {
             double avgStash = std::accumulate(stashSizeHistory.begin(), stashSizeHistory.end(), 0.0) / stashSizeHistory.size();
@@ -274,21 +432,24 @@ struct PerformanceMetrics {
         
         file << "PeakMemoryUsageMB," << (peakMemoryUsage / 1024.0 / 1024.0) << "\n";
         
-        // Write raw data for further analysis
-        file << "\nRaw Interest Latencies (μs)\n";
-        for (double lat : interestLatencies) {
-            file << lat << "\n";
+        if (hasOramStats) {
+            fibStats.write_csv(file, "FIB");
+            pitStats.write_csv(file, "PIT");
+            csStats.write_csv(file, "CS");
+            file << "FIBTreeHeight," << fibTreeHeight << "\n";
+            file << "PITTreeHeight," << pitTreeHeight << "\n";
         }
         
-        file << "\nRaw Data Latencies (μs)\n";
-        for (double lat : dataLatencies) {
-            file << lat << "\n";
-        }
-        
-        file << "\nRaw Retrieval Latencies (μs)\n";
-        for (double lat : retrievalLatencies) {
-            file << lat << "\n";
-        }
+        // Latency distributions as (bucket value in μs, count) pairs
+        auto writeBuckets = [&file](const std::string& title, const HdrHistogram& h) {
+            file << "\n" << title << " Latency Histogram (μs)\n";
+            h.for_each_bucket([&file](uint64_t value, uint64_t count) {
+                file << value / 1000.0 << "," << count << "\n";
+            });
+        };
+        writeBuckets("Interest", interestLatencies);
+        writeBuckets("Data", dataLatencies);
+        writeBuckets("Retrieval", retrievalLatencies);
         
         file << "\nStash Size History\n";
         for (size_t size : stashSizeHistory) {
@@ -298,30 +459,118 @@ struct PerformanceMetrics {
         file.close();
         std::cout << "Performance data saved to " << filename << "\n";
     }
+    
+    // Same summary as saveToCSV plus the latency and phase histograms' key
+    // percentiles, as one JSON object (all latencies in nanoseconds).
+    void saveToJSON(const std::string& filename) const {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file for writing: " << filename << "\n";
+            return;
+        }
+        file << "{\"totalOperations\":" << totalOperations
+             << ",\"totalTimeSeconds\":" << totalTimeSeconds
+             << ",\"throughput\":" << (totalTimeSeconds > 0 ? totalOperations / totalTimeSeconds : 0.0)
+             << ",\"csHits\":" << csHits << ",\"csMisses\":" << csMisses
+             << ",\"maxStashSize\":" << maxStashSize
+             << ",\"peakMemoryBytes\":" << peakMemoryUsage
+             << ",\"latencyNs\":{\"interest\":";
+        interestLatencies.write_json(file);
+        file << ",\"data\":";
+        dataLatencies.write_json(file);
+        file << ",\"retrieval\":";
+        retrievalLatencies.write_json(file);
+        file << "}";
+        if (hasOramStats) {
+            file << ",\"oram\":{\"FIB\":";
+            fibStats.write_json(file);
+            file << ",\"PIT\":";
+            pitStats.write_json(file);
+            file << ",\"CS\":";
+            csStats.write_json(file);
+            file << "}";
+        }
+        file << "}\n";
+        std::cout << "Performance data saved to " << filename << "\n";
+    }
 };    
 
+// -------------------------
+// PIT Entry Encoding
+// -------------------------
+// PIT values are "<consumerId>|<steady_clock ticks at arrival>" so that
+// stale entries can be recognised after decryption during expiry sweeps.
+constexpr std::chrono::milliseconds PIT_ENTRY_LIFETIME(4000);  // NDN default interest lifetime
+constexpr uint64_t PIT_EXPIRY_SWEEP_INTERVAL = 500;           // Interests between PIT sweeps
+
+std::string encode_pit_entry(const std::string& consumerId, std::chrono::steady_clock::time_point arrival) {
+    return consumerId + "|" + std::to_string(arrival.time_since_epoch().count());
+}
+
+bool decode_pit_entry(const std::string& entry, std::string& consumerId,
+                      std::chrono::steady_clock::time_point& arrival) {
+    size_t sep = entry.rfind('|');
+    if (sep == std::string::npos) return false;
+    consumerId = entry.substr(0, sep);
+    arrival = std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(std::stoll(entry.substr(sep + 1))));
+    return true;
+}
+
+bool pit_entry_expired(const std::string& entry, std::chrono::steady_clock::time_point now) {
+    std::string consumerId;
+    std::chrono::steady_clock::time_point arrival;
+    return !decode_pit_entry(entry, consumerId, arrival) || now - arrival >= PIT_ENTRY_LIFETIME;
+}
+
 // -------------------------
 // NDNRouter Class Using Oblivious Structures
 // -------------------------
 class NDNRouter {
 private:
-    ObliviousMap<std::string, std::string> FIB;
-    ObliviousMap<std::string, std::string> PIT;
-    ObliviousQueue<std::string> CS;
+    ObliviousFib FIB;   // longest-prefix match over route prefixes
+    ShardedObliviousMap<std::string, std::string> PIT;
+    ObliviousContentStore CS;
     PerformanceMetrics metrics;
+    std::mutex metricsMtx;   // handle_* may be called from several worker threads
     ORAMConfig config;
+    std::atomic<uint64_t> interestCount;
+    
+    // Storage for one table: a mapped file under the configured prefix, or
+    // nullptr for an in-memory tree.
+    static std::unique_ptr<MappedStorageConfig> table_storage(const ORAMConfig& oramConfig,
+                                                              const std::string& table) {
+        if (oramConfig.storagePath.empty()) return nullptr;
+        std::unique_ptr<MappedStorageConfig> storage(new MappedStorageConfig());
+        storage->path = oramConfig.storagePath + "." + table;
+        return storage;
+    }
+    
+    // Runs a PIT expiry sweep once every PIT_EXPIRY_SWEEP_INTERVAL interests.
+    void note_interests(uint64_t count) {
+        uint64_t before = interestCount.fetch_add(count);
+        if (before / PIT_EXPIRY_SWEEP_INTERVAL != (before + count) / PIT_EXPIRY_SWEEP_INTERVAL) {
+            expire_pit();
+        }
+    }
 
 public:
     NDNRouter(bool collectMetrics = false, const ORAMConfig& oramConfig = ORAMConfig())
-      : FIB(oramConfig.treeHeight, oramConfig.stashLimit, oramConfig.bucketCapacity),
-        PIT(oramConfig.treeHeight, oramConfig.stashLimit, oramConfig.bucketCapacity),
-        CS(oramConfig.queueTreeHeight, oramConfig.queueStashLimit, oramConfig.queueBucketCapacity),
-        config(oramConfig)
+      : FIB(oramConfig.numShards, oramConfig.treeHeight, oramConfig.stashLimit, oramConfig.bucketCapacity,
+            SHARD_COVER_ACCESSES_DEFAULT, oramConfig.evictionMode, oramConfig.engine,
+            table_storage(oramConfig, "fib").get(), oramConfig.hashedKeys, table_autotune(oramConfig),
+            oramConfig.positionMap),
+        PIT(oramConfig.numShards, oramConfig.treeHeight, oramConfig.stashLimit, oramConfig.bucketCapacity,
+            SHARD_COVER_ACCESSES_DEFAULT, oramConfig.evictionMode, oramConfig.engine,
+            table_storage(oramConfig, "pit").get(), oramConfig.hashedKeys, table_autotune(oramConfig),
+            oramConfig.positionMap),
+        CS(oramConfig.queueTreeHeight, oramConfig.queueStashLimit, oramConfig.queueBucketCapacity,
+           0, oramConfig.evictionMode),
+        config(oramConfig),
+        interestCount(0)
     {
-        // Pre-populate the FIB with example routes
-        FIB.oblivious_insert("/example", "eth0");
-        FIB.oblivious_insert("/content", "eth1");
-        FIB.oblivious_insert("/videos", "eth2");
+        // Pre-populate the FIB with example routes (sorted, for bulk_load)
+        FIB.bulk_load({{"/content", "eth1"}, {"/example", "eth0"}, {"/videos", "eth2"}});
         
         if (collectMetrics) {
             metrics.clear();
@@ -332,29 +581,90 @@ public:
         auto start = std::chrono::high_resolution_clock::now();
         
         std::string outInterface;
-        if (FIB.oblivious_lookup(interest.contentName, outInterface)) {
-            std::cout << "[NDNRouter] Interest for \"" << interest.contentName
-                      << "\" routed via " << outInterface << "\n";
+        if (FIB.lookup(interest.contentName, outInterface)) {
+            ORAM_DEBUG("[NDNRouter] Interest for \"" << interest.contentName
+                    << "\" routed via " << outInterface);
         } else {
-            std::cout << "[NDNRouter] No route for \"" << interest.contentName
-                      << "\"; dropping interest.\n";
+            ORAM_DEBUG("[NDNRouter] No route for \"" << interest.contentName
+                    << "\"; dropping interest.");
         }
-        PIT.oblivious_insert(interest.contentName, interest.consumerId);
+        PIT.oblivious_insert(interest.contentName,
+                             encode_pit_entry(interest.consumerId, std::chrono::steady_clock::now()));
+        note_interests(1);
         
         auto end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::micro> diff = end - start;
-        metrics.interestLatencies.push_back(diff.count());
-        metrics.totalOperations++;
         
         // Update stash metrics
         size_t fibStashSize = FIB.getStashSize();
         size_t pitStashSize = PIT.getStashSize();
         size_t totalStashSize = fibStashSize + pitStashSize;
+        size_t currentMemory = getCurrentMemoryUsage();
+        
+        std::lock_guard<std::mutex> lock(metricsMtx);
+        metrics.interestLatencies.record(PerformanceMetrics::to_ns(diff.count()));
+        metrics.totalOperations++;
         metrics.stashSizeHistory.push_back(totalStashSize);
         metrics.maxStashSize = std::max(metrics.maxStashSize, totalStashSize);
         
         // Update memory usage
+        metrics.peakMemoryUsage = std::max(metrics.peakMemoryUsage, currentMemory);
+    }
+
+    // Burst-mode interest handling: one batched FIB lookup (every prefix
+    // length of every name) and one batched PIT insert for the whole burst,
+    // so buckets shared by the packets' paths are read and written once.
+    // Latency is recorded per packet as the burst time divided by the burst
+    // size. The last `padding` interests are dummies (deferred-retrieval
+    // rounds): they take part in both batches like any other, but their PIT
+    // entries are written already expired, so the next sweep drops them,
+    // and they are left out of the metrics.
+    void handle_interests(const std::vector<InterestPacket>& interests, size_t padding = 0) {
+        if (interests.empty()) return;
+        size_t real = interests.size() - std::min(padding, interests.size());
+        auto start = std::chrono::high_resolution_clock::now();
+        
+        std::vector<std::string> names;
+        std::vector<std::pair<std::string, std::string>> pending;
+        names.reserve(interests.size());
+        pending.reserve(interests.size());
+        auto arrival = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < interests.size(); i++) {
+            names.push_back(interests[i].contentName);
+            pending.emplace_back(interests[i].contentName,
+                                 encode_pit_entry(interests[i].consumerId,
+                                                  i < real ? arrival : arrival - PIT_ENTRY_LIFETIME));
+        }
+        
+        std::vector<std::string> outInterfaces;
+        std::vector<bool> routed;
+        FIB.lookup_batch(names, outInterfaces, routed);
+        for (size_t i = 0; i < real; i++) {
+            if (routed[i]) {
+                ORAM_DEBUG("[NDNRouter] Interest for \"" << names[i]
+                        << "\" routed via " << outInterfaces[i]);
+            } else {
+                ORAM_DEBUG("[NDNRouter] No route for \"" << names[i]
+                        << "\"; dropping interest.");
+            }
+        }
+        PIT.oblivious_insert_batch(pending);
+        note_interests(interests.size());
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::micro> diff = end - start;
+        double perPacket = diff.count() / std::max<size_t>(real, 1);
+        
+        size_t totalStashSize = FIB.getStashSize() + PIT.getStashSize();
         size_t currentMemory = getCurrentMemoryUsage();
+        
+        std::lock_guard<std::mutex> lock(metricsMtx);
+        for (size_t i = 0; i < real; i++) {
+            metrics.interestLatencies.record(PerformanceMetrics::to_ns(perPacket));
+        }
+        metrics.totalOperations += real;
+        metrics.stashSizeHistory.push_back(totalStashSize);
+        metrics.maxStashSize = std::max(metrics.maxStashSize, totalStashSize);
         metrics.peakMemoryUsage = std::max(metrics.peakMemoryUsage, currentMemory);
     }
 
@@ -371,88 +681,110 @@ public:
     
         //  Warning if stash is getting close to the limit
         if (totalStashSize > STASH_LIMIT_DEFAULT * 0.9) {
-            std::cerr << "[NDNRouter] WARNING: Stash usage approaching overflow. "
-                      << "Total Stash: " << totalStashSize << "/" << STASH_LIMIT_DEFAULT << "\n";
+            ORAM_WARN("[NDNRouter] WARNING: Stash usage approaching overflow. "
+                   << "Total Stash: " << totalStashSize << "/" << STASH_LIMIT_DEFAULT);
         }
     
         //  Hard stop if stash is at full capacity
         if (totalStashSize > STASH_LIMIT_DEFAULT) {
-            std::cerr << "[NDNRouter] ERROR: Stash overflow detected! Delaying operations.\n";
+            ORAM_ERROR("[NDNRouter] ERROR: Stash overflow detected! Delaying operations.");
             return;
         }
     
-        std::cout << "[NDNRouter] Handling data for \"" << dataPacket.contentName << "\"\n";
-        std::string contentStr = dataPacket.contentName + ":" + dataPacket.data;
+        ORAM_DEBUG("[NDNRouter] Handling data for \"" << dataPacket.contentName << "\"");
+    
+        //  The CS stores at most CS_MAX_CHUNKS fixed-size chunks per name
+        if (dataPacket.data.size() > CS_MAX_CONTENT) {
+            ORAM_ERROR("[NDNRouter] ERROR: Data for \"" << dataPacket.contentName
+                    << "\" exceeds " << CS_MAX_CONTENT << " bytes; not cached.");
+            return;
+        }
     
         //  Ensure eviction before pushing to CS
         if (CS.getStashSize() > STASH_LIMIT_DEFAULT * 0.75) {
-            std::cerr << "[NDNRouter] WARNING: CS stash at 75% limit, triggering eviction.\n";
+            ORAM_WARN("[NDNRouter] WARNING: CS stash at 75% limit, triggering eviction.");
             CS.trigger_full_eviction();
         }
     
         //  Only push data if stash is under 75%
         if (CS.getStashSize() < STASH_LIMIT_DEFAULT * 0.75) {
-            CS.oblivious_push(contentStr);
+            CS.oblivious_insert(dataPacket.contentName, dataPacket.data);
         } else {
-            std::cerr << "[NDNRouter] ERROR: CS stash too full, cannot insert new data.\n";
+            ORAM_ERROR("[NDNRouter] ERROR: CS stash too full, cannot insert new data.");
             return;
         }
     
-        //  Look for a pending PIT entry
-        std::string consumer;
-        if (PIT.oblivious_lookup(dataPacket.contentName, consumer)) {
-            std::cout << "[NDNRouter] Found PIT entry for \"" << dataPacket.contentName
-                      << "\" with consumer \"" << consumer << "\"\n";
-            PIT.oblivious_insert(dataPacket.contentName, "dummy");  // Simulate cache resolution
+        //  Satisfy the pending PIT entry: it is removed in the same access
+        std::string entry;
+        if (PIT.oblivious_remove(dataPacket.contentName, &entry)) {
+            std::string consumer;
+            std::chrono::steady_clock::time_point arrival;
+            if (!decode_pit_entry(entry, consumer, arrival) ||
+                std::chrono::steady_clock::now() - arrival >= PIT_ENTRY_LIFETIME) {
+                ORAM_DEBUG("[NDNRouter] Discarded expired PIT entry for \"" << dataPacket.contentName << "\"");
+            } else {
+                ORAM_DEBUG("[NDNRouter] Found PIT entry for \"" << dataPacket.contentName
+                        << "\" with consumer \"" << consumer << "\"");
+            }
         } else {
-            std::cout << "[NDNRouter] No PIT entry for \"" << dataPacket.contentName << "\"\n";
+            ORAM_DEBUG("[NDNRouter] No PIT entry for \"" << dataPacket.contentName << "\"");
         }
     
         // Performance Metrics
         auto end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::micro> diff = end - start;
-        metrics.dataLatencies.push_back(diff.count());
+        std::lock_guard<std::mutex> lock(metricsMtx);
+        metrics.dataLatencies.record(PerformanceMetrics::to_ns(diff.count()));
         metrics.totalOperations++;
     }
     
     
 
-    bool serve_content(Content &servedContent) {
+    bool serve_content(const std::string& name, Content &servedContent) {
         auto start = std::chrono::high_resolution_clock::now();
     
         // Run full eviction proactively at 75% stash usage
         if (FIB.getStashSize() > STASH_LIMIT_DEFAULT * 0.75) {
-            std::cerr << "[NDNRouter] Running full eviction due to high stash usage.\n";
+            ORAM_WARN("[NDNRouter] Running full eviction due to high stash usage.");
             FIB.trigger_full_eviction();  
             PIT.trigger_full_eviction();
             CS.trigger_full_eviction();
         }
     
-        std::string contentStr;
-        bool success = false;
-        if (CS.oblivious_pop(contentStr)) {
-            size_t pos = contentStr.find(":");
-            if (pos != std::string::npos) {
-                servedContent.name = contentStr.substr(0, pos);
-                servedContent.data = contentStr.substr(pos + 1);
-                std::cout << "[NDNRouter] Serving content \"" << servedContent.name << "\"\n";
-                success = true;
-            }
+        // A hit is served in place; the entry stays cached for later interests
+        bool success = CS.oblivious_lookup(name, servedContent.data);
+        if (success) {
+            servedContent.name = name;
+            ORAM_DEBUG("[NDNRouter] Serving content \"" << servedContent.name << "\"");
         } else {
-            std::cout << "[NDNRouter] No content to serve.\n";
+            ORAM_DEBUG("[NDNRouter] No cached content for \"" << name << "\"");
         }
     
         auto end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::micro> diff = end - start;
-        metrics.retrievalLatencies.push_back(diff.count());
+        std::lock_guard<std::mutex> lock(metricsMtx);
+        metrics.retrievalLatencies.record(PerformanceMetrics::to_ns(diff.count()));
         metrics.totalOperations++;
+        if (success) metrics.csHits++; else metrics.csMisses++;
     
         return success;
     }
 
+    // Removes PIT entries older than PIT_ENTRY_LIFETIME in one bulk sweep.
+    size_t expire_pit() {
+        auto now = std::chrono::steady_clock::now();
+        size_t removed = PIT.expire_entries([now](const std::string&, const std::string& entry) {
+            return pit_entry_expired(entry, now);
+        });
+        if (removed > 0) {
+            ORAM_INFO("[NDNRouter] Expired " << removed << " stale PIT entries");
+        }
+        return removed;
+    }
+
     // Trigger full eviction on all data structures
     void trigger_full_eviction() {
-        std::cout << "[NDNRouter] Manually triggering full eviction on all data structures\n";
+        ORAM_INFO("[NDNRouter] Manually triggering full eviction on all data structures");
         FIB.trigger_full_eviction();
         PIT.trigger_full_eviction();
         CS.trigger_full_eviction();
@@ -468,15 +800,30 @@ public:
     
     void startMetricCollection() {
         metrics.clear();
+        FIB.resetStats();
+        PIT.resetStats();
+        CS.resetStats();
     }
     
     void stopMetricCollection(double elapsedTimeSeconds) {
         metrics.totalTimeSeconds = elapsedTimeSeconds;
+        metrics.hasOramStats = true;
+        metrics.fibStats = FIB.getStats();
+        metrics.pitStats = PIT.getStats();
+        metrics.csStats = CS.getStats();
+        metrics.fibTreeHeight = FIB.getTreeHeight();
+        metrics.pitTreeHeight = PIT.getTreeHeight();
     }
     
     const ORAMConfig& getConfig() const {
         return config;
     }
+    
+    // Back-pressure from the eviction scheduler: true while any structure
+    // is waiting for background eviction to bring its stash down.
+    bool isBackPressured() const {
+        return FIB.isUnderPressure() || PIT.isUnderPressure() || CS.isUnderPressure();
+    }
 };
 
 // -------------------------
@@ -486,11 +833,15 @@ class BaselineNDNRouter {
 private:
     std::unordered_map<std::string, std::string> FIB;
     std::unordered_map<std::string, std::string> PIT;
-    std::vector<std::string> CS;
+    std::unordered_map<std::string, std::string> CS;
+    std::deque<std::string> csOrder;   // FIFO replacement, same capacity as the oblivious CS
+    size_t csCapacity;
     PerformanceMetrics metrics;
 
 public:
-    BaselineNDNRouter(bool collectMetrics = false) {
+    BaselineNDNRouter(bool collectMetrics = false)
+      : csCapacity(static_cast<size_t>(1) << QUEUE_TREE_HEIGHT_DEFAULT)
+    {
         // Pre-populate the FIB with example routes (same as privacy version)
         FIB["/example"] = "eth0";
         FIB["/content"] = "eth1";
@@ -504,18 +855,24 @@ public:
     void handle_interest(const InterestPacket& interest) {
         auto start = std::chrono::high_resolution_clock::now();
         
-        if (FIB.find(interest.contentName) != FIB.end()) {
-            std::cout << "[BaselineNDN] Interest for \"" << interest.contentName
-                      << "\" routed via " << FIB[interest.contentName] << "\n";
+        // Longest-prefix match, like the oblivious FIB, but stopping at the first hit
+        std::vector<std::string> prefixes = name_prefixes(interest.contentName);
+        auto route = FIB.end();
+        for (auto it = prefixes.rbegin(); it != prefixes.rend() && route == FIB.end(); ++it) {
+            route = FIB.find(*it);
+        }
+        if (route != FIB.end()) {
+            ORAM_DEBUG("[BaselineNDN] Interest for \"" << interest.contentName
+                    << "\" routed via " << route->second);
         } else {
-            std::cout << "[BaselineNDN] No route for \"" << interest.contentName
-                      << "\"; dropping interest.\n";
+            ORAM_DEBUG("[BaselineNDN] No route for \"" << interest.contentName
+                    << "\"; dropping interest.");
         }
         PIT[interest.contentName] = interest.consumerId;
         
         auto end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::micro> diff = end - start;
-        metrics.interestLatencies.push_back(diff.count());
+        metrics.interestLatencies.record(PerformanceMetrics::to_ns(diff.count()));
         metrics.totalOperations++;
         
         // Update memory usage
@@ -526,21 +883,27 @@ public:
     void handle_data(const DataPacket& dataPacket) {
         auto start = std::chrono::high_resolution_clock::now();
         
-        std::cout << "[BaselineNDN] Handling data for \"" << dataPacket.contentName << "\"\n";
-        std::string contentStr = dataPacket.contentName + ":" + dataPacket.data;
-        CS.push_back(contentStr);
+        ORAM_DEBUG("[BaselineNDN] Handling data for \"" << dataPacket.contentName << "\"");
+        if (CS.find(dataPacket.contentName) == CS.end()) {
+            csOrder.push_back(dataPacket.contentName);
+            if (csOrder.size() > csCapacity) {
+                CS.erase(csOrder.front());
+                csOrder.pop_front();
+            }
+        }
+        CS[dataPacket.contentName] = dataPacket.data;
         
         if (PIT.find(dataPacket.contentName) != PIT.end()) {
-            std::cout << "[BaselineNDN] Found PIT entry for \"" << dataPacket.contentName
-                      << "\" with consumer \"" << PIT[dataPacket.contentName] << "\"\n";
-            PIT[dataPacket.contentName] = "dummy";
+            ORAM_DEBUG("[BaselineNDN] Found PIT entry for \"" << dataPacket.contentName
+                    << "\" with consumer \"" << PIT[dataPacket.contentName] << "\"");
+            PIT.erase(dataPacket.contentName);
         } else {
-            std::cout << "[BaselineNDN] No PIT entry for \"" << dataPacket.contentName << "\"\n";
+            ORAM_DEBUG("[BaselineNDN] No PIT entry for \"" << dataPacket.contentName << "\"");
         }
         
         auto end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::micro> diff = end - start;
-        metrics.dataLatencies.push_back(diff.count());
+        metrics.dataLatencies.record(PerformanceMetrics::to_ns(diff.count()));
         metrics.totalOperations++;
         
         // Update memory usage
@@ -548,29 +911,25 @@ public:
         metrics.peakMemoryUsage = std::max(metrics.peakMemoryUsage, currentMemory);
     }
 
-    bool serve_content(Content &servedContent) {
+    bool serve_content(const std::string& name, Content &servedContent) {
         auto start = std::chrono::high_resolution_clock::now();
         
         bool success = false;
-        if (!CS.empty()) {
-            std::string contentStr = CS.back();
-            CS.pop_back();
-            
-            size_t pos = contentStr.find(":");
-            if (pos != std::string::npos) {
-                servedContent.name = contentStr.substr(0, pos);
-                servedContent.data = contentStr.substr(pos + 1);
-                std::cout << "[BaselineNDN] Serving content \"" << servedContent.name << "\"\n";
-                success = true;
-            }
+        auto it = CS.find(name);
+        if (it != CS.end()) {
+            servedContent.name = name;
+            servedContent.data = it->second;
+            ORAM_DEBUG("[BaselineNDN] Serving content \"" << servedContent.name << "\"");
+            success = true;
         } else {
-            std::cout << "[BaselineNDN] No content to serve.\n";
+            ORAM_DEBUG("[BaselineNDN] No cached content for \"" << name << "\"");
         }
         
         auto end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::micro> diff = end - start;
-        metrics.retrievalLatencies.push_back(diff.count());
+        metrics.retrievalLatencies.record(PerformanceMetrics::to_ns(diff.count()));
         metrics.totalOperations++;
+        if (success) metrics.csHits++; else metrics.csMisses++;
         
         // Update memory usage
         size_t currentMemory = getCurrentMemoryUsage();
@@ -597,115 +956,407 @@ public:
 };
 
 // -------------------------
-// Configuration Benchmark
+// Pipelined NDN Router
 // -------------------------
-void run_configuration_benchmark(const std::vector<ORAMConfig>& configs, int numOperations) {
-    std::cout << "\n=========== CONFIGURATION BENCHMARK ===========\n";
-    std::cout << "Testing " << configs.size() << " different ORAM configurations with " 
-              << numOperations << " operations each\n";
+// FIB, PIT and CS each owned by one stage thread, with packets passed
+// between stages over SpscRings: ingress -> FIB -> PIT -> CS. Every packet
+// visits every stage in arrival order, and a stage with nothing to do for a
+// packet just forwards it, so each table sees the same operation order as
+// the serial router:
+//   Interest: FIB longest-prefix lookup, PIT insert;
+//   Data:     PIT remove (satisfy), CS insert;
+//   Serve:    CS lookup.
+// Tables are touched by their owning thread only, so their locks are never
+// contended (they are kept, being part of each structure). The CS stage
+// records end-to-end latency, queueing included. submit() must be called
+// from a single thread.
+constexpr size_t PIPELINE_RING_CAPACITY = 1024;
+
+enum class PipelineStageId { FIB, PIT, CS, Count };
+
+constexpr size_t PIPELINE_STAGE_COUNT = static_cast<size_t>(PipelineStageId::Count);
+
+inline const char* pipeline_stage_name(PipelineStageId stage) {
+    static const char* names[PIPELINE_STAGE_COUNT] = {"FIB", "PIT", "CS"};
+    return names[static_cast<size_t>(stage)];
+}
+
+struct PipelineStageStats {
+    uint64_t packets = 0;
+    uint64_t busyNs = 0;         // time spent on packets (table work)
+    uint64_t emptyPolls = 0;     // pops that found the input ring empty
+    uint64_t fullPushes = 0;     // pushes that found the output ring full
+    uint64_t depthSum = 0;       // input ring depth, summed over packets
+    size_t maxDepth = 0;
+    double elapsedSeconds = 0;   // stage thread lifetime
     
-    // Prepare CSV file for results
-    std::ofstream resultsFile("results/config_benchmark_results.csv");
-    resultsFile << "TreeHeight,BucketCapacity,StashLimit,QueueTreeHeight,QueueBucketCapacity,QueueStashLimit,"
-                << "Throughput,AvgInterestLatency,AvgDataLatency,AvgRetrievalLatency,MaxStashSize,TotalTimeSeconds\n";
+    double occupancy() const { return elapsedSeconds > 0 ? busyNs / (elapsedSeconds * 1e9) : 0.0; }
+    double meanDepth() const { return packets ? static_cast<double>(depthSum) / packets : 0.0; }
+};
+
+class PipelinedNDNRouter {
+public:
+    enum class Kind : uint8_t { Interest, Data, Serve };
     
-    // Setup workload generator
-    WorkloadGenerator workloadGen;
+    struct Packet {
+        Kind kind = Kind::Interest;
+        std::string name;
+        std::string payload;     // consumer id (Interest) or content (Data)
+        std::chrono::steady_clock::time_point ingress;
+    };
+    
+private:
+    ObliviousFib FIB;
+    ShardedObliviousMap<std::string, std::string> PIT;
+    ObliviousContentStore CS;
+    ORAMConfig config;
+    
+    SpscRing<Packet> toFib;
+    SpscRing<Packet> toPit;
+    SpscRing<Packet> toCs;
+    std::vector<std::thread> stages;
+    std::array<PipelineStageStats, PIPELINE_STAGE_COUNT> stageStats;
+    PerformanceMetrics metrics;   // written by the CS stage only
+    std::atomic<uint64_t> errors;
+    
+    static uint64_t ns_since(std::chrono::steady_clock::time_point t) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t).count());
+    }
+    
+    static void push(SpscRing<Packet>& ring, Packet& packet, PipelineStageStats& stats) {
+        while (!ring.try_push(std::move(packet))) {
+            stats.fullPushes++;
+            std::this_thread::yield();
+        }
+    }
+    
+    // Stage loop: pops from `in` until it is drained, calling work(packet)
+    // for each, then closes `out` (if any).
+    template<typename Work>
+    void run_stage(PipelineStageId id, SpscRing<Packet>& in, SpscRing<Packet>* out, Work work) {
+        PipelineStageStats& stats = stageStats[static_cast<size_t>(id)];
+        auto begin = std::chrono::steady_clock::now();
+        Packet packet;
+        while (true) {
+            size_t depth = in.size();
+            if (!in.try_pop(packet)) {
+                if (in.drained()) break;
+                stats.emptyPolls++;
+                std::this_thread::yield();
+                continue;
+            }
+            stats.depthSum += depth;
+            stats.maxDepth = std::max(stats.maxDepth, depth);
+            auto start = std::chrono::steady_clock::now();
+            try {
+                work(packet);
+            } catch (const std::exception& ex) {
+                if (errors.fetch_add(1) == 0) {
+                    ORAM_ERROR("[Pipeline] " << pipeline_stage_name(id) << " stage: " << ex.what());
+                }
+            }
+            stats.busyNs += ns_since(start);
+            stats.packets++;
+            if (out) push(*out, packet, stats);
+        }
+        if (out) out->close();
+        stats.elapsedSeconds = ns_since(begin) / 1e9;
+    }
+    
+    void fib_stage(Packet& packet) {
+        if (packet.kind != Kind::Interest) return;
+        std::string outInterface;
+        if (FIB.lookup(packet.name, outInterface)) {
+            ORAM_DEBUG("[Pipeline] Interest for \"" << packet.name << "\" routed via " << outInterface);
+        }
+    }
+    
+    void pit_stage(Packet& packet, uint64_t& interests) {
+        if (packet.kind == Kind::Interest) {
+            PIT.oblivious_insert(packet.name, encode_pit_entry(packet.payload, packet.ingress));
+            if (++interests % PIT_EXPIRY_SWEEP_INTERVAL == 0) {
+                auto now = std::chrono::steady_clock::now();
+                PIT.expire_entries([now](const std::string&, const std::string& entry) {
+                    return pit_entry_expired(entry, now);
+                });
+            }
+        } else if (packet.kind == Kind::Data) {
+            PIT.oblivious_remove(packet.name);
+        }
+    }
     
-    for (const auto& config : configs) {
-        std::cout << "\nTesting configuration: Tree height=" << config.treeHeight
-                  << ", Bucket capacity=" << config.bucketCapacity
-                  << ", Stash limit=" << config.stashLimit << "\n";
+    void cs_stage(Packet& packet) {
+        if (packet.kind == Kind::Data) {
+            if (packet.payload.size() <= CS_MAX_CONTENT) {
+                if (CS.getStashSize() > STASH_LIMIT_DEFAULT * 0.75) CS.trigger_full_eviction();
+                CS.oblivious_insert(packet.name, packet.payload);
+            }
+        } else if (packet.kind == Kind::Serve) {
+            std::string data;
+            if (CS.oblivious_lookup(packet.name, data)) metrics.csHits++; else metrics.csMisses++;
+        }
         
-        try {
-            // Create router with this configuration
-            NDNRouter router(true, config);
+        uint64_t latency = ns_since(packet.ingress);
+        if (packet.kind == Kind::Interest) metrics.interestLatencies.record(latency);
+        else if (packet.kind == Kind::Data) metrics.dataLatencies.record(latency);
+        else metrics.retrievalLatencies.record(latency);
+        metrics.totalOperations++;
+        size_t stash = CS.getStashSize();
+        metrics.maxStashSize = std::max(metrics.maxStashSize, stash);
+    }
+    
+public:
+    PipelinedNDNRouter(const ORAMConfig& oramConfig = ORAMConfig())
+      : FIB(oramConfig.numShards, oramConfig.treeHeight, oramConfig.stashLimit, oramConfig.bucketCapacity,
+            SHARD_COVER_ACCESSES_DEFAULT, oramConfig.evictionMode, oramConfig.engine, nullptr,
+            oramConfig.hashedKeys, table_autotune(oramConfig)),
+        PIT(oramConfig.numShards, oramConfig.treeHeight, oramConfig.stashLimit, oramConfig.bucketCapacity,
+            SHARD_COVER_ACCESSES_DEFAULT, oramConfig.evictionMode, oramConfig.engine, nullptr,
+            oramConfig.hashedKeys, table_autotune(oramConfig)),
+        CS(oramConfig.queueTreeHeight, oramConfig.queueStashLimit, oramConfig.queueBucketCapacity,
+           0, oramConfig.evictionMode),
+        config(oramConfig),
+        toFib(PIPELINE_RING_CAPACITY),
+        toPit(PIPELINE_RING_CAPACITY),
+        toCs(PIPELINE_RING_CAPACITY),
+        errors(0)
+    {
+        FIB.bulk_load({{"/content", "eth1"}, {"/example", "eth0"}, {"/videos", "eth2"}});
+    }
+    
+    ~PipelinedNDNRouter() {
+        if (!stages.empty()) finish();
+    }
+    
+    // Starts the stage threads; packets may be submitted until finish().
+    void start() {
+        metrics.clear();
+        stages.emplace_back([this] {
+            run_stage(PipelineStageId::FIB, toFib, &toPit, [this](Packet& p) { fib_stage(p); });
+        });
+        stages.emplace_back([this] {
+            uint64_t interests = 0;
+            run_stage(PipelineStageId::PIT, toPit, &toCs, [this, &interests](Packet& p) { pit_stage(p, interests); });
+        });
+        stages.emplace_back([this] {
+            run_stage(PipelineStageId::CS, toCs, nullptr, [this](Packet& p) { cs_stage(p); });
+        });
+    }
+    
+    void submit(Kind kind, const std::string& name, std::string payload = std::string()) {
+        Packet packet;
+        packet.kind = kind;
+        packet.name = name;
+        packet.payload = std::move(payload);
+        packet.ingress = std::chrono::steady_clock::now();
+        while (!toFib.try_push(std::move(packet))) std::this_thread::yield();
+    }
+    
+    // Closes the ingress ring and waits until every packet has left the CS
+    // stage. Returns the metrics; totalTimeSeconds is the caller's to set.
+    const PerformanceMetrics& finish() {
+        toFib.close();
+        for (auto& stage : stages) stage.join();
+        stages.clear();
+        metrics.hasOramStats = true;
+        metrics.fibStats = FIB.getStats();
+        metrics.pitStats = PIT.getStats();
+        metrics.csStats = CS.getStats();
+        metrics.fibTreeHeight = FIB.getTreeHeight();
+        metrics.pitTreeHeight = PIT.getTreeHeight();
+        return metrics;
+    }
+    
+    PerformanceMetrics& getMetrics() { return metrics; }
+    const PipelineStageStats& getStageStats(PipelineStageId stage) const {
+        return stageStats[static_cast<size_t>(stage)];
+    }
+    uint64_t getErrors() const { return errors.load(); }
+    
+    // Stage with the highest busy fraction: the pipeline's throughput bound.
+    PipelineStageId bottleneck() const {
+        size_t worst = 0;
+        for (size_t i = 1; i < PIPELINE_STAGE_COUNT; i++) {
+            if (stageStats[i].occupancy() > stageStats[worst].occupancy()) worst = i;
+        }
+        return static_cast<PipelineStageId>(worst);
+    }
+};
+
+// -------------------------
+// Parallel Runs
+// -------------------------
+// One independent benchmark run: a fresh router for `config` driven through
+// `operations` interest/data/serve rounds from its own workload stream.
+struct ConfigRun {
+    ORAMConfig config;
+    int operations = 0;
+    int seed = 42;
+    bool ok = false;
+    std::string error;
+    PerformanceMetrics metrics;
+    
+    double throughput() const { return metrics.totalOperations / metrics.totalTimeSeconds; }
+};
+
+// Runs `run` to completion, recording metrics or the error that stopped it.
+// Progress lines are only printed when `showProgress` is set (serial runs).
+void execute_config_run(ConfigRun& run, bool showProgress) {
+    try {
+        WorkloadGenerator workloadGen(run.seed);
+        NDNRouter router(true, run.config);
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        router.startMetricCollection();
+        
+        int numOperations = run.operations;
+        int burst = std::max(1, run.config.interestBurst);
+        std::vector<InterestPacket> interests;
+        for (int i = 0; i < numOperations; i += burst) {
+            if (showProgress && i % 100 < burst && i > 0) {
+                std::cout << "Completed " << i << "/" << numOperations << " operations\r";
+                std::cout.flush();
+            }
             
-            auto start = std::chrono::high_resolution_clock::now();
-            router.startMetricCollection();
+            int count = std::min(burst, numOperations - i);
+            interests.clear();
+            for (int j = 0; j < count; j++) {
+                interests.push_back(workloadGen.generateInterest());
+            }
+            if (count == 1) {
+                router.handle_interest(interests[0]);
+            } else {
+                router.handle_interests(interests);
+            }
             
-            for (int i = 0; i < numOperations; i++) {
-                if (i % 100 == 0 && i > 0) {
-                    std::cout << "Completed " << i << "/" << numOperations << " operations\r";
-                    std::cout.flush();
-                }
-                
-                InterestPacket interest = workloadGen.generateInterest();
-                router.handle_interest(interest);
-                
+            for (const auto& interest : interests) {
                 DataPacket data = workloadGen.generateData(interest.contentName);
                 router.handle_data(data);
                 
                 Content content;
-                router.serve_content(content);
-            }
-            
-            auto end = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<double> diff = end - start;
-            router.stopMetricCollection(diff.count());
-            
-            // Calculate metrics
-            double throughput = router.getMetrics().totalOperations / router.getMetrics().totalTimeSeconds;
-            
-            double avgInterestLatency = 0.0;
-            if (!router.getMetrics().interestLatencies.empty()) {
-                avgInterestLatency = std::accumulate(
-                    router.getMetrics().interestLatencies.begin(),
-                    router.getMetrics().interestLatencies.end(), 0.0
-                ) / router.getMetrics().interestLatencies.size();
-            }
-            
-            double avgDataLatency = 0.0;
-            if (!router.getMetrics().dataLatencies.empty()) {
-                avgDataLatency = std::accumulate(
-                    router.getMetrics().dataLatencies.begin(),
-                    router.getMetrics().dataLatencies.end(), 0.0
-                ) / router.getMetrics().dataLatencies.size();
+                router.serve_content(interest.contentName, content);
             }
-            
-            double avgRetrievalLatency = 0.0;
-            if (!router.getMetrics().retrievalLatencies.empty()) {
-                avgRetrievalLatency = std::accumulate(
-                    router.getMetrics().retrievalLatencies.begin(),
-                    router.getMetrics().retrievalLatencies.end(), 0.0
-                ) / router.getMetrics().retrievalLatencies.size();
+        }
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> diff = end - start;
+        router.stopMetricCollection(diff.count());
+        run.metrics = router.getMetrics();
+        run.ok = true;
+    } catch (const std::exception& ex) {
+        run.error = ex.what();
+    }
+}
+
+// Pins the calling thread to one CPU (modulo the CPUs it may run on).
+// Best effort: a failure leaves the thread unpinned.
+void pin_current_thread(int slot) {
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    int cpus = CPU_COUNT(&allowed);
+    if (cpus <= 1) return;
+    int target = slot % cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        if (target-- == 0) {
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            pthread_setaffinity_np(pthread_self(), sizeof(one), &one);
+            return;
+        }
+    }
+}
+
+// Default worker count: one per available core.
+int default_sweep_workers() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Executes the runs on `workers` threads, each pinned to its own core and
+// taking the next unclaimed run until none are left. Runs share nothing
+// but the process, so peak memory figures are process-wide while more
+// than one worker is active. `onDone(i)` is called, serialised, as run i
+// finishes.
+template<typename OnDone>
+void execute_config_runs(std::vector<ConfigRun>& runs, int workers, OnDone onDone) {
+    workers = std::max(1, std::min<int>(workers, static_cast<int>(runs.size())));
+    if (workers == 1) {
+        for (size_t i = 0; i < runs.size(); i++) {
+            execute_config_run(runs[i], true);
+            onDone(i);
+        }
+        return;
+    }
+    
+    std::atomic<size_t> next(0);
+    std::mutex doneMtx;
+    std::vector<std::thread> pool;
+    for (int w = 0; w < workers; w++) {
+        pool.emplace_back([&, w] {
+            pin_current_thread(w);
+            for (size_t i = next.fetch_add(1); i < runs.size(); i = next.fetch_add(1)) {
+                execute_config_run(runs[i], false);
+                std::lock_guard<std::mutex> lock(doneMtx);
+                onDone(i);
             }
-            
-            size_t maxStashSize = router.getMetrics().maxStashSize;
-            
-            // Print results
-            std::cout << "Throughput: " << throughput << " ops/sec\n";
-            std::cout << "Avg Interest Latency: " << avgInterestLatency << " μs\n";
-            std::cout << "Avg Data Latency: " << avgDataLatency << " μs\n";
-            std::cout << "Avg Retrieval Latency: " << avgRetrievalLatency << " μs\n";
-            std::cout << "Max Stash Size: " << maxStashSize << " blocks\n";
-            std::cout << "Total Time: " << router.getMetrics().totalTimeSeconds << " seconds\n";
-            
-            // Write to CSV
-            resultsFile << config.treeHeight << ","
-                       << config.bucketCapacity << ","
-                       << config.stashLimit << ","
-                       << config.queueTreeHeight << ","
-                       << config.queueBucketCapacity << ","
-                       << config.queueStashLimit << ","
-                       << throughput << ","
-                       << avgInterestLatency << ","
-                       << avgDataLatency << ","
-                       << avgRetrievalLatency << ","
-                       << maxStashSize << ","
-                       << router.getMetrics().totalTimeSeconds << "\n";
-            
-            // Save detailed metrics
-            std::string filename = "results/config_th" + std::to_string(config.treeHeight) + 
-                                 "_bc" + std::to_string(config.bucketCapacity) + 
-                                 "_sl" + std::to_string(config.stashLimit) + ".csv";
-            router.getMetrics().saveToCSV(filename);
-            
-        } catch (const std::exception& ex) {
+        });
+    }
+    for (auto& worker : pool) worker.join();
+}
+
+// -------------------------
+// Configuration Benchmark
+// -------------------------
+// Every configuration runs the same seeded workload; with workers > 1 the
+// configurations run concurrently and are reported in their given order.
+void run_configuration_benchmark(const std::vector<ORAMConfig>& configs, int numOperations,
+                                 int workers = 1) {
+    std::cout << "\n=========== CONFIGURATION BENCHMARK ===========\n";
+    std::cout << "Testing " << configs.size() << " different ORAM configurations with " 
+              << numOperations << " operations each";
+    if (workers > 1) std::cout << " on " << workers << " workers";
+    std::cout << "\n";
+    
+    // Prepare CSV file for results
+    std::ofstream resultsFile("results/config_benchmark_results.csv");
+    resultsFile << "TreeHeight,BucketCapacity,StashLimit,QueueTreeHeight,QueueBucketCapacity,QueueStashLimit,"
+                << "Throughput,AvgInterestLatency,AvgDataLatency,AvgRetrievalLatency,MaxStashSize,TotalTimeSeconds\n";
+    
+    std::vector<ConfigRun> runs(configs.size());
+    for (size_t i = 0; i < configs.size(); i++) {
+        runs[i].config = configs[i];
+        runs[i].operations = numOperations;
+    }
+    
+    if (workers <= 1) {
+        // Serial runs print each configuration as it starts, as before
+        for (ConfigRun& run : runs) {
+            std::cout << "\nTesting configuration: Tree height=" << run.config.treeHeight
+                      << ", Bucket capacity=" << run.config.bucketCapacity
+                      << ", Stash limit=" << run.config.stashLimit << "\n";
+            execute_config_run(run, true);
+        }
+    } else {
+        execute_config_runs(runs, workers, [&runs](size_t i) {
+            std::cout << "Finished " << runs[i].config.toString() << (runs[i].ok ? "" : " (error)") << "\n";
+        });
+    }
+    
+    for (const ConfigRun& run : runs) {
+        const ORAMConfig& config = run.config;
+        if (workers > 1) {
+            std::cout << "\nConfiguration: Tree height=" << config.treeHeight
+                      << ", Bucket capacity=" << config.bucketCapacity
+                      << ", Stash limit=" << config.stashLimit << "\n";
+        }
+        
+        if (!run.ok) {
             std::cerr << "ERROR with configuration (h=" << config.treeHeight 
                       << ", b=" << config.bucketCapacity 
                       << ", s=" << config.stashLimit 
-                      << "): " << ex.what() << "\n";
+                      << "): " << run.error << "\n";
                       
             resultsFile << config.treeHeight << ","
                        << config.bucketCapacity << ","
@@ -713,8 +1364,51 @@ void run_configuration_benchmark(const std::vector<ORAMConfig>& configs, int num
                        << config.queueTreeHeight << ","
                        << config.queueBucketCapacity << ","
                        << config.queueStashLimit << ","
-                       << "ERROR: " << ex.what() << "\n";
+                       << "ERROR: " << run.error << "\n";
+            continue;
         }
+        
+        // Calculate metrics
+        const PerformanceMetrics& m = run.metrics;
+        double throughput = run.throughput();
+        
+        double avgInterestLatency = PerformanceMetrics::mean_us(m.interestLatencies);
+        
+        double avgDataLatency = PerformanceMetrics::mean_us(m.dataLatencies);
+        
+        double avgRetrievalLatency = PerformanceMetrics::mean_us(m.retrievalLatencies);
+        
+        size_t maxStashSize = m.maxStashSize;
+        
+        // Print results
+        std::cout << "Throughput: " << throughput << " ops/sec\n";
+        std::cout << "Avg Interest Latency: " << avgInterestLatency << " μs\n";
+        std::cout << "Avg Data Latency: " << avgDataLatency << " μs\n";
+        std::cout << "Avg Retrieval Latency: " << avgRetrievalLatency << " μs\n";
+        std::cout << "Max Stash Size: " << maxStashSize << " blocks\n";
+        std::cout << "Total Time: " << m.totalTimeSeconds << " seconds\n";
+        m.printOramPhases();
+        
+        // Write to CSV
+        resultsFile << config.treeHeight << ","
+                   << config.bucketCapacity << ","
+                   << config.stashLimit << ","
+                   << config.queueTreeHeight << ","
+                   << config.queueBucketCapacity << ","
+                   << config.queueStashLimit << ","
+                   << throughput << ","
+                   << avgInterestLatency << ","
+                   << avgDataLatency << ","
+                   << avgRetrievalLatency << ","
+                   << maxStashSize << ","
+                   << m.totalTimeSeconds << "\n";
+        
+        // Save detailed metrics
+        std::string filename = "results/config_th" + std::to_string(config.treeHeight) + 
+                             "_bc" + std::to_string(config.bucketCapacity) + 
+                             "_sl" + std::to_string(config.stashLimit);
+        m.saveToCSV(filename + ".csv");
+        m.saveToJSON(filename + ".json");
     }
     
     resultsFile.close();
@@ -766,7 +1460,7 @@ void compare_with_baseline(const std::vector<int>& operationCounts) {
                 baselineRouter.handle_data(data);
                 
                 Content content;
-                baselineRouter.serve_content(content);
+                baselineRouter.serve_content(interest.contentName, content);
             }
             
             auto baselineEnd = std::chrono::high_resolution_clock::now();
@@ -793,7 +1487,7 @@ void compare_with_baseline(const std::vector<int>& operationCounts) {
                 privacyRouter.handle_data(data);
                 
                 Content content;
-                privacyRouter.serve_content(content);
+                privacyRouter.serve_content(interest.contentName, content);
             }
             
             auto privacyEnd = std::chrono::high_resolution_clock::now();
@@ -810,10 +1504,7 @@ void compare_with_baseline(const std::vector<int>& operationCounts) {
             double throughputOverhead = baselineThroughput / privacyThroughput;
             
             // Calculate average latencies
-            auto calcAvg = [](const std::vector<double>& latencies) {
-                return latencies.empty() ? 0.0 : 
-                       std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
-            };
+            auto calcAvg = [](const HdrHistogram& latencies) { return PerformanceMetrics::mean_us(latencies); };
             
             double baselineInterestLatency = calcAvg(baselineRouter.getMetrics().interestLatencies);
             double privacyInterestLatency = calcAvg(privacyRouter.getMetrics().interestLatencies);
@@ -961,7 +1652,7 @@ void run_operations_benchmark(const std::vector<int>& operationCounts) {
                         router.handle_data(data);
                         
                         Content content;
-                        router.serve_content(content);
+                        router.serve_content(interest.contentName, content);
                         
                         successfulOperations += 3; // Count all three operations
                     }
@@ -980,8 +1671,11 @@ void run_operations_benchmark(const std::vector<int>& operationCounts) {
                     }
                 }
                 
-                // Give background eviction thread a chance to run between batches
-                std::this_thread::sleep_for(std::chrono::milliseconds(25));
+                // Let the eviction scheduler catch up before the next batch,
+                // but only while it reports back-pressure
+                for (int waitMs = 0; waitMs < 25 && router.isBackPressured(); waitMs++) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
                 
                 // Force eviction between batches
                 try {
@@ -999,29 +1693,11 @@ void run_operations_benchmark(const std::vector<int>& operationCounts) {
             // Calculate metrics
             double throughput = successfulOperations / router.getMetrics().totalTimeSeconds;
             
-            double avgInterestLatency = 0.0;
-            if (!router.getMetrics().interestLatencies.empty()) {
-                avgInterestLatency = std::accumulate(
-                    router.getMetrics().interestLatencies.begin(),
-                    router.getMetrics().interestLatencies.end(), 0.0
-                ) / router.getMetrics().interestLatencies.size();
-            }
+            double avgInterestLatency = PerformanceMetrics::mean_us(router.getMetrics().interestLatencies);
             
-            double avgDataLatency = 0.0;
-            if (!router.getMetrics().dataLatencies.empty()) {
-                avgDataLatency = std::accumulate(
-                    router.getMetrics().dataLatencies.begin(),
-                    router.getMetrics().dataLatencies.end(), 0.0
-                ) / router.getMetrics().dataLatencies.size();
-            }
+            double avgDataLatency = PerformanceMetrics::mean_us(router.getMetrics().dataLatencies);
             
-            double avgRetrievalLatency = 0.0;
-            if (!router.getMetrics().retrievalLatencies.empty()) {
-                avgRetrievalLatency = std::accumulate(
-                    router.getMetrics().retrievalLatencies.begin(),
-                    router.getMetrics().retrievalLatencies.end(), 0.0
-                ) / router.getMetrics().retrievalLatencies.size();
-            }
+            double avgRetrievalLatency = PerformanceMetrics::mean_us(router.getMetrics().retrievalLatencies);
             
             size_t maxStashSize = router.getMetrics().maxStashSize;
             
@@ -1047,8 +1723,9 @@ void run_operations_benchmark(const std::vector<int>& operationCounts) {
                        << errorCount << "\n";
             
             // Save detailed metrics
-            std::string filename = "results/operations_" + std::to_string(opCount) + ".csv";
-            router.getMetrics().saveToCSV(filename);
+            std::string filename = "results/operations_" + std::to_string(opCount);
+            router.getMetrics().saveToCSV(filename + ".csv");
+            router.getMetrics().saveToJSON(filename + ".json");
             
         } catch (const std::exception& ex) {
             std::cerr << "FATAL ERROR with " << opCount << " operations: " << ex.what() << "\n";
@@ -1060,10 +1737,644 @@ void run_operations_benchmark(const std::vector<int>& operationCounts) {
     std::cout << "\nOperations benchmark complete. Results saved to operations_benchmark.csv\n";
 }
 
+// -------------------------
+// Throughput Scaling Benchmark
+// -------------------------
+// N load threads share one router and issue a Zipf-distributed mix of
+// interests, data and serves. Each (threads, namespace size) point gets a
+// fresh router; with config.numShards > 1 the FIB and PIT are sharded, so
+// threads contend per shard instead of per table.
+void run_scaling_benchmark(const ORAMConfig& config, const std::vector<int>& threadCounts,
+                           const std::vector<size_t>& namespaceSizes, int opsPerThread,
+                           const OperationMix& mix, double zipfExponent) {
+    std::cout << "\n=========== THROUGHPUT SCALING BENCHMARK ===========\n";
+    std::cout << "Config " << config.toString() << ", mix " << mix.toString()
+              << ", zipf s=" << zipfExponent << ", " << opsPerThread << " operations per thread\n";
+    
+    std::ofstream resultsFile("results/scaling_results.csv");
+    resultsFile << "Threads,NamespaceSize,ZipfExponent,Shards,Engine,Mix,Operations,TotalTimeSeconds,"
+                << "Throughput,Speedup,AvgInterestLatency,P99InterestLatency,AvgDataLatency,"
+                << "AvgRetrievalLatency,CSHitRate,MaxStashSize,Errors\n";
+    
+    for (size_t namespaceSize : namespaceSizes) {
+        ZipfWorkload workload(namespaceSize, zipfExponent);
+        double baseThroughput = 0;
+        
+        for (int threads : threadCounts) {
+            std::cout << "\nThreads=" << threads << ", namespace=" << namespaceSize << "\n";
+            try {
+                NDNRouter router(true, config);
+                std::atomic<bool> go(false);
+                std::atomic<uint64_t> issued(0);
+                std::atomic<uint64_t> errors(0);
+                int weightTotal = mix.interest + mix.data + mix.serve;
+                
+                std::vector<std::thread> workers;
+                for (int t = 0; t < threads; t++) {
+                    workers.emplace_back([&, t] {
+                        std::mt19937_64 rng(42 + t);
+                        std::uniform_int_distribution<int> pick(0, weightTotal - 1);
+                        DataPacket data;
+                        while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                        for (int i = 0; i < opsPerThread; i++) {
+                            try {
+                                int op = pick(rng);
+                                if (op < mix.interest) {
+                                    router.handle_interest(workload.generateInterest(rng));
+                                } else if (op < mix.interest + mix.data) {
+                                    std::uniform_int_distribution<int> sizeDist(100, 1000);
+                                    data.contentName = workload.sampleName(rng);
+                                    data.data.assign(sizeDist(rng), 'X');
+                                    router.handle_data(data);
+                                } else {
+                                    Content content;
+                                    router.serve_content(workload.sampleName(rng), content);
+                                }
+                                issued.fetch_add(1, std::memory_order_relaxed);
+                            } catch (const std::exception& ex) {
+                                if (errors.fetch_add(1) == 0) {
+                                    ORAM_ERROR("[Scaling] thread " << t << ": " << ex.what());
+                                }
+                            }
+                        }
+                    });
+                }
+                
+                router.startMetricCollection();
+                auto start = std::chrono::high_resolution_clock::now();
+                go.store(true, std::memory_order_release);
+                for (auto& worker : workers) worker.join();
+                auto end = std::chrono::high_resolution_clock::now();
+                std::chrono::duration<double> diff = end - start;
+                router.stopMetricCollection(diff.count());
+                
+                const PerformanceMetrics& m = router.getMetrics();
+                double throughput = issued.load() / diff.count();
+                if (baseThroughput == 0) baseThroughput = throughput;
+                double lookups = m.csHits + m.csMisses;
+                double hitRate = lookups > 0 ? m.csHits / lookups : 0.0;
+                
+                std::cout << "Throughput: " << throughput << " ops/sec (x"
+                          << throughput / baseThroughput << ")\n";
+                std::cout << "Avg Interest Latency: " << PerformanceMetrics::mean_us(m.interestLatencies)
+                          << " μs, p99 " << m.interestLatencies.percentile(0.99) / 1000.0 << " μs\n";
+                std::cout << "CS Hit Rate: " << hitRate * 100 << "%\n";
+                
+                resultsFile << threads << ","
+                           << namespaceSize << ","
+                           << zipfExponent << ","
+                           << config.numShards << ","
+                           << oram_engine_name(config.engine) << ","
+                           << mix.toString() << ","
+                           << issued.load() << ","
+                           << diff.count() << ","
+                           << throughput << ","
+                           << throughput / baseThroughput << ","
+                           << PerformanceMetrics::mean_us(m.interestLatencies) << ","
+                           << m.interestLatencies.percentile(0.99) / 1000.0 << ","
+                           << PerformanceMetrics::mean_us(m.dataLatencies) << ","
+                           << PerformanceMetrics::mean_us(m.retrievalLatencies) << ","
+                           << hitRate << ","
+                           << m.maxStashSize << ","
+                           << errors.load() << "\n";
+                
+                std::string filename = "results/scaling_t" + std::to_string(threads) +
+                                       "_n" + std::to_string(namespaceSize);
+                m.saveToCSV(filename + ".csv");
+                m.saveToJSON(filename + ".json");
+            } catch (const std::exception& ex) {
+                std::cerr << "ERROR with " << threads << " threads, namespace " << namespaceSize
+                          << ": " << ex.what() << "\n";
+                resultsFile << threads << "," << namespaceSize << "," << zipfExponent << ","
+                           << config.numShards << "," << oram_engine_name(config.engine) << ","
+                           << mix.toString() << ",ERROR: " << ex.what() << "\n";
+            }
+        }
+    }
+    
+    resultsFile.close();
+    std::cout << "\nScaling benchmark complete. Results saved to scaling_results.csv\n";
+}
+
+// -------------------------
+// Deferred Retrieval Benchmark
+// -------------------------
+// Feeds `arrivalsPerTick` interests per tick into a DeferredRetrieval stage
+// and hands each released round, padded with dummy interests, to the
+// router's batched interest path; the real interests of a round are then
+// answered with data and served as in the other benchmarks. The same
+// workload is first run packet by packet for comparison. Hold times are
+// reported separately from the (amortised) processing latency.
+void run_deferred_benchmark(const ORAMConfig& config, int numOperations,
+                            const DeferredRetrievalConfig& deferredConfig, size_t arrivalsPerTick) {
+    std::cout << "\n=========== DEFERRED RETRIEVAL BENCHMARK ===========\n";
+    std::cout << "Config " << config.toString() << ", rounds of " << deferredConfig.roundSize
+              << ", delay " << deferredConfig.minDelay << "-" << deferredConfig.maxDelay << " ticks, "
+              << arrivalsPerTick << " arrivals per tick, " << numOperations << " interests\n";
+    
+    std::ofstream resultsFile("results/deferred_results.csv");
+    resultsFile << "Mode,RoundSize,MinDelayTicks,MaxDelayTicks,ArrivalsPerTick,Interests,Throughput,"
+                << "AvgInterestLatency,P99InterestLatency,AvgHoldTicks,P99HoldTicks,AvgHoldUs,"
+                << "DummyFraction,Rounds,MaxStashSize,TotalTimeSeconds\n";
+    
+    auto serve = [](NDNRouter& router, WorkloadGenerator& workloadGen, const InterestPacket& interest) {
+        DataPacket data = workloadGen.generateData(interest.contentName);
+        router.handle_data(data);
+        Content content;
+        router.serve_content(interest.contentName, content);
+    };
+    
+    double directThroughput = 0;
+    try {
+        // Packet by packet, no holding
+        WorkloadGenerator workloadGen;
+        NDNRouter router(true, config);
+        auto start = std::chrono::high_resolution_clock::now();
+        router.startMetricCollection();
+        for (int i = 0; i < numOperations; i++) {
+            InterestPacket interest = workloadGen.generateInterest();
+            router.handle_interest(interest);
+            serve(router, workloadGen, interest);
+        }
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+        router.stopMetricCollection(diff.count());
+        
+        const PerformanceMetrics& m = router.getMetrics();
+        directThroughput = m.totalOperations / m.totalTimeSeconds;
+        std::cout << "Direct:   " << directThroughput << " ops/sec, interest latency "
+                  << PerformanceMetrics::mean_us(m.interestLatencies) << " μs\n";
+        resultsFile << "direct,1,0,0,1," << numOperations << "," << directThroughput << ","
+                    << PerformanceMetrics::mean_us(m.interestLatencies) << ","
+                    << m.interestLatencies.percentile(0.99) / 1000.0 << ",0,0,0,0,"
+                    << numOperations << "," << m.maxStashSize << "," << m.totalTimeSeconds << "\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "ERROR in direct run: " << ex.what() << "\n";
+        resultsFile << "direct,ERROR: " << ex.what() << "\n";
+    }
+    
+    try {
+        WorkloadGenerator workloadGen;
+        NDNRouter router(true, config);
+        DeferredRetrieval<InterestPacket> stage(deferredConfig);
+        uint64_t dummySeq = 0;
+        // '\x01' makes the names unroutable and distinct from real ones
+        auto makeDummy = [&dummySeq]() {
+            return InterestPacket{"/\x01" "dummy/" + std::to_string(dummySeq++), "dummy"};
+        };
+        auto release = [&](const std::vector<InterestPacket>& round, size_t real) {
+            router.handle_interests(round, round.size() - real);
+            for (size_t i = 0; i < real; i++) serve(router, workloadGen, round[i]);
+        };
+        
+        std::vector<InterestPacket> round;
+        int submitted = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        router.startMetricCollection();
+        while (submitted < numOperations) {
+            for (size_t a = 0; a < arrivalsPerTick && submitted < numOperations; a++, submitted++) {
+                stage.submit(workloadGen.generateInterest());
+            }
+            size_t real = stage.tick(round, makeDummy);
+            if (!round.empty()) release(round, real);
+        }
+        stage.flush(makeDummy, release);
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+        router.stopMetricCollection(diff.count());
+        
+        const PerformanceMetrics& m = router.getMetrics();
+        DeferredRetrievalStats s = stage.getStats();
+        double throughput = m.totalOperations / m.totalTimeSeconds;
+        double dummyFraction = s.dummies / static_cast<double>(std::max<uint64_t>(1, s.dummies + s.released));
+        std::cout << "Deferred: " << throughput << " ops/sec (x" << (directThroughput > 0 ? throughput / directThroughput : 0)
+                  << " vs direct), interest latency " << PerformanceMetrics::mean_us(m.interestLatencies) << " μs\n";
+        std::cout << "Hold: mean " << s.holdTicks.mean() << " ticks (p99 " << s.holdTicks.percentile(0.99)
+                  << "), " << s.holdNs.mean() / 1000.0 << " μs\n";
+        std::cout << "Rounds: " << s.rounds << ", dummy fraction " << dummyFraction * 100 << "%\n";
+        resultsFile << "deferred," << deferredConfig.roundSize << "," << deferredConfig.minDelay << ","
+                    << deferredConfig.maxDelay << "," << arrivalsPerTick << "," << numOperations << ","
+                    << throughput << ","
+                    << PerformanceMetrics::mean_us(m.interestLatencies) << ","
+                    << m.interestLatencies.percentile(0.99) / 1000.0 << ","
+                    << s.holdTicks.mean() << ","
+                    << s.holdTicks.percentile(0.99) << ","
+                    << s.holdNs.mean() / 1000.0 << ","
+                    << dummyFraction << ","
+                    << s.rounds << ","
+                    << m.maxStashSize << ","
+                    << m.totalTimeSeconds << "\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "ERROR in deferred run: " << ex.what() << "\n";
+        resultsFile << "deferred,ERROR: " << ex.what() << "\n";
+    }
+    
+    resultsFile.close();
+    std::cout << "\nDeferred retrieval benchmark complete. Results saved to deferred_results.csv\n";
+}
+
+// -------------------------
+// Pipelined Router Benchmark
+// -------------------------
+// Runs the interest/data/serve workload through the serial NDNRouter and
+// then through PipelinedNDNRouter, and reports per-stage occupancy (busy
+// time over stage lifetime) and input ring depth. The stage with the
+// highest occupancy bounds the pipeline's throughput.
+void run_pipeline_benchmark(const ORAMConfig& config, int numOperations) {
+    std::cout << "\n=========== PIPELINED ROUTER BENCHMARK ===========\n";
+    std::cout << "Config " << config.toString() << ", " << numOperations << " interest/data/serve rounds\n";
+    
+    std::ofstream resultsFile("results/pipeline_results.csv");
+    resultsFile << "Mode,Operations,Throughput,AvgInterestLatency,AvgDataLatency,AvgRetrievalLatency,"
+                << "P99InterestLatency,TotalTimeSeconds\n";
+    auto writeRow = [&resultsFile](const char* mode, const PerformanceMetrics& m) {
+        resultsFile << mode << "," << m.totalOperations << ","
+                    << m.totalOperations / m.totalTimeSeconds << ","
+                    << PerformanceMetrics::mean_us(m.interestLatencies) << ","
+                    << PerformanceMetrics::mean_us(m.dataLatencies) << ","
+                    << PerformanceMetrics::mean_us(m.retrievalLatencies) << ","
+                    << m.interestLatencies.percentile(0.99) / 1000.0 << ","
+                    << m.totalTimeSeconds << "\n";
+    };
+    
+    double serialThroughput = 0;
+    ConfigRun serial;
+    serial.config = config;
+    serial.operations = numOperations;
+    execute_config_run(serial, false);
+    if (serial.ok) {
+        serialThroughput = serial.throughput();
+        std::cout << "Serial:    " << serialThroughput << " ops/sec\n";
+        writeRow("serial", serial.metrics);
+    } else {
+        std::cerr << "ERROR in serial run: " << serial.error << "\n";
+        resultsFile << "serial,ERROR: " << serial.error << "\n";
+    }
+    
+    try {
+        WorkloadGenerator workloadGen;
+        PipelinedNDNRouter router(config);
+        using Kind = PipelinedNDNRouter::Kind;
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        router.start();
+        for (int i = 0; i < numOperations; i++) {
+            InterestPacket interest = workloadGen.generateInterest();
+            router.submit(Kind::Interest, interest.contentName, interest.consumerId);
+            DataPacket data = workloadGen.generateData(interest.contentName);
+            router.submit(Kind::Data, data.contentName, std::move(data.data));
+            router.submit(Kind::Serve, interest.contentName);
+        }
+        router.finish();
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+        PerformanceMetrics& m = router.getMetrics();
+        m.totalTimeSeconds = diff.count();
+        
+        double throughput = m.totalOperations / m.totalTimeSeconds;
+        std::cout << "Pipelined: " << throughput << " ops/sec (x"
+                  << (serialThroughput > 0 ? throughput / serialThroughput : 0) << " vs serial)";
+        if (router.getErrors()) std::cout << ", " << router.getErrors() << " errors";
+        std::cout << "\n";
+        writeRow("pipelined", m);
+        
+        std::ofstream stagesFile("results/pipeline_stages.csv");
+        stagesFile << "Stage,Packets,BusySeconds,Occupancy,MeanRingDepth,MaxRingDepth,EmptyPolls,FullPushes\n";
+        std::cout << std::left << std::setw(6) << "Stage" << std::right << std::setw(10) << "Packets"
+                  << std::setw(12) << "Occupancy" << std::setw(12) << "MeanDepth" << std::setw(10) << "MaxDepth" << "\n";
+        for (size_t i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+            PipelineStageId id = static_cast<PipelineStageId>(i);
+            const PipelineStageStats& s = router.getStageStats(id);
+            std::cout << std::left << std::setw(6) << pipeline_stage_name(id) << std::right
+                      << std::setw(10) << s.packets
+                      << std::setw(11) << s.occupancy() * 100 << "%"
+                      << std::setw(12) << s.meanDepth()
+                      << std::setw(10) << s.maxDepth << "\n";
+            stagesFile << pipeline_stage_name(id) << "," << s.packets << "," << s.busyNs / 1e9 << ","
+                       << s.occupancy() << "," << s.meanDepth() << "," << s.maxDepth << ","
+                       << s.emptyPolls << "," << s.fullPushes << "\n";
+        }
+        std::cout << "Bottleneck: " << pipeline_stage_name(router.bottleneck()) << " stage\n";
+        m.printOramPhases();
+    } catch (const std::exception& ex) {
+        std::cerr << "ERROR in pipelined run: " << ex.what() << "\n";
+        resultsFile << "pipelined,ERROR: " << ex.what() << "\n";
+    }
+    
+    resultsFile.close();
+    std::cout << "\nPipeline benchmark complete. Results saved to pipeline_results.csv and pipeline_stages.csv\n";
+}
+
+// -------------------------
+// Async Access Benchmark
+// -------------------------
+// The same stream of map operations (lookups, with every fourth an insert
+// of a fresh value) against one sharded map, issued by a single thread:
+// first blocking, one at a time, then through AsyncObliviousMap with up to
+// `inflight` operations outstanding on one strand per shard. `storagePath`
+// puts the trees in memory-mapped files, where path reads can fault.
+void run_async_benchmark(const ORAMConfig& config, int numOperations, size_t inflight) {
+    std::cout << "\n=========== ASYNC ACCESS BENCHMARK ===========\n";
+    std::cout << "Config " << config.toString() << ", " << numOperations << " operations, "
+              << inflight << " in flight\n";
+    
+    const size_t keySpace = 256;
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < keySpace; i++) keys.push_back("/async/key" + std::to_string(i));
+    std::vector<size_t> picks(numOperations);
+    std::mt19937 rng(42);
+    for (auto& pick : picks) pick = rng() % keySpace;
+    
+    std::ofstream resultsFile("results/async_results.csv");
+    resultsFile << "Mode,Operations,InFlight,Strands,Throughput,TotalTimeSeconds,Mismatches\n";
+    
+    double blockingThroughput = 0;
+    for (bool async : {false, true}) {
+        const char* label = async ? "async" : "blocking";
+        try {
+            std::unique_ptr<MappedStorageConfig> storage;
+            if (!config.storagePath.empty()) {
+                storage.reset(new MappedStorageConfig());
+                storage->path = config.storagePath + "." + label;
+            }
+            ShardedObliviousMap<std::string, std::string> map(config.numShards, config.treeHeight, config.stashLimit,
+                                                             config.bucketCapacity, SHARD_COVER_ACCESSES_DEFAULT,
+                                                             config.evictionMode, config.engine, storage.get(),
+                                                             config.hashedKeys, table_autotune(config));
+            std::vector<std::pair<std::string, std::string>> initial;
+            for (const auto& key : keys) initial.emplace_back(key, key + "#0");
+            std::sort(initial.begin(), initial.end());
+            map.bulk_load(initial);
+            
+            // Last value written per key: a lookup must see every earlier insert
+            std::vector<int> version(keySpace, 0);
+            int mismatches = 0;
+            auto current = [&](size_t pick) { return keys[pick] + "#" + std::to_string(version[pick]); };
+            
+            OramStrandPool pool(async ? map.getShardCount() : 1);
+            AsyncObliviousMap<std::string, std::string, ShardedObliviousMap<std::string, std::string>> asyncMap(
+                map, pool, [&map](const std::string& key) { return map.shard_index(key); });
+            std::deque<std::pair<std::string, std::future<AsyncResult<std::string>>>> lookups;  // expected value, result
+            std::deque<std::future<void>> inserts;
+            auto settle = [&](size_t limit) {
+                while (lookups.size() + inserts.size() > limit) {
+                    if (!inserts.empty()) {
+                        inserts.front().get();
+                        inserts.pop_front();
+                    } else {
+                        AsyncResult<std::string> r = lookups.front().second.get();
+                        if (!r.found || r.value != lookups.front().first) mismatches++;
+                        lookups.pop_front();
+                    }
+                }
+            };
+            
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < numOperations; i++) {
+                size_t pick = picks[i];
+                if (i % 4 == 3) {
+                    version[pick]++;
+                    std::string value = current(pick);
+                    if (async) inserts.push_back(asyncMap.async_insert(keys[pick], value));
+                    else map.oblivious_insert(keys[pick], value);
+                } else if (async) {
+                    lookups.emplace_back(current(pick), asyncMap.async_lookup(keys[pick]));
+                } else {
+                    std::string value;
+                    if (!map.oblivious_lookup(keys[pick], value) || value != current(pick)) mismatches++;
+                }
+                settle(async ? inflight : 0);
+            }
+            settle(0);
+            std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+            
+            // Per-key order: every key must now hold its last written value
+            for (size_t k = 0; k < keySpace; k++) {
+                std::string value;
+                if (!map.oblivious_lookup(keys[k], value) || value != current(k)) mismatches++;
+            }
+            
+            double throughput = numOperations / diff.count();
+            if (!async) blockingThroughput = throughput;
+            std::cout << std::left << std::setw(10) << label << std::right << throughput << " ops/sec";
+            if (async && blockingThroughput > 0) std::cout << " (x" << throughput / blockingThroughput << " vs blocking)";
+            if (mismatches) std::cout << ", " << mismatches << " mismatches";
+            std::cout << "\n";
+            resultsFile << label << "," << numOperations << "," << (async ? inflight : 1) << "," << pool.size() << ","
+                        << throughput << "," << diff.count() << "," << mismatches << "\n";
+        } catch (const std::exception& ex) {
+            std::cerr << "ERROR in " << label << " run: " << ex.what() << "\n";
+            resultsFile << label << ",ERROR: " << ex.what() << "\n";
+        }
+    }
+    
+    resultsFile.close();
+    std::cout << "\nAsync benchmark complete. Results saved to async_results.csv\n";
+}
+
+// Parses a comma-separated list of positive integers ("1,2,4,8").
+template<typename T>
+std::vector<T> parse_count_list(const std::string& text, const char* what) {
+    std::vector<T> values;
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        long long v = std::stoll(item);
+        if (v <= 0) throw std::invalid_argument(std::string(what) + " must be positive");
+        values.push_back(static_cast<T>(v));
+    }
+    if (values.empty()) throw std::invalid_argument(std::string(what) + " list is empty");
+    return values;
+}
+
+// -------------------------
+// Configuration Sweep
+// -------------------------
+// Grid of map configurations to sweep, one value list per axis:
+//   "h=4,5,6 b=4,8 s=100,200 ops=1000"
+// Axes are separated by spaces, semicolons or newlines; "@file" reads the
+// spec from a file, where '#' starts a comment. Omitted axes keep their
+// default. Queues follow the custom-mode convention (height h-1, bucket
+// capacity 2b, stash limit s).
+struct SweepGrid {
+    std::vector<int> heights = {4, 5, 6, 7};
+    std::vector<int> bucketCapacities = {2, 4, 8, 16};
+    std::vector<size_t> stashLimits = {STASH_LIMIT_DEFAULT};
+    std::vector<int> operationCounts = {1000};
+    
+    static SweepGrid parse(const std::string& spec) {
+        std::string text = spec;
+        if (!text.empty() && text[0] == '@') {
+            std::ifstream file(text.substr(1));
+            if (!file) throw std::invalid_argument("Cannot read sweep grid file " + text.substr(1));
+            std::stringstream contents;
+            std::string line;
+            while (std::getline(file, line)) contents << line.substr(0, line.find('#')) << "\n";
+            text = contents.str();
+        }
+        std::replace(text.begin(), text.end(), ';', ' ');
+        
+        SweepGrid grid;
+        std::istringstream in(text);
+        std::string axis;
+        while (in >> axis) {
+            size_t eq = axis.find('=');
+            if (eq == std::string::npos) throw std::invalid_argument("Sweep axis needs name=values: " + axis);
+            std::string name = axis.substr(0, eq);
+            std::string values = axis.substr(eq + 1);
+            if (name == "h") grid.heights = parse_count_list<int>(values, "Tree height");
+            else if (name == "b") grid.bucketCapacities = parse_count_list<int>(values, "Bucket capacity");
+            else if (name == "s") grid.stashLimits = parse_count_list<size_t>(values, "Stash limit");
+            else if (name == "ops") grid.operationCounts = parse_count_list<int>(values, "Operation count");
+            else throw std::invalid_argument("Unknown sweep axis: " + name);
+        }
+        return grid;
+    }
+    
+    size_t points() const {
+        return heights.size() * bucketCapacities.size() * stashLimits.size() * operationCounts.size();
+    }
+};
+
+// Two-sided 95% Student t critical value for `df` degrees of freedom.
+double t_critical_95(size_t df) {
+    static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df == 0) return 0.0;
+    return df <= 30 ? table[df - 1] : 1.960;
+}
+
+// Mean, sample standard deviation and 95% confidence half-width.
+struct SampleSummary {
+    double mean = 0;
+    double stddev = 0;
+    double ci95 = 0;
+    
+    explicit SampleSummary(const std::vector<double>& samples) {
+        if (samples.empty()) return;
+        mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+        if (samples.size() < 2) return;
+        double squares = 0;
+        for (double v : samples) squares += (v - mean) * (v - mean);
+        stddev = std::sqrt(squares / (samples.size() - 1));
+        ci95 = t_critical_95(samples.size() - 1) * stddev / std::sqrt(static_cast<double>(samples.size()));
+    }
+};
+
+// Runs every grid point `repeats` times on `workers` pinned threads. Repeat
+// r of every point uses workload seed 42 + r, so points are compared on the
+// same packet streams. Writes each run to results/sweep_runs.csv and the
+// per-point means to results/sweep_results.csv, whose leading columns match
+// config_benchmark_results.csv so performance_visualizer.py reads both.
+void run_configuration_sweep(const SweepGrid& grid, int workers, int repeats) {
+    std::cout << "\n=========== CONFIGURATION SWEEP ===========\n";
+    std::cout << grid.points() << " grid points x " << repeats << " repeats on " << workers << " workers\n";
+    
+    std::vector<ConfigRun> runs;
+    for (int ops : grid.operationCounts) {
+        for (int height : grid.heights) {
+            for (int capacity : grid.bucketCapacities) {
+                for (size_t stashLimit : grid.stashLimits) {
+                    for (int r = 0; r < repeats; r++) {
+                        ConfigRun run;
+                        run.config = ORAMConfig(height, capacity, stashLimit, height > 1 ? height - 1 : 1,
+                                                capacity * 2, stashLimit);
+                        run.operations = ops;
+                        run.seed = 42 + r;
+                        runs.push_back(std::move(run));
+                    }
+                }
+            }
+        }
+    }
+    
+    size_t finished = 0;
+    auto start = std::chrono::steady_clock::now();
+    execute_config_runs(runs, workers, [&](size_t i) {
+        finished++;
+        std::cout << "[" << finished << "/" << runs.size() << "] " << runs[i].config.toString()
+                  << " ops=" << runs[i].operations << " seed=" << runs[i].seed << ": ";
+        if (runs[i].ok) std::cout << runs[i].throughput() << " ops/sec\n";
+        else std::cout << "ERROR: " << runs[i].error << "\n";
+    });
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    
+    auto configColumns = [](std::ostream& out, const ORAMConfig& c) {
+        out << c.treeHeight << "," << c.bucketCapacity << "," << c.stashLimit << ","
+            << c.queueTreeHeight << "," << c.queueBucketCapacity << "," << c.queueStashLimit << ",";
+    };
+    
+    std::ofstream runsFile("results/sweep_runs.csv");
+    runsFile << "TreeHeight,BucketCapacity,StashLimit,QueueTreeHeight,QueueBucketCapacity,QueueStashLimit,"
+             << "Operations,Seed,Throughput,AvgInterestLatency,AvgDataLatency,AvgRetrievalLatency,"
+             << "MaxStashSize,TotalTimeSeconds\n";
+    for (const ConfigRun& run : runs) {
+        configColumns(runsFile, run.config);
+        runsFile << run.operations << "," << run.seed << ",";
+        if (!run.ok) {
+            runsFile << "ERROR: " << run.error << "\n";
+            continue;
+        }
+        const PerformanceMetrics& m = run.metrics;
+        runsFile << run.throughput() << ","
+                 << PerformanceMetrics::mean_us(m.interestLatencies) << ","
+                 << PerformanceMetrics::mean_us(m.dataLatencies) << ","
+                 << PerformanceMetrics::mean_us(m.retrievalLatencies) << ","
+                 << m.maxStashSize << ","
+                 << m.totalTimeSeconds << "\n";
+    }
+    
+    std::ofstream resultsFile("results/sweep_results.csv");
+    resultsFile << "TreeHeight,BucketCapacity,StashLimit,QueueTreeHeight,QueueBucketCapacity,QueueStashLimit,"
+                << "Throughput,AvgInterestLatency,AvgDataLatency,AvgRetrievalLatency,MaxStashSize,TotalTimeSeconds,"
+                << "Operations,Runs,ThroughputStddev,ThroughputCI95,AvgInterestLatencyCI95\n";
+    for (size_t first = 0; first < runs.size(); first += repeats) {
+        std::vector<double> throughput, interest, data, retrieval, seconds;
+        size_t maxStash = 0;
+        std::string error;
+        for (size_t i = first; i < first + repeats; i++) {
+            const ConfigRun& run = runs[i];
+            if (!run.ok) {
+                error = run.error;
+                continue;
+            }
+            throughput.push_back(run.throughput());
+            interest.push_back(PerformanceMetrics::mean_us(run.metrics.interestLatencies));
+            data.push_back(PerformanceMetrics::mean_us(run.metrics.dataLatencies));
+            retrieval.push_back(PerformanceMetrics::mean_us(run.metrics.retrievalLatencies));
+            seconds.push_back(run.metrics.totalTimeSeconds);
+            maxStash = std::max(maxStash, run.metrics.maxStashSize);
+        }
+        
+        configColumns(resultsFile, runs[first].config);
+        if (throughput.empty()) {
+            resultsFile << "ERROR: " << error << "\n";
+            continue;
+        }
+        SampleSummary t(throughput), lat(interest);
+        resultsFile << t.mean << ","
+                    << lat.mean << ","
+                    << SampleSummary(data).mean << ","
+                    << SampleSummary(retrieval).mean << ","
+                    << maxStash << ","
+                    << SampleSummary(seconds).mean << ","
+                    << runs[first].operations << ","
+                    << throughput.size() << ","
+                    << t.stddev << ","
+                    << t.ci95 << ","
+                    << lat.ci95 << "\n";
+    }
+    
+    std::cout << "\nSweep complete in " << wall.count() << " s. Results saved to sweep_results.csv "
+              << "(per-run rows in sweep_runs.csv)\n";
+}
+
 // -------------------------
 // Main Function: Dispatch based on Command-line Argument
 // -------------------------
 int main(int argc, char* argv[]) {
+    // Per-packet router logs are DEBUG and compiled out by default;
+    // ORAM_LOG / ORAM_LOG_SINK select the runtime level and sink
+    OramLog::configure_from_env();
+    
     // Setup default operational parameters
     std::vector<int> defaultOperationCounts = {100, 500, 1000, 5000, 10000};    
     int defaultConfigTestOperations = 1000;
@@ -1099,8 +2410,10 @@ int main(int argc, char* argv[]) {
             configs.push_back(ORAMConfig(TREE_HEIGHT_DEFAULT, BUCKET_CAPACITY_DEFAULT, 200, QUEUE_TREE_HEIGHT_DEFAULT, QUEUE_BUCKET_CAPACITY_DEFAULT, 200));
             configs.push_back(ORAMConfig(TREE_HEIGHT_DEFAULT, BUCKET_CAPACITY_DEFAULT, 500, QUEUE_TREE_HEIGHT_DEFAULT, QUEUE_BUCKET_CAPACITY_DEFAULT, 500));
             
-            // Run tests with these configurations
-            run_configuration_benchmark(configs, defaultConfigTestOperations);
+            // Run tests with these configurations; parallel workers are opt-in,
+            // since concurrent runs share caches and memory bandwidth
+            int workers = argc > 2 ? std::stoi(argv[2]) : 1;
+            run_configuration_benchmark(configs, defaultConfigTestOperations, workers);
             return 0;
         }
         else if (mode == "comparison") {
@@ -1136,8 +2449,10 @@ int main(int argc, char* argv[]) {
             configs.push_back(ORAMConfig(TREE_HEIGHT_DEFAULT, BUCKET_CAPACITY_DEFAULT, 200, QUEUE_TREE_HEIGHT_DEFAULT, QUEUE_BUCKET_CAPACITY_DEFAULT, 200));
             configs.push_back(ORAMConfig(TREE_HEIGHT_DEFAULT, BUCKET_CAPACITY_DEFAULT, 500, QUEUE_TREE_HEIGHT_DEFAULT, QUEUE_BUCKET_CAPACITY_DEFAULT, 500));
             
-            // Run tests with these configurations
-            run_configuration_benchmark(configs, defaultConfigTestOperations);
+            // Run tests with these configurations; parallel workers are opt-in,
+            // since concurrent runs share caches and memory bandwidth
+            int workers = argc > 2 ? std::stoi(argv[2]) : 1;
+            run_configuration_benchmark(configs, defaultConfigTestOperations, workers);
             
             // Compare with baseline
             compare_with_baseline(defaultOperationCounts);
@@ -1148,7 +2463,7 @@ int main(int argc, char* argv[]) {
         else if (mode == "custom") {
             if (argc < 6) {
                 std::cerr << "Custom mode requires at least 5 arguments:\n";
-                std::cerr << "tree-test custom <tree_height> <bucket_capacity> <stash_limit> <num_operations>\n";
+                std::cerr << "tree-test custom <tree_height> <bucket_capacity> <stash_limit> <num_operations> [shards] [burst] [heuristic|bounded] [path|ring] [storage_prefix] [names|hashed] [fixed|autotune] [hash|compact|recursive]\n";
                 return 1;
             }
             
@@ -1156,6 +2471,61 @@ int main(int argc, char* argv[]) {
             int bucketCapacity = std::stoi(argv[3]);
             int stashLimit = std::stoi(argv[4]);
             int numOperations = std::stoi(argv[5]);
+            int numShards = argc > 6 ? std::stoi(argv[6]) : SHARD_COUNT_DEFAULT;
+            int burst = argc > 7 ? std::stoi(argv[7]) : 1;
+            EvictionMode eviction = EvictionMode::Heuristic;
+            if (argc > 8) {
+                std::string evictArg = argv[8];
+                if (evictArg == "bounded") {
+                    eviction = EvictionMode::Bounded;
+                } else if (evictArg != "heuristic") {
+                    std::cerr << "Unknown eviction mode: " << evictArg << "\n";
+                    return 1;
+                }
+            }
+            OramEngine engine = OramEngine::Path;
+            if (argc > 9) {
+                std::string engineArg = argv[9];
+                if (engineArg == "ring") {
+                    engine = OramEngine::Ring;
+                } else if (engineArg != "path") {
+                    std::cerr << "Unknown ORAM engine: " << engineArg << "\n";
+                    return 1;
+                }
+            }
+            std::string storagePath = argc > 10 ? argv[10] : "";
+            bool hashedKeys = false;
+            if (argc > 11) {
+                std::string keyArg = argv[11];
+                if (keyArg == "hashed") {
+                    hashedKeys = true;
+                } else if (keyArg != "names") {
+                    std::cerr << "Unknown key mode: " << keyArg << "\n";
+                    return 1;
+                }
+            }
+            bool autotune = false;
+            if (argc > 12) {
+                std::string tuneArg = argv[12];
+                if (tuneArg == "autotune") {
+                    autotune = true;
+                } else if (tuneArg != "fixed") {
+                    std::cerr << "Unknown sizing mode: " << tuneArg << "\n";
+                    return 1;
+                }
+            }
+            PositionMapKind posmap = PositionMapKind::Hash;
+            if (argc > 13) {
+                std::string posmapArg = argv[13];
+                if (posmapArg == "compact") {
+                    posmap = PositionMapKind::Compact;
+                } else if (posmapArg == "recursive") {
+                    posmap = PositionMapKind::Recursive;
+                } else if (posmapArg != "hash") {
+                    std::cerr << "Unknown position map: " << posmapArg << "\n";
+                    return 1;
+                }
+            }
             
             // Create custom configuration
             ORAMConfig customConfig(
@@ -1164,13 +2534,77 @@ int main(int argc, char* argv[]) {
                 stashLimit, 
                 treeHeight > 1 ? treeHeight - 1 : 1,  // Queue height is one less than map height
                 bucketCapacity * 2,  // Queue bucket capacity is double the map bucket capacity
-                stashLimit
+                stashLimit,
+                numShards,
+                burst,
+                eviction,
+                engine,
+                storagePath,
+                hashedKeys,
+                autotune,
+                posmap
             );
             
             std::vector<ORAMConfig> configs = {customConfig};
             run_configuration_benchmark(configs, numOperations);
             return 0;
         }
+        else if (mode == "scaling") {
+            // Threads and namespace sizes are comma-separated lists
+            std::vector<int> threadCounts = parse_count_list<int>(argc > 2 ? argv[2] : "1,2,4,8", "Thread count");
+            std::vector<size_t> namespaceSizes =
+                parse_count_list<size_t>(argc > 3 ? argv[3] : "10,100,1000", "Namespace size");
+            int opsPerThread = argc > 4 ? std::stoi(argv[4]) : 1000;
+            int numShards = argc > 5 ? std::stoi(argv[5]) : SHARD_COUNT_DEFAULT;
+            OperationMix mix = argc > 6 ? OperationMix::parse(argv[6]) : OperationMix();
+            double zipfExponent = argc > 7 ? std::stod(argv[7]) : 1.0;
+            
+            ORAMConfig scalingConfig;
+            scalingConfig.numShards = numShards;
+            run_scaling_benchmark(scalingConfig, threadCounts, namespaceSizes, opsPerThread, mix, zipfExponent);
+            return 0;
+        }
+        else if (mode == "pipeline") {
+            int numOperations = argc > 2 ? std::stoi(argv[2]) : 1000;
+            ORAMConfig pipelineConfig;
+            if (argc > 3) pipelineConfig.numShards = std::stoi(argv[3]);
+            run_pipeline_benchmark(pipelineConfig, numOperations);
+            return 0;
+        }
+        else if (mode == "async") {
+            int numOperations = argc > 2 ? std::stoi(argv[2]) : 1000;
+            ORAMConfig asyncConfig;
+            asyncConfig.numShards = argc > 3 ? std::stoi(argv[3]) : 4;
+            size_t inflight = argc > 4 ? std::stoul(argv[4]) : 64;
+            if (argc > 5) asyncConfig.treeHeight = std::stoi(argv[5]);
+            if (argc > 6) asyncConfig.storagePath = argv[6];
+            run_async_benchmark(asyncConfig, numOperations, inflight);
+            return 0;
+        }
+        else if (mode == "deferred") {
+            int numOperations = argc > 2 ? std::stoi(argv[2]) : 1000;
+            DeferredRetrievalConfig deferredConfig;
+            if (argc > 3) deferredConfig.roundSize = std::stoul(argv[3]);
+            if (argc > 4) deferredConfig.maxDelay = std::stoul(argv[4]);
+            size_t arrivalsPerTick = argc > 5 ? std::stoul(argv[5]) : deferredConfig.roundSize;
+            if (numOperations <= 0 || arrivalsPerTick == 0) {
+                std::cerr << "Deferred operations and arrivals per tick must be positive\n";
+                return 1;
+            }
+            run_deferred_benchmark(ORAMConfig(), numOperations, deferredConfig, arrivalsPerTick);
+            return 0;
+        }
+        else if (mode == "sweep") {
+            SweepGrid grid = argc > 2 ? SweepGrid::parse(argv[2]) : SweepGrid();
+            int workers = argc > 3 ? std::stoi(argv[3]) : default_sweep_workers();
+            int repeats = argc > 4 ? std::stoi(argv[4]) : 3;
+            if (workers <= 0 || repeats <= 0) {
+                std::cerr << "Sweep workers and repeats must be positive\n";
+                return 1;
+            }
+            run_configuration_sweep(grid, workers, repeats);
+            return 0;
+        }
         else {
             std::cerr << "Unknown mode: " << mode << "\n";
         }
@@ -1181,14 +2615,47 @@ int main(int argc, char* argv[]) {
     std::cout << "Modes:\n";
     std::cout << "  operations       - Test with different operation counts (" 
               << defaultOperationCounts.front() << "-" << defaultOperationCounts.back() << ")\n";
-    std::cout << "  configurations   - Test with different ORAM configurations\n";
+    std::cout << "  configurations [w] - Test with different ORAM configurations on [w] workers (default 1)\n";
     std::cout << "  comparison       - Compare with baseline implementation\n";
-    std::cout << "  full             - Run all benchmark tests\n";
-    std::cout << "  custom <th> <bc> <sl> <ops> - Run with custom parameters:\n";
+    std::cout << "  full [w]         - Run all benchmark tests, configurations on [w] workers (default 1)\n";
+    std::cout << "  custom <th> <bc> <sl> <ops> [p] [burst] [evict] [engine] [store] [keys] [tune] [posmap] - Run with custom parameters:\n";
     std::cout << "                    <th>: Tree height\n";
     std::cout << "                    <bc>: Bucket capacity\n";
     std::cout << "                    <sl>: Stash limit\n";
     std::cout << "                    <ops>: Number of operations\n";
+    std::cout << "                    [p]: FIB/PIT shard count (default 1)\n";
+    std::cout << "                    [burst]: Interests per batched burst (default 1)\n";
+    std::cout << "                    [evict]: heuristic (default) or bounded eviction\n";
+    std::cout << "                    [engine]: path (default) or ring ORAM for FIB/PIT\n";
+    std::cout << "                    [store]: file prefix for memory-mapped FIB/PIT trees (path engine)\n";
+    std::cout << "                    [keys]: names (default) or hashed 128-bit name keys for FIB/PIT\n";
+    std::cout << "                    [tune]: fixed (default) or autotune, growing FIB/PIT trees from <th> under load\n";
+    std::cout << "                    [posmap]: hash (default), compact or recursive position map (path engine)\n";
+    std::cout << "  scaling [threads] [names] [ops] [p] [mix] [s] - Throughput vs. threads and namespace size:\n";
+    std::cout << "                    [threads]: comma-separated load thread counts (default 1,2,4,8)\n";
+    std::cout << "                    [names]: comma-separated Zipf namespace sizes (default 10,100,1000)\n";
+    std::cout << "                    [ops]: Operations per thread (default 1000)\n";
+    std::cout << "                    [p]: FIB/PIT shard count (default 1)\n";
+    std::cout << "                    [mix]: interest:data:serve weights (default 50:30:20)\n";
+    std::cout << "                    [s]: Zipf exponent (default 1.0)\n";
+    std::cout << "  pipeline [ops] [p] - Serial vs. pipelined router (one thread per table, SPSC rings):\n";
+    std::cout << "                    [ops]: Interest/data/serve rounds (default 1000)\n";
+    std::cout << "                    [p]: FIB/PIT shard count (default 1)\n";
+    std::cout << "  async [ops] [p] [n] [h] [store] - Blocking vs. future-based map access from one thread:\n";
+    std::cout << "                    [ops]: Map operations (default 1000)\n";
+    std::cout << "                    [p]: Shards, one strand each (default 4)\n";
+    std::cout << "                    [n]: Operations kept in flight (default 64)\n";
+    std::cout << "                    [h]: Tree height (default " << TREE_HEIGHT_DEFAULT << ")\n";
+    std::cout << "                    [store]: file prefix for memory-mapped trees (default: in RAM)\n";
+    std::cout << "  deferred [ops] [round] [delay] [rate] - Deferred retrieval vs. per-packet handling:\n";
+    std::cout << "                    [ops]: Number of interests (default 1000)\n";
+    std::cout << "                    [round]: Interests per released round, dummies included (default 8)\n";
+    std::cout << "                    [delay]: Maximum hold in ticks; the minimum is 1 (default 8)\n";
+    std::cout << "                    [rate]: Interest arrivals per tick (default: round size)\n";
+    std::cout << "  sweep [grid] [w] [r] - Parallel grid sweep with repeated runs:\n";
+    std::cout << "                    [grid]: \"h=4,5 b=4,8 s=100 ops=1000\" or @file (default h=4..7 b=2..16)\n";
+    std::cout << "                    [w]: worker threads, one pinned per core (default: all cores)\n";
+    std::cout << "                    [r]: runs per grid point for 95% confidence intervals (default 3)\n";
     
     return 1;
 };